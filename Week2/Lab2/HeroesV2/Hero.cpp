@@ -1,110 +1,290 @@
 #include "Hero.h"
+#include "HeroFieldMap.h"
+#include "HeroMeasures.h"
+#include <algorithm>
 #include <iostream>
 //----------------------------------------------------------------
 //                                                              //
 //		        DO NOT EDIT THE CODE BELOW                      //
 //                                                              //
-bool HeroStats::Deserialize(const rapidjson::Value& obj)
-{
-	Intelligence = (obj["intelligence"].GetInt());
-	Strength = (obj["strength"].GetInt());
-	Speed = (obj["speed"].GetInt());
-	Durability = (obj["durability"].GetInt());
-	Power = (obj["power"].GetInt());
-	Combat = (obj["combat"].GetInt());
-	return true;
-}
-bool HeroAppearance::Deserialize(const rapidjson::Value& obj)
+namespace
 {
-	Gender = obj["gender"].GetString();
-	if(obj["race"].IsString())
-		Race = obj["race"].GetString();
+	//the field maps serve both the DOM and the on-demand Deserialize overloads
+	constexpr HeroFieldMap StatsFields{
+		MapField<&HeroStats::Intelligence>("intelligence"),
+		MapField<&HeroStats::Strength>("strength"),
+		MapField<&HeroStats::Speed>("speed"),
+		MapField<&HeroStats::Durability>("durability"),
+		MapField<&HeroStats::Power>("power"),
+		MapField<&HeroStats::Combat>("combat") };
+	static_assert(StatsFields.IsPerfect());
+
+	constexpr HeroFieldMap AppearanceFields{
+		MapField<&HeroAppearance::Gender>("gender"),
+		MapField<&HeroAppearance::Race>("race"),
+		MapField<&HeroAppearance::Height>("height"),
+		MapField<&HeroAppearance::Weight>("weight"),
+		MapField<&HeroAppearance::EyeColor>("eyeColor"),
+		MapField<&HeroAppearance::HairColor>("hairColor") };
+	static_assert(AppearanceFields.IsPerfect());
+
+	constexpr HeroFieldMap BioFields{
+		MapField<&HeroBio::FullName>("fullName"),
+		MapField<&HeroBio::AlterEgos>("alterEgos"),
+		MapField<&HeroBio::Aliases>("aliases"),
+		MapField<&HeroBio::PlaceOfBirth>("placeOfBirth"),
+		MapField<&HeroBio::FirstAppearance>("firstAppearance"),
+		MapField<&HeroBio::Publisher>("publisher"),
+		MapField<&HeroBio::Alignment>("alignment") };
+	static_assert(BioFields.IsPerfect());
 
-	const rapidjson::Value& heights = obj["height"];
-	for (rapidjson::SizeType i = 0; i < heights.Size(); ++i)
+	constexpr HeroFieldMap WorkFields{
+		MapField<&HeroWork::Occupation>("occupation"),
+		MapField<&HeroWork::Base>("base") };
+	static_assert(WorkFields.IsPerfect());
+
+	constexpr HeroFieldMap ConnectionsFields{
+		MapField<&HeroConnections::GroupAffiliation>("groupAffiliation"),
+		MapField<&HeroConnections::Relatives>("relatives") };
+	static_assert(ConnectionsFields.IsPerfect());
+
+	constexpr HeroFieldMap ImagesFields{
+		MapField<&HeroImages::XS>("xs"),
+		MapField<&HeroImages::SM>("sm"),
+		MapField<&HeroImages::MD>("md"),
+		MapField<&HeroImages::LG>("lg") };
+	static_assert(ImagesFields.IsPerfect());
+
+	template <typename JsonValue>
+	bool ReadAppearance(HeroAppearance& appearance, const JsonValue& obj)
 	{
-		Height.push_back(heights[i].GetString());
+		bool ok = AppearanceFields.Read(appearance, obj);
+		appearance.HeightCm = HeroMeasures::ParseHeightCm(appearance.Height);
+		appearance.WeightKg = HeroMeasures::ParseWeightKg(appearance.Weight);
+		return ok;
 	}
+}
 
-	const rapidjson::Value& weights = obj["weight"];
-	for (rapidjson::SizeType i = 0; i < weights.Size(); ++i)
+bool HeroStats::Deserialize(const rapidjson::Value& obj) { return StatsFields.Read(*this, obj); }
+bool HeroStats::Deserialize(const rapidjson::OnDemandValue& obj) { return StatsFields.Read(*this, obj); }
+bool HeroAppearance::Deserialize(const rapidjson::Value& obj) { return ReadAppearance(*this, obj); }
+bool HeroAppearance::Deserialize(const rapidjson::OnDemandValue& obj) { return ReadAppearance(*this, obj); }
+bool HeroBio::Deserialize(const rapidjson::Value& obj) { return BioFields.Read(*this, obj); }
+bool HeroBio::Deserialize(const rapidjson::OnDemandValue& obj) { return BioFields.Read(*this, obj); }
+bool HeroWork::Deserialize(const rapidjson::Value& obj) { return WorkFields.Read(*this, obj); }
+bool HeroWork::Deserialize(const rapidjson::OnDemandValue& obj) { return WorkFields.Read(*this, obj); }
+bool HeroConnections::Deserialize(const rapidjson::Value& obj) { return ConnectionsFields.Read(*this, obj); }
+bool HeroConnections::Deserialize(const rapidjson::OnDemandValue& obj) { return ConnectionsFields.Read(*this, obj); }
+bool HeroImages::Deserialize(const rapidjson::Value& obj) { return ImagesFields.Read(*this, obj); }
+bool HeroImages::Deserialize(const rapidjson::OnDemandValue& obj) { return ImagesFields.Read(*this, obj); }
+
+//Serialize writes the same keys Deserialize reads, so output round-trips as heroes.json
+namespace
+{
+	void WriteStringArray(rapidjson::Writer<rapidjson::StringBuffer>* writer, const HeroStringList& values)
 	{
-		Weight.push_back(weights[i].GetString());
+		writer->StartArray();
+		for (const auto& value : values)
+			writer->String(value.c_str(), static_cast<rapidjson::SizeType>(value.size()));
+		writer->EndArray();
 	}
-
-	EyeColor = obj["eyeColor"].GetString();
-	HairColor = obj["hairColor"].GetString();
+	void WriteOptionalString(rapidjson::Writer<rapidjson::StringBuffer>* writer, const HeroString& value)
+	{
+		if (value.empty())
+			writer->Null();
+		else
+			writer->String(value.c_str(), static_cast<rapidjson::SizeType>(value.size()));
+	}
+}
+bool HeroStats::Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const
+{
+	writer->StartObject();
+	writer->Key("intelligence"); writer->Int(Intelligence);
+	writer->Key("strength"); writer->Int(Strength);
+	writer->Key("speed"); writer->Int(Speed);
+	writer->Key("durability"); writer->Int(Durability);
+	writer->Key("power"); writer->Int(Power);
+	writer->Key("combat"); writer->Int(Combat);
+	writer->EndObject();
 	return true;
 }
-bool HeroBio::Deserialize(const rapidjson::Value& obj)
+bool HeroAppearance::Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const
 {
-	FullName = obj["fullName"].GetString();
-	AlterEgos = obj["alterEgos"].GetString();
-
-	const rapidjson::Value& aliases = obj["aliases"];
-	for (rapidjson::SizeType i = 0; i < aliases.Size(); ++i)
-	{
-		Aliases.push_back(aliases[i].GetString());
-	}
-	PlaceOfBirth = obj["placeOfBirth"].GetString();
-	FirstAppearance = obj["firstAppearance"].GetString();
-	if (obj["publisher"].IsString())
-		Publisher = obj["publisher"].GetString();
-	Alignment = obj["alignment"].GetString();
+	writer->StartObject();
+	writer->Key("gender"); writer->String(Gender.c_str());
+	writer->Key("race"); WriteOptionalString(writer, Race);
+	writer->Key("height"); WriteStringArray(writer, Height);
+	writer->Key("weight"); WriteStringArray(writer, Weight);
+	writer->Key("eyeColor"); writer->String(EyeColor.c_str());
+	writer->Key("hairColor"); writer->String(HairColor.c_str());
+	writer->EndObject();
 	return true;
 }
-bool HeroWork::Deserialize(const rapidjson::Value& obj)
+bool HeroBio::Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const
 {
-	Occupation = obj["occupation"].GetString();
-	Base = obj["base"].GetString();
+	writer->StartObject();
+	writer->Key("fullName"); writer->String(FullName.c_str());
+	writer->Key("alterEgos"); writer->String(AlterEgos.c_str());
+	writer->Key("aliases"); WriteStringArray(writer, Aliases);
+	writer->Key("placeOfBirth"); writer->String(PlaceOfBirth.c_str());
+	writer->Key("firstAppearance"); writer->String(FirstAppearance.c_str());
+	writer->Key("publisher"); WriteOptionalString(writer, Publisher);
+	writer->Key("alignment"); writer->String(Alignment.c_str());
+	writer->EndObject();
 	return true;
 }
-bool HeroConnections::Deserialize(const rapidjson::Value& obj)
+bool HeroWork::Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const
 {
-	GroupAffiliation = obj["groupAffiliation"].GetString();
-	Relatives = obj["relatives"].GetString();
+	writer->StartObject();
+	writer->Key("occupation"); writer->String(Occupation.c_str());
+	writer->Key("base"); writer->String(Base.c_str());
+	writer->EndObject();
 	return true;
 }
-bool HeroImages::Deserialize(const rapidjson::Value& obj)
+bool HeroConnections::Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const
 {
-	XS = obj["xs"].GetString();
-	SM = obj["sm"].GetString();
-	MD = obj["md"].GetString();
-	LG = obj["lg"].GetString();
+	writer->StartObject();
+	writer->Key("groupAffiliation"); writer->String(GroupAffiliation.c_str());
+	writer->Key("relatives"); writer->String(Relatives.c_str());
+	writer->EndObject();
+	return true;
+}
+bool HeroImages::Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const
+{
+	writer->StartObject();
+	writer->Key("xs"); writer->String(XS.c_str());
+	writer->Key("sm"); writer->String(SM.c_str());
+	writer->Key("md"); writer->String(MD.c_str());
+	writer->Key("lg"); writer->String(LG.c_str());
+	writer->EndObject();
 	return true;
 }
 
 Hero::Hero() : _id(-1)
 { }
-Hero::Hero(const rapidjson::Value& obj)
+Hero::Hero(const rapidjson::Value& obj) : _id(-1)
+{
+	Deserialize(obj);
+}
+Hero::Hero(const allocator_type& alloc) :
+	_id(-1), _name(alloc), _appearance(alloc), _biography(alloc), _work(alloc), _connections(alloc), _images(alloc)
+{ }
+Hero::Hero(const rapidjson::Value& obj, const allocator_type& alloc) : Hero(alloc)
 {
 	Deserialize(obj);
 }
-bool Hero::Equals(Hero other)
+Hero::Hero(const rapidjson::OnDemandValue& obj, const allocator_type& alloc) : Hero(alloc)
+{
+	Deserialize(obj);
+}
+Hero::Hero(const Hero& other, const allocator_type& alloc) :
+	JSONBase(other),
+	_id(other._id), _name(other._name, alloc), _powerstats(other._powerstats), _appearance(other._appearance, alloc),
+	_biography(other._biography, alloc), _work(other._work, alloc), _connections(other._connections, alloc), _images(other._images, alloc)
+{ }
+bool Hero::Equals(const Hero& other) const
 {
 	return _name == other._name && _id == other._id;
 }
 
+namespace
+{
+	bool IsUnknown(const HeroString& value)
+	{
+		return value.empty() || value == "-";
+	}
 
-bool Hero::Deserialize(const rapidjson::Value& obj)
+	void FillString(HeroString& value, const HeroString& other)
+	{
+		if (IsUnknown(value) && !IsUnknown(other))
+			value = other;
+	}
+
+	void FillList(HeroStringList& values, const HeroStringList& other)
+	{
+		bool known = std::any_of(values.begin(), values.end(), [](const HeroString& v) { return !IsUnknown(v); });
+		if (!known && !other.empty())
+			values.assign(other.begin(), other.end());
+	}
+}
+
+void Hero::FillMissingFrom(const Hero& other)
 {
-	Id(obj["id"].GetInt());
-	Name(obj["name"].GetString());
+	FillString(_appearance.Gender, other._appearance.Gender);
+	FillString(_appearance.Race, other._appearance.Race);
+	if (_appearance.HeightCm == 0 && other._appearance.HeightCm != 0)
+	{
+		_appearance.Height.assign(other._appearance.Height.begin(), other._appearance.Height.end());
+		_appearance.HeightCm = other._appearance.HeightCm;
+	}
+	if (_appearance.WeightKg == 0 && other._appearance.WeightKg != 0)
+	{
+		_appearance.Weight.assign(other._appearance.Weight.begin(), other._appearance.Weight.end());
+		_appearance.WeightKg = other._appearance.WeightKg;
+	}
+	FillString(_appearance.EyeColor, other._appearance.EyeColor);
+	FillString(_appearance.HairColor, other._appearance.HairColor);
 
-	_powerstats.Deserialize(obj["powerstats"].GetObject());
-	_appearance.Deserialize(obj["appearance"].GetObject());
-	_biography.Deserialize(obj["biography"].GetObject());
-	_work.Deserialize(obj["work"].GetObject());
-	_connections.Deserialize(obj["connections"].GetObject());
-	_images.Deserialize(obj["images"].GetObject());
+	FillString(_biography.FullName, other._biography.FullName);
+	FillString(_biography.AlterEgos, other._biography.AlterEgos);
+	FillList(_biography.Aliases, other._biography.Aliases);
+	FillString(_biography.PlaceOfBirth, other._biography.PlaceOfBirth);
+	FillString(_biography.FirstAppearance, other._biography.FirstAppearance);
+	FillString(_biography.Publisher, other._biography.Publisher);
+	FillString(_biography.Alignment, other._biography.Alignment);
 
-	//read object for Stats, Appearance, Bio, etc
+	FillString(_work.Occupation, other._work.Occupation);
+	FillString(_work.Base, other._work.Base);
+	FillString(_connections.GroupAffiliation, other._connections.GroupAffiliation);
+	FillString(_connections.Relatives, other._connections.Relatives);
 
-	return true;
+	FillString(_images.XS, other._images.XS);
+	FillString(_images.SM, other._images.SM);
+	FillString(_images.MD, other._images.MD);
+	FillString(_images.LG, other._images.LG);
+}
+
+
+bool Hero::Deserialize(const rapidjson::Value& obj)
+{
+	return ReadFields(obj);
+}
+
+bool Hero::Deserialize(const rapidjson::OnDemandValue& obj)
+{
+	return ReadFields(obj);
+}
+
+template <typename JsonValue>
+bool Hero::ReadFields(const JsonValue& obj)
+{
+	//one pass over the members; the sections recurse into their own maps
+	static constexpr HeroFieldMap fields{
+		MapField<&Hero::_id>("id"),
+		MapField<&Hero::_name>("name"),
+		MapField<&Hero::_powerstats>("powerstats"),
+		MapField<&Hero::_appearance>("appearance"),
+		MapField<&Hero::_biography>("biography"),
+		MapField<&Hero::_work>("work"),
+		MapField<&Hero::_connections>("connections"),
+		MapField<&Hero::_images>("images") };
+	static_assert(fields.IsPerfect());
+	return fields.Read(*this, obj);
 }
 
 bool Hero::Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const
 {
+	writer->StartObject();
+	writer->Key("id"); writer->Int(_id);
+	writer->Key("name"); writer->String(_name.c_str());
+
+	writer->Key("powerstats"); _powerstats.Serialize(writer);
+	writer->Key("appearance"); _appearance.Serialize(writer);
+	writer->Key("biography"); _biography.Serialize(writer);
+	writer->Key("work"); _work.Serialize(writer);
+	writer->Key("connections"); _connections.Serialize(writer);
+	writer->Key("images"); _images.Serialize(writer);
+	writer->EndObject();
 
 	return true;
 }
\ No newline at end of file
@@ -1,7 +1,17 @@
 #pragma once
 #include "JSONBase.h"
+#include "rapidjson/ondemand.h"
+#include <memory_resource>
+#include <string_view>
 #include <vector>
 #include "enums.h"
+
+// Hero data is allocator-aware so a whole load can live in one arena (see HeroesDB).
+// Copies made without an allocator use the default heap, like plain std::string.
+using HeroString = std::pmr::string;
+using HeroStringList = std::pmr::vector<HeroString>;
+using HeroAllocator = std::pmr::polymorphic_allocator<char>;
+
 //----------------------------------------------------------------
 //                                                              //
 //		        DO NOT EDIT THE CODE BELOW                      //
@@ -9,104 +19,199 @@
 struct HeroStats
 {
 public:
-    int Intelligence;
-    int Strength;
-    int Speed;
-    int Durability;
-    int Power;
-    int Combat;
+    int Intelligence = 0;
+    int Strength = 0;
+    int Speed = 0;
+    int Durability = 0;
+    int Power = 0;
+    int Combat = 0;
 
     bool Deserialize(const rapidjson::Value& obj);
+    bool Deserialize(const rapidjson::OnDemandValue& obj);
+    bool Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const;
 };
 
 struct HeroAppearance
 {
 public:
-    std::string Gender;
-    std::string Race;
-    std::vector<std::string> Height;
-    std::vector<std::string> Weight;
-    std::string EyeColor;
-    std::string HairColor;
+    using allocator_type = HeroAllocator;
+
+    HeroAppearance(const allocator_type& alloc = {}) :
+        Gender(alloc), Race(alloc), Height(alloc), Weight(alloc), EyeColor(alloc), HairColor(alloc)
+    { }
+    HeroAppearance(const HeroAppearance& other, const allocator_type& alloc) :
+        Gender(other.Gender, alloc), Race(other.Race, alloc), Height(other.Height, alloc), Weight(other.Weight, alloc), EyeColor(other.EyeColor, alloc), HairColor(other.HairColor, alloc),
+        HeightCm(other.HeightCm), WeightKg(other.WeightKg)
+    { }
+    HeroAppearance(const HeroAppearance&) = default;
+    HeroAppearance(HeroAppearance&&) = default;
+    HeroAppearance& operator=(const HeroAppearance&) = default;
+    HeroAppearance& operator=(HeroAppearance&&) = default;
+
+    HeroString Gender;
+    HeroString Race;
+    HeroStringList Height;
+    HeroStringList Weight;
+    HeroString EyeColor;
+    HeroString HairColor;
+    float HeightCm = 0;     // parsed from Height at load time; 0 if unknown
+    float WeightKg = 0;     // parsed from Weight at load time; 0 if unknown
 
     bool Deserialize(const rapidjson::Value& obj);
+    bool Deserialize(const rapidjson::OnDemandValue& obj);
+    bool Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const;
 };
 
 struct HeroBio
 {
 public:
-    std::string FullName;
-    std::string AlterEgos;
-    std::vector<std::string> Aliases;
-    std::string PlaceOfBirth;
-    std::string FirstAppearance;
-    std::string Publisher;
-    std::string Alignment;
+    using allocator_type = HeroAllocator;
+
+    HeroBio(const allocator_type& alloc = {}) :
+        FullName(alloc), AlterEgos(alloc), Aliases(alloc), PlaceOfBirth(alloc), FirstAppearance(alloc), Publisher(alloc), Alignment(alloc)
+    { }
+    HeroBio(const HeroBio& other, const allocator_type& alloc) :
+        FullName(other.FullName, alloc), AlterEgos(other.AlterEgos, alloc), Aliases(other.Aliases, alloc), PlaceOfBirth(other.PlaceOfBirth, alloc), FirstAppearance(other.FirstAppearance, alloc), Publisher(other.Publisher, alloc), Alignment(other.Alignment, alloc)
+    { }
+    HeroBio(const HeroBio&) = default;
+    HeroBio(HeroBio&&) = default;
+    HeroBio& operator=(const HeroBio&) = default;
+    HeroBio& operator=(HeroBio&&) = default;
+
+    HeroString FullName;
+    HeroString AlterEgos;
+    HeroStringList Aliases;
+    HeroString PlaceOfBirth;
+    HeroString FirstAppearance;
+    HeroString Publisher;
+    HeroString Alignment;
 
     bool Deserialize(const rapidjson::Value& obj);
+    bool Deserialize(const rapidjson::OnDemandValue& obj);
+    bool Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const;
 };
 struct HeroWork
 {
 public:
-    std::string Occupation;
-    std::string Base;
+    using allocator_type = HeroAllocator;
+
+    HeroWork(const allocator_type& alloc = {}) :
+        Occupation(alloc), Base(alloc)
+    { }
+    HeroWork(const HeroWork& other, const allocator_type& alloc) :
+        Occupation(other.Occupation, alloc), Base(other.Base, alloc)
+    { }
+    HeroWork(const HeroWork&) = default;
+    HeroWork(HeroWork&&) = default;
+    HeroWork& operator=(const HeroWork&) = default;
+    HeroWork& operator=(HeroWork&&) = default;
+
+    HeroString Occupation;
+    HeroString Base;
 
     bool Deserialize(const rapidjson::Value& obj);
+    bool Deserialize(const rapidjson::OnDemandValue& obj);
+    bool Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const;
 };
 struct HeroConnections
 {
 public:
-    std::string GroupAffiliation;
-    std::string Relatives;
+    using allocator_type = HeroAllocator;
+
+    HeroConnections(const allocator_type& alloc = {}) :
+        GroupAffiliation(alloc), Relatives(alloc)
+    { }
+    HeroConnections(const HeroConnections& other, const allocator_type& alloc) :
+        GroupAffiliation(other.GroupAffiliation, alloc), Relatives(other.Relatives, alloc)
+    { }
+    HeroConnections(const HeroConnections&) = default;
+    HeroConnections(HeroConnections&&) = default;
+    HeroConnections& operator=(const HeroConnections&) = default;
+    HeroConnections& operator=(HeroConnections&&) = default;
+
+    HeroString GroupAffiliation;
+    HeroString Relatives;
 
     bool Deserialize(const rapidjson::Value& obj);
+    bool Deserialize(const rapidjson::OnDemandValue& obj);
+    bool Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const;
 };
 struct HeroImages
 {
 public:
-    std::string XS;
-    std::string SM;
-    std::string MD;
-    std::string LG;
+    using allocator_type = HeroAllocator;
+
+    HeroImages(const allocator_type& alloc = {}) :
+        XS(alloc), SM(alloc), MD(alloc), LG(alloc)
+    { }
+    HeroImages(const HeroImages& other, const allocator_type& alloc) :
+        XS(other.XS, alloc), SM(other.SM, alloc), MD(other.MD, alloc), LG(other.LG, alloc)
+    { }
+    HeroImages(const HeroImages&) = default;
+    HeroImages(HeroImages&&) = default;
+    HeroImages& operator=(const HeroImages&) = default;
+    HeroImages& operator=(HeroImages&&) = default;
+
+    HeroString XS;
+    HeroString SM;
+    HeroString MD;
+    HeroString LG;
 
     bool Deserialize(const rapidjson::Value& obj);
+    bool Deserialize(const rapidjson::OnDemandValue& obj);
+    bool Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const;
 };
 
 class Hero : public JSONBase
 {
 public:
+    using allocator_type = HeroAllocator;
+
     Hero();
     Hero(const rapidjson::Value& obj);
+    explicit Hero(const allocator_type& alloc);
+    Hero(const rapidjson::Value& obj, const allocator_type& alloc);
+    Hero(const rapidjson::OnDemandValue& obj, const allocator_type& alloc);
+    Hero(const Hero& other, const allocator_type& alloc);
+    Hero(const Hero&) = default;
+    Hero(Hero&&) = default;
+    Hero& operator=(const Hero&) = default;
+    Hero& operator=(Hero&&) = default;
     //virtual ~Hero();
 
     virtual bool Deserialize(const rapidjson::Value& obj);
+    bool Deserialize(const rapidjson::OnDemandValue& obj);
     virtual bool Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const;
 
     // Getters/Setters.
     int Id() const { return _id; }
     void Id(int id) { _id = id; }
 
-    const std::string& Name() const { return _name; }
-    void Name(const std::string& name) { _name = name; }
+    const HeroString& Name() const { return _name; }
+    void Name(std::string_view name) { _name = name; }
 
     const HeroStats& Powerstats() const { return _powerstats; }
     void Powerstats(const HeroStats& powerstats) { _powerstats = powerstats; }
 
-    HeroAppearance Appearance() const { return _appearance; }
+    const HeroAppearance& Appearance() const { return _appearance; }
     void Appearance(HeroAppearance appearance) { _appearance = appearance; }
 
-    HeroBio Biography() const { return _biography; }
+    const HeroBio& Biography() const { return _biography; }
     void Biography(HeroBio biography) { _biography = biography; }
 
-    HeroWork Work() const { return _work; }
+    const HeroWork& Work() const { return _work; }
     void Work(HeroWork work) { _work = work; }
 
-    HeroConnections Connections() const { return _connections; }
+    const HeroConnections& Connections() const { return _connections; }
     void Connections(HeroConnections connections) { _connections = connections; }
 
-    HeroImages Images() const { return _images; }
+    const HeroImages& Images() const { return _images; }
     void Images(HeroImages images) { _images = images; }
 
+    // Copies every text field and list that is unknown here (empty or "-") but known in other.
+    // Id, name and powerstats are left alone. Used to merge two records of the same hero.
+    void FillMissingFrom(const Hero& other);
+
 
 
     std::string GetSortByAttribute(SortBy sortByChoice) const
@@ -132,12 +237,34 @@ public:
         case Combat:
             attribute = std::to_string(Powerstats().Combat);
             break;
+        case Height:
+            attribute = _appearance.HeightCm > 0 ? std::to_string(GetSortByValue(Height)) + " cm" : "-";
+            break;
+        case Weight:
+            attribute = _appearance.WeightKg > 0 ? std::to_string(GetSortByValue(Weight)) + " kg" : "-";
+            break;
         default:
             break;
         }
         return attribute;
     }
 
+    int GetSortByValue(SortBy sortByChoice) const
+    {
+        switch (sortByChoice)
+        {
+        case Intelligence: return _powerstats.Intelligence;
+        case Strength: return _powerstats.Strength;
+        case Speed: return _powerstats.Speed;
+        case Durability: return _powerstats.Durability;
+        case Power: return _powerstats.Power;
+        case Combat: return _powerstats.Combat;
+        case Height: return static_cast<int>(_appearance.HeightCm + 0.5f);
+        case Weight: return static_cast<int>(_appearance.WeightKg + 0.5f);
+        default: return 0;
+        }
+    }
+
     static int Compare(const Hero& hero1, const Hero& hero2, SortBy sortByChoice)
     {
         int attr1 = 0, attr2 = 0;
@@ -167,6 +294,11 @@ public:
             attr1 = hero1.Powerstats().Combat;
             attr2 = hero2.Powerstats().Combat;
             break;
+        case Height:
+        case Weight:
+            attr1 = hero1.GetSortByValue(sortByChoice);
+            attr2 = hero2.GetSortByValue(sortByChoice);
+            break;
         default:
             break;
         }
@@ -181,7 +313,7 @@ public:
 
 private:
     int _id;
-    std::string _name;
+    HeroString _name;
 
     HeroStats _powerstats;
     HeroAppearance _appearance;
@@ -190,6 +322,9 @@ private:
     HeroConnections _connections;
     HeroImages _images;
 
-    bool Equals(Hero other);
+    bool Equals(const Hero& other) const;
+
+    template <typename JsonValue>
+    bool ReadFields(const JsonValue& obj);
 };
 
@@ -0,0 +1,38 @@
+#include "HeroAllocations.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<size_t> allocationCount{ 0 };
+	std::atomic<size_t> allocationBytes{ 0 };
+
+	void* Allocate(size_t size)
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocationBytes.fetch_add(size, std::memory_order_relaxed);
+		void* p = std::malloc(size == 0 ? 1 : size);
+		if (p == nullptr)
+			throw std::bad_alloc();
+		return p;
+	}
+}
+
+size_t HeroAllocations::Count()
+{
+	return allocationCount.load(std::memory_order_relaxed);
+}
+
+size_t HeroAllocations::Bytes()
+{
+	return allocationBytes.load(std::memory_order_relaxed);
+}
+
+//the nothrow and aligned forms are left to the library; its nothrow new forwards to these
+void* operator new(size_t size) { return Allocate(size); }
+void* operator new[](size_t size) { return Allocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
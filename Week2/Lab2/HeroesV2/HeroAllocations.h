@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+// Process-wide counters fed by the global operator new replacements in HeroAllocations.cpp.
+// Take a difference of two readings to get the allocations made by one operation.
+class HeroAllocations final
+{
+public:
+    static size_t Count();
+    static size_t Bytes();
+};
@@ -0,0 +1,1023 @@
+#include "HeroBenchmarks.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "rapidjson/concurrentallocator.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/parallelwriter.h"
+#include "rapidjson/pointerset.h"
+#include "HeroMeasures.h"
+#include <memory_resource>
+#include <random>
+#include <thread>
+
+namespace
+{
+	template <typename Fn>
+	double AverageMicroseconds(int repeats, Fn fn)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < repeats; i++)
+			fn();
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		return std::chrono::duration<double, std::micro>(elapsed).count() / repeats;
+	}
+
+	//p50/p99/max of a set of per-call timings, in microseconds
+	void PrintLatencies(const char* label, std::vector<double> timings)
+	{
+		if (timings.empty())
+			return;
+		std::sort(timings.begin(), timings.end());
+		std::cout << "  " << label
+			<< " p50 " << timings[timings.size() / 2] << " us"
+			<< ", p99 " << timings[timings.size() * 99 / 100] << " us"
+			<< ", max " << timings.back() << " us" << std::endl;
+	}
+
+	//the Deserialize code Hero used before HeroFieldMap: one obj["key"] member scan per field
+	struct LookupHero
+	{
+		int Id;
+		HeroString Name;
+		HeroStats Powerstats;
+		HeroAppearance Appearance;
+		HeroBio Biography;
+		HeroWork Work;
+		HeroConnections Connections;
+		HeroImages Images;
+
+		LookupHero(const rapidjson::Value& obj, const HeroAllocator& alloc) :
+			Name(alloc), Appearance(alloc), Biography(alloc), Work(alloc), Connections(alloc), Images(alloc)
+		{
+			Id = obj["id"].GetInt();
+			Name = obj["name"].GetString();
+
+			const rapidjson::Value& stats = obj["powerstats"];
+			Powerstats.Intelligence = stats["intelligence"].GetInt();
+			Powerstats.Strength = stats["strength"].GetInt();
+			Powerstats.Speed = stats["speed"].GetInt();
+			Powerstats.Durability = stats["durability"].GetInt();
+			Powerstats.Power = stats["power"].GetInt();
+			Powerstats.Combat = stats["combat"].GetInt();
+
+			const rapidjson::Value& appearance = obj["appearance"];
+			Appearance.Gender = appearance["gender"].GetString();
+			if (appearance["race"].IsString())
+				Appearance.Race = appearance["race"].GetString();
+			const rapidjson::Value& heights = appearance["height"];
+			for (rapidjson::SizeType i = 0; i < heights.Size(); ++i)
+				Appearance.Height.push_back(heights[i].GetString());
+			const rapidjson::Value& weights = appearance["weight"];
+			for (rapidjson::SizeType i = 0; i < weights.Size(); ++i)
+				Appearance.Weight.push_back(weights[i].GetString());
+			Appearance.HeightCm = HeroMeasures::ParseHeightCm(Appearance.Height);
+			Appearance.WeightKg = HeroMeasures::ParseWeightKg(Appearance.Weight);
+			Appearance.EyeColor = appearance["eyeColor"].GetString();
+			Appearance.HairColor = appearance["hairColor"].GetString();
+
+			const rapidjson::Value& bio = obj["biography"];
+			Biography.FullName = bio["fullName"].GetString();
+			Biography.AlterEgos = bio["alterEgos"].GetString();
+			const rapidjson::Value& aliases = bio["aliases"];
+			for (rapidjson::SizeType i = 0; i < aliases.Size(); ++i)
+				Biography.Aliases.push_back(aliases[i].GetString());
+			Biography.PlaceOfBirth = bio["placeOfBirth"].GetString();
+			Biography.FirstAppearance = bio["firstAppearance"].GetString();
+			if (bio["publisher"].IsString())
+				Biography.Publisher = bio["publisher"].GetString();
+			Biography.Alignment = bio["alignment"].GetString();
+
+			const rapidjson::Value& work = obj["work"];
+			Work.Occupation = work["occupation"].GetString();
+			Work.Base = work["base"].GetString();
+
+			const rapidjson::Value& connections = obj["connections"];
+			Connections.GroupAffiliation = connections["groupAffiliation"].GetString();
+			Connections.Relatives = connections["relatives"].GetString();
+
+			const rapidjson::Value& images = obj["images"];
+			Images.XS = images["xs"].GetString();
+			Images.SM = images["sm"].GetString();
+			Images.MD = images["md"].GetString();
+			Images.LG = images["lg"].GetString();
+		}
+	};
+
+	//parses every hero in heroDB back into a DOM so only field extraction gets timed
+	void SerializeHeroes(const std::vector<Hero>& heroes, rapidjson::Document& doc)
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		writer.StartArray();
+		for (const Hero& hero : heroes)
+			hero.Serialize(&writer);
+		writer.EndArray();
+		doc.Parse(buffer.GetString(), buffer.GetSize());
+	}
+
+	//internal::dtoa with the Grisu2 digits Writer used before RAPIDJSON_DTOA_RYU
+	char* Grisu2Dtoa(double value, char* buffer)
+	{
+		if (rapidjson::internal::Double(value).IsZero())
+		{
+			if (rapidjson::internal::Double(value).Sign())
+				*buffer++ = '-';
+			std::memcpy(buffer, "0.0", 3);
+			return buffer + 3;
+		}
+		if (value < 0)
+		{
+			*buffer++ = '-';
+			value = -value;
+		}
+		int length, K;
+		rapidjson::internal::Grisu2(value, buffer, &length, &K);
+		return rapidjson::internal::Prettify(buffer, length, K, rapidjson::Writer<rapidjson::StringBuffer>::kDefaultMaxDecimalPlaces);
+	}
+
+	//values formatted into one comma-separated buffer the way Writer::WriteDouble does it; returns the bytes written
+	template <typename Dtoa>
+	size_t FormatDoubles(const std::vector<double>& values, rapidjson::StringBuffer& buffer, Dtoa dtoa)
+	{
+		buffer.Clear();
+		for (double value : values)
+		{
+			char* start = buffer.Push(25);
+			char* end = dtoa(value, start);
+			buffer.Pop(static_cast<size_t>(25 - (end - start)));
+			buffer.Put(',');
+		}
+		return buffer.GetSize();
+	}
+
+	double MegabytesPerSecond(size_t bytes, double microseconds)
+	{
+		return microseconds > 0 ? bytes / microseconds : 0;
+	}
+
+	//number-heavy data shared by NumberWrite and NumberParse
+	struct NumberSets
+	{
+		std::vector<double> RandomDoubles, Prices, WholeDoubles;
+		std::vector<int64_t> Ids;
+
+		explicit NumberSets(size_t valueCount)
+			: RandomDoubles(valueCount), Prices(valueCount), WholeDoubles(valueCount), Ids(valueCount)
+		{
+			std::mt19937_64 rng(42);
+			std::uniform_real_distribution<double> mantissa(1.0, 10.0);
+			std::uniform_int_distribution<int> exponent(-20, 20);
+			for (size_t i = 0; i < valueCount; i++)
+			{
+				RandomDoubles[i] = mantissa(rng) * std::pow(10.0, exponent(rng));
+				Prices[i] = static_cast<double>(rng() % 10000000) / 100;
+				WholeDoubles[i] = static_cast<double>(rng() % 1000000);
+				Ids[i] = static_cast<int64_t>(rng() >> (rng() % 64));
+			}
+		}
+	};
+
+	//parsed doubles equal to the values they were written from
+	size_t CountExact(const rapidjson::Document& doc, const std::vector<double>& values)
+	{
+		if (doc.HasParseError() || !doc.IsArray() || doc.Size() != values.size())
+			return 0;
+		size_t exact = 0;
+		for (rapidjson::SizeType i = 0; i < doc.Size(); i++)
+			if (doc[i].GetDouble() == values[i])
+				exact++;
+		return exact;
+	}
+}
+
+void HeroBenchmarks::SortByAttribute(HeroesDB& heroDB, SortBy sortBy, int repeats)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty())
+		return;
+
+	std::vector<Hero> merged;
+	double mergeTime = AverageMicroseconds(repeats, [&]() {
+		merged = heroes;
+		heroDB.MergeSort(merged, 0, static_cast<int>(merged.size()) - 1, sortBy);
+		});
+
+	std::vector<size_t> counted;
+	double countTime = AverageMicroseconds(repeats, [&]() {
+		counted = heroDB.CountingSort(heroes, sortBy);
+		});
+
+	//both sorts are stable, so they must agree hero for hero
+	bool same = merged.size() == counted.size();
+	for (size_t i = 0; same && i < counted.size(); i++)
+		same = merged[i].Id() == heroes[counted[i]].Id();
+
+	std::cout << "Sort " << heroes.size() << " heroes by attribute " << sortBy << " (" << repeats << " runs)" << std::endl;
+	std::cout << "  MergeSort:    " << mergeTime << " us" << std::endl;
+	std::cout << "  CountingSort: " << countTime << " us" << std::endl;
+	std::cout << "  Speedup:      " << (countTime > 0 ? mergeTime / countTime : 0) << "x" << std::endl;
+	std::cout << "  Same order:   " << (same ? "yes" : "NO") << std::endl;
+}
+
+void HeroBenchmarks::SimilarHeroes(HeroesDB& heroDB, size_t heroCount, int queries, size_t k)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || heroCount == 0)
+		return;
+
+	//real stat profiles with a little jitter so the synthetic set has realistic clusters
+	std::mt19937 rng(12345);
+	std::uniform_int_distribution<size_t> pick(0, heroes.size() - 1);
+	std::uniform_int_distribution<int> jitter(-5, 5);
+	auto jittered = [&](int value) { return std::clamp(value + jitter(rng), 0, 110); };
+	std::vector<HeroStats> stats(heroCount);
+	for (auto& stat : stats)
+	{
+		const HeroStats& source = heroes[pick(rng)].Powerstats();
+		stat = { jittered(source.Intelligence), jittered(source.Strength), jittered(source.Speed),
+			jittered(source.Durability), jittered(source.Power), jittered(source.Combat) };
+	}
+
+	HeroKnn knn;
+	auto start = std::chrono::steady_clock::now();
+	knn.Build(stats);
+	double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "k-NN over " << heroCount << " heroes, k = " << k << ", " << queries << " queries" << std::endl;
+	std::cout << "  Columnar build: " << buildTime << " ms" << std::endl;
+
+	std::uniform_int_distribution<size_t> query(0, heroCount - 1);
+	const DistanceMetric metrics[] = { Manhattan, Euclidean, Cosine };
+	const char* names[] = { "L1", "L2", "Cosine" };
+	for (int m = 0; m < 3; m++)
+	{
+		DistanceMetric metric = metrics[m];
+		start = std::chrono::steady_clock::now();
+		knn.BuildTree(metric);
+		double treeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::vector<double> bruteTimings, treeTimings;
+		bool same = true;
+		for (int q = 0; q < queries; q++)
+		{
+			size_t index = query(rng);
+			HeroKnn::StatVector point = knn.Point(index);
+
+			auto t0 = std::chrono::steady_clock::now();
+			std::vector<HeroNeighbor> brute = knn.QueryBruteForce(point, k, metric, index);
+			auto t1 = std::chrono::steady_clock::now();
+			std::vector<HeroNeighbor> tree = knn.QueryTree(point, k, metric, index);
+			auto t2 = std::chrono::steady_clock::now();
+			bruteTimings.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+			treeTimings.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+
+			for (size_t i = 0; same && i < brute.size(); i++)
+				same = i < tree.size() && brute[i].Index == tree[i].Index;
+		}
+
+		std::cout << " " << names[m] << " (tree build " << treeTime << " ms, same results: " << (same ? "yes" : "NO") << ")" << std::endl;
+		PrintLatencies("Brute force:", bruteTimings);
+		PrintLatencies("KD-tree:    ", treeTimings);
+	}
+}
+
+void HeroBenchmarks::LoadAndDestroy(HeroesDB& heroDB, size_t heroCount, int repeats)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || heroCount == 0 || repeats <= 0)
+		return;
+
+	//parse once up front so only Hero construction and teardown are timed
+	rapidjson::Document doc;
+	SerializeHeroes(heroes, doc);
+	const rapidjson::Value& nodes = doc;
+
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](Clock::duration elapsed) { return std::chrono::duration<double, std::milli>(elapsed).count(); };
+	double heapLoad = 0, heapDestroy = 0, arenaLoad = 0, arenaDestroy = 0;
+	for (int r = 0; r < repeats; r++)
+	{
+		{
+			auto start = Clock::now();
+			std::vector<Hero> loaded;
+			loaded.reserve(heroCount);
+			for (size_t i = 0; i < heroCount; i++)
+				loaded.emplace_back(nodes[static_cast<rapidjson::SizeType>(i % nodes.Size())]);
+			auto built = Clock::now();
+			std::vector<Hero>().swap(loaded);
+			heapLoad += milliseconds(built - start);
+			heapDestroy += milliseconds(Clock::now() - built);
+		}
+		{
+			auto start = Clock::now();
+			std::pmr::monotonic_buffer_resource arena;
+			std::vector<Hero> loaded;
+			loaded.reserve(heroCount);
+			for (size_t i = 0; i < heroCount; i++)
+				loaded.emplace_back(nodes[static_cast<rapidjson::SizeType>(i % nodes.Size())], HeroAllocator(&arena));
+			auto built = Clock::now();
+			std::vector<Hero>().swap(loaded);
+			arena.release();
+			arenaLoad += milliseconds(built - start);
+			arenaDestroy += milliseconds(Clock::now() - built);
+		}
+	}
+
+	std::cout << "Load and destroy " << heroCount << " heroes (" << repeats << " runs)" << std::endl;
+	std::cout << "  Default heap: load " << heapLoad / repeats << " ms, destroy " << heapDestroy / repeats << " ms" << std::endl;
+	std::cout << "  Arena:        load " << arenaLoad / repeats << " ms, destroy " << arenaDestroy / repeats << " ms" << std::endl;
+	std::cout << "  Speedup:      load " << (arenaLoad > 0 ? heapLoad / arenaLoad : 0) << "x, destroy "
+		<< (arenaDestroy > 0 ? heapDestroy / arenaDestroy : 0) << "x" << std::endl;
+}
+
+void HeroBenchmarks::Deserialize(HeroesDB& heroDB, size_t heroCount, int repeats)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || heroCount == 0 || repeats <= 0)
+		return;
+
+	rapidjson::Document doc;
+	SerializeHeroes(heroes, doc);
+	const rapidjson::Value& nodes = doc;
+
+	//both sides build into an arena that is released between runs, so allocation cost is the same
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](Clock::duration elapsed) { return std::chrono::duration<double, std::milli>(elapsed).count(); };
+	double lookupTime = 0, mapTime = 0;
+	bool same = true;
+	std::pmr::monotonic_buffer_resource arena;
+	for (int r = 0; r < repeats; r++)
+	{
+		{
+			std::vector<LookupHero> lookups;
+			lookups.reserve(heroCount);
+			auto start = Clock::now();
+			for (size_t i = 0; i < heroCount; i++)
+				lookups.emplace_back(nodes[static_cast<rapidjson::SizeType>(i % nodes.Size())], HeroAllocator(&arena));
+			lookupTime += milliseconds(Clock::now() - start);
+
+			std::vector<Hero> mapped;
+			mapped.reserve(heroCount);
+			start = Clock::now();
+			for (size_t i = 0; i < heroCount; i++)
+				mapped.emplace_back(nodes[static_cast<rapidjson::SizeType>(i % nodes.Size())], HeroAllocator(&arena));
+			mapTime += milliseconds(Clock::now() - start);
+
+			for (size_t i = 0; same && i < heroCount; i++)
+			{
+				same = lookups[i].Id == mapped[i].Id() && lookups[i].Name == mapped[i].Name() &&
+					lookups[i].Appearance.HeightCm == mapped[i].Appearance().HeightCm &&
+					lookups[i].Biography.Aliases == mapped[i].Biography().Aliases &&
+					lookups[i].Images.LG == mapped[i].Images().LG;
+			}
+		}
+		arena.release();
+	}
+
+	std::cout << "Deserialize " << heroCount << " heroes (" << repeats << " runs)" << std::endl;
+	std::cout << "  obj[\"key\"] lookups: " << lookupTime / repeats << " ms, "
+		<< (lookupTime > 0 ? heroCount * repeats / lookupTime * 1000 : 0) << " heroes/s" << std::endl;
+	std::cout << "  Field map:         " << mapTime / repeats << " ms, "
+		<< (mapTime > 0 ? heroCount * repeats / mapTime * 1000 : 0) << " heroes/s" << std::endl;
+	std::cout << "  Speedup:           " << (mapTime > 0 ? lookupTime / mapTime : 0) << "x" << std::endl;
+	std::cout << "  Same heroes:       " << (same ? "yes" : "NO") << std::endl;
+}
+
+void HeroBenchmarks::ParseJson(HeroesDB& heroDB, size_t targetBytes, int repeats)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || repeats <= 0)
+		return;
+
+	//heroes.json-shaped: the pretty-printed hero array repeated until it reaches targetBytes
+	std::string heroJson = "[";
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+		writer.StartArray();
+		for (const Hero& hero : heroes)
+		{
+			rapidjson::StringBuffer one;
+			rapidjson::Writer<rapidjson::StringBuffer> oneWriter(one);
+			hero.Serialize(&oneWriter);
+			rapidjson::Document doc;
+			doc.Parse(one.GetString(), one.GetSize());
+			doc.Accept(writer);
+		}
+		writer.EndArray();
+		std::string block(buffer.GetString() + 1, buffer.GetSize() - 2);
+		while (heroJson.size() < targetBytes)
+			heroJson.append(heroJson.size() > 1 ? "," : "").append(block);
+		heroJson += "]";
+	}
+
+	//string-heavy: long values made of a hero's text fields, with the odd escaped newline
+	std::string stringJson;
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+		writer.StartArray();
+		for (size_t i = 0; buffer.GetSize() < targetBytes; i++)
+		{
+			const Hero& hero = heroes[i % heroes.size()];
+			std::string text;
+			for (int copy = 0; copy < 8; copy++)
+			{
+				text.append(hero.Biography().FullName).append(" ").append(hero.Work().Occupation).append(" ")
+					.append(hero.Work().Base).append("\n").append(hero.Connections().GroupAffiliation).append(" ")
+					.append(hero.Connections().Relatives).append(" ").append(hero.Images().LG);
+			}
+			writer.String(text.c_str(), static_cast<rapidjson::SizeType>(text.size()));
+		}
+		writer.EndArray();
+		stringJson.assign(buffer.GetString(), buffer.GetSize());
+	}
+
+	const struct { const char* Name; const std::string* Json; } inputs[] = { { "Hero array", &heroJson }, { "Long strings", &stringJson } };
+#if RAPIDJSON_SIMD_DISPATCH
+	const char* levelNames[] = { "Scalar", "SSE2", "AVX2", "AVX-512" };
+	rapidjson::SimdLevel initial = rapidjson::GetSimdLevel();
+	int levels = rapidjson::GetSupportedSimdLevel() + 1;
+#else
+	const char* levelNames[] = { "built-in" };
+	int levels = 1;
+#endif
+	for (const auto& input : inputs)
+	{
+		std::cout << input.Name << ": " << input.Json->size() / (1 << 20) << " MB (" << repeats << " runs)" << std::endl;
+		for (int level = 0; level < levels; level++)
+		{
+#if RAPIDJSON_SIMD_DISPATCH
+			rapidjson::SetSimdLevel(static_cast<rapidjson::SimdLevel>(level));
+#endif
+			//null-terminated Parse reads a StringStream, Parse with a length a MemoryStream
+			bool ok = true;
+			double parse = AverageMicroseconds(repeats, [&]() {
+				rapidjson::Document doc;
+				doc.Parse(input.Json->c_str());
+				ok = ok && !doc.HasParseError();
+				});
+			double parseLength = AverageMicroseconds(repeats, [&]() {
+				rapidjson::Document doc;
+				doc.Parse(input.Json->c_str(), input.Json->size());
+				ok = ok && !doc.HasParseError();
+				});
+			std::string copy;
+			double insitu = 0;
+			for (int r = 0; r < repeats; r++)
+			{
+				copy = *input.Json;
+				insitu += AverageMicroseconds(1, [&]() {
+					rapidjson::Document doc;
+					doc.ParseInsitu(&copy[0]);
+					ok = ok && !doc.HasParseError();
+					});
+			}
+			insitu /= repeats;
+			std::cout << "  " << levelNames[level] << ": Parse " << input.Json->size() / parse << " MB/s, Parse(length) "
+				<< input.Json->size() / parseLength << " MB/s, ParseInsitu "
+				<< input.Json->size() / insitu << " MB/s" << (ok ? "" : " (PARSE ERROR)") << std::endl;
+		}
+	}
+#if RAPIDJSON_SIMD_DISPATCH
+	rapidjson::SetSimdLevel(initial);
+#endif
+}
+
+void HeroBenchmarks::OnDemand(HeroesDB& heroDB, size_t heroCount, int repeats)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || heroCount == 0 || repeats <= 0)
+		return;
+
+	std::string json;
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		writer.StartArray();
+		for (size_t i = 0; i < heroCount; i++)
+			heroes[i % heroes.size()].Serialize(&writer);
+		writer.EndArray();
+		json.assign(buffer.GetString(), buffer.GetSize());
+	}
+
+	//whole heroes, as HeroesDB::Deserialize loads them; each side releases its own arena per run
+	bool ok = true;
+	std::pmr::monotonic_buffer_resource domArena, lazyArena;
+	std::vector<Hero> domHeroes, lazyHeroes;
+	double domLoad = AverageMicroseconds(repeats, [&]() {
+		std::vector<Hero>().swap(domHeroes);
+		domArena.release();
+		rapidjson::Document doc;
+		doc.Parse(json.c_str(), json.size());
+		ok = ok && !doc.HasParseError();
+		domHeroes.reserve(doc.Size());
+		for (const rapidjson::Value& node : doc.GetArray())
+			domHeroes.emplace_back(node, HeroAllocator(&domArena));
+		});
+	double lazyLoad = AverageMicroseconds(repeats, [&]() {
+		std::vector<Hero>().swap(lazyHeroes);
+		lazyArena.release();
+		rapidjson::OnDemandDocument doc;
+		for (const rapidjson::OnDemandValue& node : doc.Parse(json.c_str(), json.size()).GetArray())
+			lazyHeroes.emplace_back(node, HeroAllocator(&lazyArena));
+		ok = ok && !doc.HasParseError();
+		});
+
+	//a few fields per hero; the on-demand side skips the rest of each object unparsed
+	long long domSum = 0, lazySum = 0;
+	double domFew = AverageMicroseconds(repeats, [&]() {
+		rapidjson::Document doc;
+		doc.Parse(json.c_str(), json.size());
+		domSum = 0;
+		for (const rapidjson::Value& node : doc.GetArray())
+			domSum += node["id"].GetInt() + node["name"].GetStringLength() + node["powerstats"]["strength"].GetInt();
+		});
+	double lazyFew = AverageMicroseconds(repeats, [&]() {
+		rapidjson::OnDemandDocument doc;
+		lazySum = 0;
+		for (const rapidjson::OnDemandValue& node : doc.Parse(json.c_str(), json.size()).GetArray())
+			lazySum += node["id"].GetInt() + node["name"].GetStringLength() + node["powerstats"]["strength"].GetInt();
+		ok = ok && !doc.HasParseError();
+		});
+
+	bool same = ok && domSum == lazySum && domHeroes.size() == lazyHeroes.size();
+	for (size_t i = 0; same && i < domHeroes.size(); i++)
+	{
+		same = domHeroes[i].Id() == lazyHeroes[i].Id() && domHeroes[i].Name() == lazyHeroes[i].Name() &&
+			domHeroes[i].Powerstats().Combat == lazyHeroes[i].Powerstats().Combat &&
+			domHeroes[i].Appearance().HeightCm == lazyHeroes[i].Appearance().HeightCm &&
+			domHeroes[i].Biography().Aliases == lazyHeroes[i].Biography().Aliases &&
+			domHeroes[i].Images().LG == lazyHeroes[i].Images().LG;
+	}
+
+	std::cout << "On-demand JSON: " << heroCount << " heroes, " << json.size() / (1 << 20) << " MB (" << repeats << " runs)" << std::endl;
+	std::cout << "  Load heroes:   DOM " << domLoad / 1000 << " ms, on-demand " << lazyLoad / 1000 << " ms, speedup "
+		<< (lazyLoad > 0 ? domLoad / lazyLoad : 0) << "x" << std::endl;
+	std::cout << "  Read 3 fields: DOM " << domFew / 1000 << " ms, on-demand " << lazyFew / 1000 << " ms, speedup "
+		<< (lazyFew > 0 ? domFew / lazyFew : 0) << "x" << std::endl;
+	std::cout << "  Same results:  " << (same ? "yes" : "NO") << std::endl;
+}
+
+void HeroBenchmarks::ParallelWrite(HeroesDB& heroDB, size_t heroCount, int repeats)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || heroCount == 0 || repeats <= 0)
+		return;
+
+	auto produce = [&heroes](rapidjson::Writer<rapidjson::StringBuffer>& writer, size_t i)
+		{
+			return heroes[i % heroes.size()].Serialize(&writer);
+		};
+
+	//Hero::Serialize per element, compact output
+	std::string sequential, parallel;
+	double sequentialWrite = AverageMicroseconds(repeats, [&]() {
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		writer.StartArray();
+		for (size_t i = 0; i < heroCount; i++)
+			produce(writer, i);
+		writer.EndArray();
+		sequential.assign(buffer.GetString(), buffer.GetSize());
+		});
+	double parallelWrite = AverageMicroseconds(repeats, [&]() {
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		rapidjson::WriteArrayParallel(writer, heroCount, produce);
+		parallel.assign(buffer.GetString(), buffer.GetSize());
+		});
+	bool same = sequential == parallel;
+
+	//a whole DOM through PrettyWriter
+	rapidjson::Document doc;
+	doc.Parse(sequential.c_str(), sequential.size());
+	double sequentialAccept = AverageMicroseconds(repeats, [&]() {
+		rapidjson::StringBuffer buffer;
+		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+		doc.Accept(writer);
+		sequential.assign(buffer.GetString(), buffer.GetSize());
+		});
+	double parallelAccept = AverageMicroseconds(repeats, [&]() {
+		rapidjson::StringBuffer buffer;
+		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+		rapidjson::AcceptParallel(doc, writer);
+		parallel.assign(buffer.GetString(), buffer.GetSize());
+		});
+	same = same && !doc.HasParseError() && sequential == parallel;
+
+	std::cout << "Parallel JSON write: " << heroCount << " heroes, " << std::thread::hardware_concurrency() << " hardware threads (" << repeats << " runs)" << std::endl;
+	std::cout << "  Writer, Hero::Serialize: 1 thread " << sequentialWrite / 1000 << " ms, parallel " << parallelWrite / 1000 << " ms, speedup "
+		<< (parallelWrite > 0 ? sequentialWrite / parallelWrite : 0) << "x" << std::endl;
+	std::cout << "  PrettyWriter, DOM:       1 thread " << sequentialAccept / 1000 << " ms, parallel " << parallelAccept / 1000 << " ms, speedup "
+		<< (parallelAccept > 0 ? sequentialAccept / parallelAccept : 0) << "x" << std::endl;
+	std::cout << "  Same output:             " << (same ? "yes" : "NO") << std::endl;
+}
+
+void HeroBenchmarks::NumberWrite(HeroesDB& heroDB, size_t valueCount, int repeats)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || valueCount == 0 || repeats <= 0)
+		return;
+
+	const NumberSets sets(valueCount);
+	struct DoubleSet
+	{
+		const char* Label;
+		const std::vector<double>* Values;
+	};
+	const DoubleSet doubleSets[] = { { "random doubles", &sets.RandomDoubles }, { "prices (x.yy) ", &sets.Prices }, { "whole doubles ", &sets.WholeDoubles } };
+
+	std::cout << "Number write: " << valueCount << " values per document (" << repeats << " runs), MB/s" << std::endl;
+	rapidjson::StringBuffer buffer;
+	for (const DoubleSet& set : doubleSets)
+	{
+		size_t bytes = 0;
+		double grisu = AverageMicroseconds(repeats, [&]() { bytes = FormatDoubles(*set.Values, buffer, Grisu2Dtoa); });
+		std::string grisuText(buffer.GetString(), buffer.GetSize());
+		double ryu = AverageMicroseconds(repeats, [&]() { bytes = FormatDoubles(*set.Values, buffer, [](double value, char* out) { return rapidjson::internal::dtoa(value, out); }); });
+
+		//both must read back to the same doubles; the Ryu text may be shorter where Grisu2 was not shortest
+		rapidjson::Document grisuDoc, ryuDoc;
+		grisuText.back() = ']';
+		std::string ryuText(buffer.GetString(), buffer.GetSize());
+		ryuText.back() = ']';
+		grisuDoc.Parse<rapidjson::kParseFullPrecisionFlag>(("[" + grisuText).c_str());
+		ryuDoc.Parse<rapidjson::kParseFullPrecisionFlag>(("[" + ryuText).c_str());
+		bool same = !grisuDoc.HasParseError() && !ryuDoc.HasParseError() && grisuDoc == ryuDoc;
+
+		double writer = AverageMicroseconds(repeats, [&]() {
+			buffer.Clear();
+			rapidjson::Writer<rapidjson::StringBuffer> w(buffer);
+			w.StartArray();
+			for (double value : *set.Values)
+				w.Double(value);
+			w.EndArray();
+			});
+		std::cout << "  " << set.Label << ": Grisu2 " << MegabytesPerSecond(grisuText.size(), grisu) << ", Ryu " << MegabytesPerSecond(bytes, ryu)
+			<< " (" << (ryu > 0 ? grisu / ryu : 0) << "x), Writer " << MegabytesPerSecond(buffer.GetSize(), writer)
+			<< ", same values " << (same ? "yes" : "NO") << std::endl;
+	}
+
+	double ints = AverageMicroseconds(repeats, [&]() {
+		buffer.Clear();
+		rapidjson::Writer<rapidjson::StringBuffer> w(buffer);
+		w.StartArray();
+		for (int64_t id : sets.Ids)
+			w.Int64(id);
+		w.EndArray();
+		});
+	std::cout << "  int64 ids     : Writer " << MegabytesPerSecond(buffer.GetSize(), ints) << std::endl;
+
+	double stats = AverageMicroseconds(repeats, [&]() {
+		buffer.Clear();
+		rapidjson::Writer<rapidjson::StringBuffer> w(buffer);
+		w.StartArray();
+		for (size_t i = 0; i < valueCount / 6; i++)
+		{
+			const HeroStats& s = heroes[i % heroes.size()].Powerstats();
+			w.StartArray();
+			w.Int(s.Intelligence);
+			w.Int(s.Strength);
+			w.Int(s.Speed);
+			w.Int(s.Durability);
+			w.Int(s.Power);
+			w.Int(s.Combat);
+			w.EndArray();
+		}
+		w.EndArray();
+		});
+	std::cout << "  hero stats    : Writer " << MegabytesPerSecond(buffer.GetSize(), stats) << std::endl;
+}
+
+void HeroBenchmarks::NumberParse(HeroesDB& heroDB, size_t valueCount, int repeats)
+{
+	if (heroDB.Heroes().empty() || valueCount == 0 || repeats <= 0)
+		return;
+
+	const NumberSets sets(valueCount);
+	struct DoubleSet
+	{
+		const char* Label;
+		const std::vector<double>* Values;
+	};
+	const DoubleSet doubleSets[] = { { "random doubles", &sets.RandomDoubles }, { "prices (x.yy) ", &sets.Prices }, { "whole doubles ", &sets.WholeDoubles } };
+
+	std::cout << "Number parse: " << valueCount << " values per document (" << repeats << " runs), MB/s and values read back exactly" << std::endl;
+	rapidjson::StringBuffer buffer;
+	rapidjson::Document doc;
+	for (const DoubleSet& set : doubleSets)
+	{
+		buffer.Clear();
+		rapidjson::Writer<rapidjson::StringBuffer> w(buffer);
+		w.StartArray();
+		for (double value : *set.Values)
+			w.Double(value);
+		w.EndArray();
+		const std::string text(buffer.GetString(), buffer.GetSize());
+
+		double normal = AverageMicroseconds(repeats, [&]() { doc.Parse(text.c_str(), text.size()); });
+		size_t normalExact = CountExact(doc, *set.Values);
+		double full = AverageMicroseconds(repeats, [&]() { doc.Parse<rapidjson::kParseFullPrecisionFlag>(text.c_str(), text.size()); });
+		size_t fullExact = CountExact(doc, *set.Values);
+
+		//the C library, one value after another, as a reference
+		double sum = 0;
+		double crt = AverageMicroseconds(repeats, [&]() {
+			char* end = const_cast<char*>(text.c_str());
+			for (size_t i = 0; i < set.Values->size(); i++)
+				sum += std::strtod(end + 1, &end);
+			});
+
+		std::cout << "  " << set.Label << ": Parse " << MegabytesPerSecond(text.size(), normal) << " (exact " << normalExact << ")"
+			<< ", full precision " << MegabytesPerSecond(text.size(), full) << " (exact " << fullExact << ")"
+			<< ", strtod " << MegabytesPerSecond(text.size(), crt) << (sum != sum ? " (NaN)" : "") << std::endl;
+	}
+
+	buffer.Clear();
+	rapidjson::Writer<rapidjson::StringBuffer> w(buffer);
+	w.StartArray();
+	for (int64_t id : sets.Ids)
+		w.Int64(id);
+	w.EndArray();
+	double ints = AverageMicroseconds(repeats, [&]() { doc.Parse(buffer.GetString(), buffer.GetSize()); });
+	std::cout << "  int64 ids     : Parse " << MegabytesPerSecond(buffer.GetSize(), ints) << std::endl;
+}
+
+void HeroBenchmarks::ParallelBuild(HeroesDB& heroDB, size_t heroCount, int repeats)
+{
+	typedef rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::ConcurrentMemoryPoolAllocator<>> ConcurrentDocument;
+
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || heroCount == 0 || repeats <= 0)
+		return;
+	const unsigned threadCount = std::max(2u, std::thread::hardware_concurrency());
+
+	//the hero array whole, and split into one array per thread
+	auto serialize = [&heroes](size_t begin, size_t end)
+		{
+			rapidjson::StringBuffer buffer;
+			rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+			writer.StartArray();
+			for (size_t i = begin; i < end; i++)
+				heroes[i % heroes.size()].Serialize(&writer);
+			writer.EndArray();
+			return std::string(buffer.GetString(), buffer.GetSize());
+		};
+	const std::string json = serialize(0, heroCount);
+	std::vector<std::string> parts;
+	std::vector<size_t> starts;
+	for (unsigned t = 0; t < threadCount; t++)
+	{
+		starts.push_back(heroCount * t / threadCount);
+		parts.push_back(serialize(heroCount * t / threadCount, heroCount * (t + 1) / threadCount));
+	}
+
+	rapidjson::Document reference;
+	double singleParse = AverageMicroseconds(repeats, [&]() {
+		rapidjson::Document doc;
+		doc.Parse(json.c_str(), json.size());
+		reference.Swap(doc);
+		});
+
+	//each thread parses its parts into documents sharing the pool and moves the heroes into their slots;
+	//Clear() hands the previous run's chunks back for reuse
+	ConcurrentDocument built;
+	bool ok = !reference.HasParseError();
+	auto build = [&](unsigned threads)
+		{
+			ConcurrentDocument::AllocatorType& allocator = built.GetAllocator();
+			allocator.Clear();
+			built.SetArray().Reserve(static_cast<rapidjson::SizeType>(heroCount), allocator);
+			for (size_t i = 0; i < heroCount; i++)
+				built.PushBack(ConcurrentDocument::ValueType().Move(), allocator);
+
+			std::atomic<bool> failed(false);
+			auto work = [&](unsigned first)
+				{
+					for (unsigned t = first; t < threadCount; t += threads)
+					{
+						ConcurrentDocument part(&allocator);
+						part.Parse(parts[t].c_str(), parts[t].size());
+						if (part.HasParseError())
+						{
+							failed = true;
+							continue;
+						}
+						for (rapidjson::SizeType i = 0; i < part.Size(); i++)
+							built[static_cast<rapidjson::SizeType>(starts[t]) + i] = part[i].Move();
+					}
+				};
+			std::vector<std::thread> workers;
+			for (unsigned w = 1; w < threads; w++)
+				workers.emplace_back(work, w);
+			work(0);
+			for (std::thread& worker : workers)
+				worker.join();
+			ok = ok && !failed;
+		};
+	double oneThread = AverageMicroseconds(repeats, [&]() { build(1); });
+	bool same = ok && built == reference;
+	double parallel = AverageMicroseconds(repeats, [&]() { build(threadCount); });
+	same = same && ok && built == reference;
+
+	size_t capacity = built.GetAllocator().Capacity();
+	double clear = AverageMicroseconds(1, [&]() {
+		built.SetNull();
+		built.GetAllocator().Clear();
+		});
+
+	std::cout << "Parallel DOM build: " << heroCount << " heroes, " << json.size() / (1 << 20) << " MB, " << threadCount << " threads ("
+		<< std::thread::hardware_concurrency() << " hardware, " << repeats << " runs)" << std::endl;
+	std::cout << "  Document::Parse:             " << singleParse / 1000 << " ms" << std::endl;
+	std::cout << "  Concurrent pool, 1 thread:   " << oneThread / 1000 << " ms" << std::endl;
+	std::cout << "  Concurrent pool, " << threadCount << " threads:  " << parallel / 1000 << " ms, speedup "
+		<< (parallel > 0 ? singleParse / parallel : 0) << "x" << std::endl;
+	std::cout << "  Clear " << capacity / (1 << 20) << " MB of chunks: " << clear << " us" << std::endl;
+	std::cout << "  Same document:               " << (same ? "yes" : "NO") << std::endl;
+}
+
+
+void HeroBenchmarks::Reparse(HeroesDB& heroDB, size_t heroCount, int rounds)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || heroCount == 0 || rounds <= 0)
+		return;
+
+	//one array of heroCount heroes, and the same heroes as one small document each, the way the change log replays them
+	std::string array;
+	std::vector<std::string> records;
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		writer.StartArray();
+		for (size_t i = 0; i < heroCount; i++)
+		{
+			rapidjson::StringBuffer record;
+			rapidjson::Writer<rapidjson::StringBuffer> recordWriter(record);
+			heroes[i % heroes.size()].Serialize(&recordWriter);
+			records.emplace_back(record.GetString(), record.GetSize());
+			heroes[i % heroes.size()].Serialize(&writer);
+		}
+		writer.EndArray();
+		array.assign(buffer.GetString(), buffer.GetSize());
+	}
+
+	//a new Document per parse, its chunks coming from and going back to the heap, vs. one allocator
+	//whose Clear() keeps them; the last round's counters show the steady state
+	bool ok = true;
+	auto fresh = [&](const std::string& json)
+		{
+			rapidjson::Document doc;
+			doc.Parse(json.c_str(), json.size());
+			ok = ok && !doc.HasParseError();
+		};
+	rapidjson::MemoryPoolAllocator<> pool;
+	pool.SetRetainedCapacity(SIZE_MAX);
+	auto reuse = [&](const std::string& json)
+		{
+			rapidjson::Document doc(&pool);
+			doc.Parse(json.c_str(), json.size());
+			ok = ok && !doc.HasParseError();
+			doc.SetNull();
+			pool.Clear();
+		};
+	auto measure = [&](const char* label, const std::vector<const std::string*>& documents)
+		{
+			double freshRound = AverageMicroseconds(rounds, [&]() {
+				for (const std::string* json : documents)
+					fresh(*json);
+				});
+			for (const std::string* json : documents)
+				reuse(*json);
+			pool.ResetStats();
+			double reuseRound = AverageMicroseconds(rounds, [&]() {
+				pool.ResetStats();
+				for (const std::string* json : documents)
+					reuse(*json);
+				});
+			const rapidjson::MemoryPoolAllocator<>::Stats& stats = pool.GetStats();
+			std::cout << "  " << label << ": new Document " << freshRound / 1000 << " ms, retained chunks " << reuseRound / 1000
+				<< " ms, speedup " << (reuseRound > 0 ? freshRound / reuseRound : 0) << "x" << std::endl;
+			std::cout << "    per round: " << stats.requestedBytes / 1024 << " KB requested, " << stats.wastedBytes / 1024 << " KB wasted at chunk ends, "
+				<< stats.chunkReuses << " chunks reused, " << stats.chunkAllocations << " allocated, " << stats.chunkFrees << " freed"
+				<< ", " << pool.Capacity() / 1024 << " KB kept" << std::endl;
+			pool.SetRetainedCapacity(0);
+			pool.Clear();
+			pool.SetRetainedCapacity(SIZE_MAX);
+		};
+
+	std::cout << "Steady-state reparse: " << heroCount << " heroes, " << array.size() / (1 << 20) << " MB (" << rounds << " rounds)" << std::endl;
+	measure("One array       ", { &array });
+	std::vector<const std::string*> recordPointers;
+	for (const std::string& record : records)
+		recordPointers.push_back(&record);
+	measure("One per hero    ", recordPointers);
+	std::cout << "  All parsed:      " << (ok ? "yes" : "NO") << std::endl;
+}
+
+void HeroBenchmarks::PointerLookup(HeroesDB& heroDB, size_t heroCount, int repeats)
+{
+	const std::vector<Hero>& heroes = heroDB.Heroes();
+	if (heroes.empty() || heroCount == 0 || repeats <= 0)
+		return;
+
+	//20 fields of a hero, sharing the prefixes of its sections
+	const char* paths[] = { "/id", "/name",
+		"/powerstats/intelligence", "/powerstats/strength", "/powerstats/speed", "/powerstats/durability", "/powerstats/power", "/powerstats/combat",
+		"/appearance/gender", "/appearance/race", "/appearance/height/1", "/appearance/weight/1", "/appearance/eyeColor", "/appearance/hairColor",
+		"/biography/fullName", "/biography/publisher", "/biography/alignment",
+		"/work/occupation", "/connections/relatives", "/images/md" };
+	const size_t pathCount = sizeof(paths) / sizeof(paths[0]);
+	std::vector<rapidjson::Pointer> pointers;
+	rapidjson::PointerSet set;
+	std::vector<size_t> slots;
+	for (const char* path : paths)
+	{
+		pointers.emplace_back(path);
+		slots.push_back(set.Add(pointers.back()));
+	}
+
+	//values folded into a number so both sides can be compared
+	auto fold = [](const rapidjson::Value* value) -> size_t
+		{
+			if (!value)
+				return 1;
+			if (value->IsString())
+				return value->GetStringLength();
+			return value->IsInt() ? static_cast<size_t>(value->GetInt()) : 2;
+		};
+
+	std::vector<std::string> records;
+	rapidjson::Document doc;
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		writer.StartArray();
+		for (size_t i = 0; i < heroCount; i++)
+		{
+			rapidjson::StringBuffer record;
+			rapidjson::Writer<rapidjson::StringBuffer> recordWriter(record);
+			heroes[i % heroes.size()].Serialize(&recordWriter);
+			records.emplace_back(record.GetString(), record.GetSize());
+			heroes[i % heroes.size()].Serialize(&writer);
+		}
+		writer.EndArray();
+		doc.Parse(buffer.GetString(), buffer.GetSize());
+	}
+
+	//DOM: one Pointer::Get per field vs. one traversal of the trie per hero
+	size_t singleSum = 0, setSum = 0;
+	double singleGet = AverageMicroseconds(repeats, [&]() {
+		singleSum = 0;
+		for (const rapidjson::Value& hero : doc.GetArray())
+			for (const rapidjson::Pointer& pointer : pointers)
+				singleSum += fold(pointer.Get(hero));
+		});
+	std::vector<const rapidjson::Value*> found(set.Size());
+	double setGet = AverageMicroseconds(repeats, [&]() {
+		setSum = 0;
+		for (const rapidjson::Value& hero : doc.GetArray())
+		{
+			set.Get(hero, found.data());
+			for (size_t i = 0; i < pathCount; i++)
+				setSum += fold(found[slots[i]]);
+		}
+		});
+
+	//text: a DOM per record and then Pointer::Get vs. the set reading the SAX events without a DOM
+	size_t domSum = 0, saxSum = 0;
+	bool ok = !doc.HasParseError();
+	double domText = AverageMicroseconds(repeats, [&]() {
+		domSum = 0;
+		for (const std::string& record : records)
+		{
+			rapidjson::Document recordDoc;
+			recordDoc.Parse(record.c_str(), record.size());
+			ok = ok && !recordDoc.HasParseError();
+			for (const rapidjson::Pointer& pointer : pointers)
+				domSum += fold(pointer.Get(recordDoc));
+		}
+		});
+	rapidjson::MemoryPoolAllocator<> valueAllocator;
+	std::vector<rapidjson::Value> values(set.Size());
+	std::unique_ptr<bool[]> resolved(new bool[set.Size()]);
+	double saxText = AverageMicroseconds(repeats, [&]() {
+		saxSum = 0;
+		for (const std::string& record : records)
+		{
+			ok = ok && !set.Parse(record.c_str(), record.size(), values.data(), resolved.get(), valueAllocator).IsError();
+			for (size_t i = 0; i < pathCount; i++)
+				saxSum += fold(resolved[slots[i]] ? &values[slots[i]] : nullptr);
+			valueAllocator.Clear();
+		}
+		});
+
+	std::cout << "JSON pointer set: " << pathCount << " pointers, " << heroCount << " heroes (" << repeats << " runs)" << std::endl;
+	std::cout << "  DOM:  Pointer::Get " << singleGet / 1000 << " ms, pointer set " << setGet / 1000 << " ms, speedup "
+		<< (setGet > 0 ? singleGet / setGet : 0) << "x" << std::endl;
+	std::cout << "  Text: DOM + Get " << domText / 1000 << " ms, pointer set over SAX " << saxText / 1000 << " ms, speedup "
+		<< (saxText > 0 ? domText / saxText : 0) << "x" << std::endl;
+	std::cout << "  Same values: " << (ok && singleSum == setSum && singleSum == domSum && domSum == saxSum ? "yes" : "NO") << std::endl;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "HeroesDB.h"
+
+// Timing harnesses for the HeroesDB engines. Each prints its results to std::cout.
+class HeroBenchmarks final
+{
+public:
+    // Existing MergeSort over Hero copies vs. the counting sort over (stat, index) pairs.
+    static void SortByAttribute(HeroesDB& heroDB, SortBy sortBy, int repeats = 20);
+    // k-NN brute force vs. KD-tree per metric over heroCount synthetic heroes sampled from heroDB.
+    static void SimilarHeroes(HeroesDB& heroDB, size_t heroCount = 1000000, int queries = 200, size_t k = 20);
+    // Building heroCount heroes from parsed JSON and destroying them, default heap vs. a monotonic arena.
+    static void LoadAndDestroy(HeroesDB& heroDB, size_t heroCount = 200000, int repeats = 5);
+    // Hero::Deserialize through HeroFieldMap vs. the old obj["key"] lookup per field.
+    static void Deserialize(HeroesDB& heroDB, size_t heroCount = 200000, int repeats = 5);
+    // Document::Parse (with and without length) and ParseInsitu MB/s per runtime-dispatched SIMD level, on a hero array and on long strings.
+    static void ParseJson(HeroesDB& heroDB, size_t targetBytes = 64 << 20, int repeats = 5);
+    // DOM parse vs. on-demand reading of heroCount heroes from JSON text, loading whole heroes and reading a few fields.
+    static void OnDemand(HeroesDB& heroDB, size_t heroCount = 200000, int repeats = 5);
+    // Writer/PrettyWriter output of heroCount heroes on one thread vs. split across threads, from Hero::Serialize and from a DOM.
+    static void ParallelWrite(HeroesDB& heroDB, size_t heroCount = 200000, int repeats = 5);
+    // MB/s of number-heavy documents: Grisu2 vs. Ryu double formatting, and Writer output of doubles and integers.
+    static void NumberWrite(HeroesDB& heroDB, size_t valueCount = 2000000, int repeats = 5);
+    // MB/s of reading the same documents back, default vs. full precision vs. strtod, and how many values come back exact.
+    static void NumberParse(HeroesDB& heroDB, size_t valueCount = 2000000, int repeats = 5);
+    // One DOM of heroCount heroes: Document::Parse vs. parts parsed on several threads into a shared ConcurrentMemoryPoolAllocator.
+    static void ParallelBuild(HeroesDB& heroDB, size_t heroCount = 200000, int repeats = 5);
+    // Parsing the same documents round after round, a new Document each time vs. one MemoryPoolAllocator retaining its chunks.
+    static void Reparse(HeroesDB& heroDB, size_t heroCount = 20000, int rounds = 20);
+    // 20 JSON pointers per hero: Pointer::Get one at a time vs. a PointerSet, over a DOM and over the text without one.
+    static void PointerLookup(HeroesDB& heroDB, size_t heroCount = 100000, int repeats = 5);
+};
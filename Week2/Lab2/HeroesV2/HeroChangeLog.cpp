@@ -0,0 +1,197 @@
+#include "HeroChangeLog.h"
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char LogMagic[4] = { 'H', 'W', 'A', 'L' };
+	const uint32_t LogVersion = 1;
+	const size_t HeaderSize = sizeof(LogMagic) + sizeof(uint32_t);
+	const size_t RecordOverhead = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t);
+
+	void PutU32(std::string& out, uint32_t value)
+	{
+		char bytes[4];
+		for (int i = 0; i < 4; i++)
+			bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+		out.append(bytes, 4);
+	}
+
+	uint32_t GetU32(const char* in)
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < 4; i++)
+			value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+		return value;
+	}
+}
+
+HeroChangeLog::HeroChangeLog(size_t groupCommitBytes, size_t groupCommitRecords) :
+	_file(nullptr),
+	_pendingRecords(0),
+	_recordCount(0),
+	_groupCommitBytes(groupCommitBytes),
+	_groupCommitRecords(groupCommitRecords)
+{ }
+
+HeroChangeLog::~HeroChangeLog()
+{
+	Close();
+}
+
+bool HeroChangeLog::Open(const std::string& path, const std::function<void(const HeroChange&)>& replay)
+{
+	Close();
+	_path = path;
+	_recordCount = 0;
+
+	std::string contents;
+	if (std::FILE* in = std::fopen(path.c_str(), "rb"))
+	{
+		char chunk[64 * 1024];
+		size_t read;
+		while ((read = std::fread(chunk, 1, sizeof(chunk), in)) > 0)
+			contents.append(chunk, read);
+		std::fclose(in);
+	}
+
+	//walk the records, stopping at the first one that is incomplete or fails its checksum
+	size_t goodEnd = 0;
+	if (contents.size() >= HeaderSize &&
+		std::memcmp(contents.data(), LogMagic, sizeof(LogMagic)) == 0 &&
+		GetU32(contents.data() + sizeof(LogMagic)) == LogVersion)
+	{
+		size_t pos = HeaderSize;
+		while (contents.size() - pos >= RecordOverhead)
+		{
+			uint32_t size = GetU32(contents.data() + pos);
+			if (contents.size() - pos - RecordOverhead < size)
+				break;
+
+			uint8_t op = static_cast<uint8_t>(contents[pos + 4]);
+			const char* payload = contents.data() + pos + 5;
+			if (Checksum(op, payload, size) != GetU32(payload + size))
+				break;
+
+			HeroChange change{ static_cast<HeroChangeOp>(op), std::string(payload, size) };
+			replay(change);
+			++_recordCount;
+			pos += RecordOverhead + size;
+		}
+		goodEnd = pos;
+	}
+
+	if (goodEnd == contents.size() && goodEnd != 0)
+	{
+		_file = std::fopen(path.c_str(), "ab");
+		return _file != nullptr;
+	}
+
+	//new, foreign or torn log: rewrite it with just the valid prefix
+	_file = std::fopen(path.c_str(), "wb");
+	if (_file == nullptr)
+		return false;
+	if (goodEnd == 0)
+		return WriteHeader();
+	return std::fwrite(contents.data(), 1, goodEnd, _file) == goodEnd && SyncFile(_file);
+}
+
+void HeroChangeLog::Close()
+{
+	if (_file == nullptr)
+		return;
+	Flush();
+	std::fclose(_file);
+	_file = nullptr;
+}
+
+void HeroChangeLog::Append(HeroChangeOp op, const std::string& payload)
+{
+	uint8_t opByte = static_cast<uint8_t>(op);
+	PutU32(_buffer, static_cast<uint32_t>(payload.size()));
+	_buffer.push_back(static_cast<char>(opByte));
+	_buffer.append(payload);
+	PutU32(_buffer, Checksum(opByte, payload.data(), payload.size()));
+	++_pendingRecords;
+	++_recordCount;
+
+	if (_buffer.size() >= _groupCommitBytes || _pendingRecords >= _groupCommitRecords)
+		Flush();
+}
+
+bool HeroChangeLog::Flush()
+{
+	if (_file == nullptr || _buffer.empty())
+		return _buffer.empty();
+
+	bool ok = std::fwrite(_buffer.data(), 1, _buffer.size(), _file) == _buffer.size() && SyncFile(_file);
+	_buffer.clear();
+	_pendingRecords = 0;
+	return ok;
+}
+
+bool HeroChangeLog::Reset()
+{
+	_buffer.clear();
+	_pendingRecords = 0;
+	_recordCount = 0;
+	if (_file != nullptr)
+		std::fclose(_file);
+
+	_file = std::fopen(_path.c_str(), "wb");
+	return _file != nullptr && WriteHeader();
+}
+
+bool HeroChangeLog::WriteHeader()
+{
+	std::string header(LogMagic, sizeof(LogMagic));
+	PutU32(header, LogVersion);
+	return std::fwrite(header.data(), 1, header.size(), _file) == header.size() && SyncFile(_file);
+}
+
+bool HeroChangeLog::SyncFile(std::FILE* file)
+{
+	if (std::fflush(file) != 0)
+		return false;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool HeroChangeLog::ReplaceFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	//rename swaps the directory entry atomically, but it only survives a power loss once the directory is synced
+	if (std::rename(from.c_str(), to.c_str()) != 0)
+		return false;
+	size_t slash = to.find_last_of('/');
+	std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : to.substr(0, slash);
+	int fd = open(directory.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	bool ok = fsync(fd) == 0;
+	close(fd);
+	return ok;
+#endif
+}
+
+//FNV-1a over the op byte and the payload
+uint32_t HeroChangeLog::Checksum(uint8_t op, const char* data, size_t size)
+{
+	uint32_t hash = 2166136261u;
+	hash = (hash ^ op) * 16777619u;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+	return hash;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+// Operations recorded in the change log. Values are written to disk, so never renumber them.
+enum class HeroChangeOp : uint8_t
+{
+    Add = 1,
+    Update,
+    Remove,
+    RemoveAll
+};
+
+struct HeroChange
+{
+    HeroChangeOp Op;
+    std::string Payload;    // hero JSON for Add/Update, hero name for Remove, empty for RemoveAll
+};
+
+// Append-only binary log of HeroesDB mutations.
+//
+// Each record is [uint32 size][uint8 op][payload][uint32 checksum]. Appends go into an
+// in-memory buffer and are written with a single write + flush once a group fills up
+// (group commit), so a mutation costs one buffered append instead of a full JSON rewrite.
+// A torn or corrupt tail (e.g. after a crash mid-write) is dropped on replay.
+class HeroChangeLog
+{
+public:
+    HeroChangeLog(size_t groupCommitBytes = 64 * 1024, size_t groupCommitRecords = 64);
+    ~HeroChangeLog();
+
+    HeroChangeLog(const HeroChangeLog&) = delete;
+    HeroChangeLog& operator=(const HeroChangeLog&) = delete;
+
+    // Opens (or creates) the log and calls replay for every valid record already in it.
+    bool Open(const std::string& path, const std::function<void(const HeroChange&)>& replay);
+    void Close();
+
+    void Append(HeroChangeOp op, const std::string& payload);
+    bool Flush();
+
+    // Truncates the log. Call only after the current state has been written to a snapshot.
+    bool Reset();
+
+    bool IsOpen() const { return _file != nullptr; }
+    size_t RecordCount() const { return _recordCount; }
+    size_t BufferedBytes() const { return _buffer.capacity(); }
+    const std::string& Path() const { return _path; }
+
+    // Flushes file and forces its contents to disk.
+    static bool SyncFile(std::FILE* file);
+    // Replaces to with from in one step: after a crash, to is either the old file or the whole new one.
+    static bool ReplaceFile(const std::string& from, const std::string& to);
+
+private:
+    std::FILE* _file;
+    std::string _path;
+    std::string _buffer;
+    size_t _pendingRecords;
+    size_t _recordCount;
+    size_t _groupCommitBytes;
+    size_t _groupCommitRecords;
+
+    bool WriteHeader();
+    static uint32_t Checksum(uint8_t op, const char* data, size_t size);
+};
@@ -0,0 +1,70 @@
+#include "HeroColumns.h"
+#include "HeroMemoryReport.h"
+#include <unordered_map>
+
+void HeroColumns::Build(const std::vector<Hero>& heroes)
+{
+	Clear();
+	_size = heroes.size();
+
+	for (int s = 0; s < SortKeyCount; s++)
+	{
+		SortBy stat = static_cast<SortBy>(s + 1);
+		_stats[s].resize(_size);
+		for (size_t i = 0; i < _size; i++)
+			_stats[s][i] = heroes[i].GetSortByValue(stat);
+	}
+
+	for (int g = 0; g < GroupByCount; g++)
+	{
+		GroupBy groupBy = static_cast<GroupBy>(g + 1);
+		std::unordered_map<std::string, uint32_t> dictionary;
+		_codes[g].resize(_size);
+		for (size_t i = 0; i < _size; i++)
+		{
+			const HeroString& value = GroupValue(heroes[i], groupBy);
+			auto inserted = dictionary.emplace(std::string(value), static_cast<uint32_t>(_labels[g].size()));
+			if (inserted.second)
+				_labels[g].push_back(inserted.first->first);
+			_codes[g][i] = inserted.first->second;
+		}
+	}
+	_built = true;
+}
+
+void HeroColumns::Clear()
+{
+	for (auto& column : _stats)
+		column.clear();
+	for (auto& column : _codes)
+		column.clear();
+	for (auto& labels : _labels)
+		labels.clear();
+	_size = 0;
+	_built = false;
+}
+
+size_t HeroColumns::MemoryBytes() const
+{
+	size_t bytes = 0;
+	for (const auto& column : _stats)
+		bytes += HeroMemoryReport::HeapBytes(column);
+	for (const auto& column : _codes)
+		bytes += HeroMemoryReport::HeapBytes(column);
+	for (const auto& labels : _labels)
+		bytes += HeroMemoryReport::HeapBytes(labels);
+	return bytes;
+}
+
+const HeroString& HeroColumns::GroupValue(const Hero& hero, GroupBy groupBy)
+{
+	static const HeroString none;
+	switch (groupBy)
+	{
+	case GroupByPublisher: return hero.Biography().Publisher;
+	case GroupByAlignment: return hero.Biography().Alignment;
+	case GroupByRace: return hero.Appearance().Race;
+	case GroupByGender: return hero.Appearance().Gender;
+	default: return none;
+	}
+}
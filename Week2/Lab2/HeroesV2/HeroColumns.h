@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Hero.h"
+#include "enums.h"
+
+// Column-oriented copy of the hero fields used for scans: one contiguous array per
+// sort key (powerstats, height in cm, weight in kg) and a dictionary-encoded code array
+// per groupable text field.
+class HeroColumns
+{
+public:
+    static const int SortKeyCount = 8;
+    static const int GroupByCount = 4;
+
+    void Build(const std::vector<Hero>& heroes);
+    void Clear();
+    bool IsBuilt() const { return _built; }
+    size_t Size() const { return _size; }
+    size_t MemoryBytes() const;
+
+    const std::vector<int>& Stat(SortBy stat) const { return _stats[stat - 1]; }
+    const std::vector<uint32_t>& Codes(GroupBy groupBy) const { return _codes[groupBy - 1]; }
+    // Label for each code; missing values get an empty label.
+    const std::vector<std::string>& Labels(GroupBy groupBy) const { return _labels[groupBy - 1]; }
+
+    static const HeroString& GroupValue(const Hero& hero, GroupBy groupBy);
+
+private:
+    std::vector<int> _stats[SortKeyCount];
+    std::vector<uint32_t> _codes[GroupByCount];
+    std::vector<std::string> _labels[GroupByCount];
+    size_t _size = 0;
+    bool _built = false;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A seekable position within a cached hero permutation.
+//
+// A cursor covers the slice [begin, end) of a permutation owned by HeroesDB (a full
+// ordering, or the contiguous run of it that matches a filter). Fetching a page copies
+// at most PageSize indices into a caller-owned buffer, so paging costs O(page) time and
+// no memory beyond that buffer. Cursors remember the DB generation they were opened at;
+// HeroesDB refuses to fetch from a cursor once the heroes have changed.
+class HeroCursor
+{
+public:
+    HeroCursor() = default;
+    HeroCursor(std::shared_ptr<const std::vector<size_t>> order, size_t begin, size_t end, size_t pageSize, uint64_t generation) :
+        _order(std::move(order)), _begin(begin), _end(end), _position(0), _pageSize(pageSize == 0 ? 1 : pageSize), _generation(generation)
+    { }
+
+    size_t Count() const { return _end - _begin; }
+    size_t Position() const { return _position; }
+    size_t PageSize() const { return _pageSize; }
+    size_t PageCount() const { return (Count() + _pageSize - 1) / _pageSize; }
+    size_t CurrentPage() const { return _position / _pageSize; }
+    bool AtEnd() const { return _position >= Count(); }
+    uint64_t Generation() const { return _generation; }
+
+    void Seek(size_t position) { _position = position < Count() ? position : Count(); }
+    void SeekPage(size_t page) { Seek(page * _pageSize); }
+
+    // Copies the next page of hero indices into page and advances. Returns false at the end.
+    bool Next(std::vector<size_t>& page)
+    {
+        page.clear();
+        if (!_order || AtEnd())
+            return false;
+        size_t from = _begin + _position;
+        size_t to = from + _pageSize < _end ? from + _pageSize : _end;
+        page.insert(page.end(), _order->begin() + from, _order->begin() + to);
+        _position += to - from;
+        return true;
+    }
+
+private:
+    std::shared_ptr<const std::vector<size_t>> _order;
+    size_t _begin = 0;
+    size_t _end = 0;
+    size_t _position = 0;
+    size_t _pageSize = 1;
+    uint64_t _generation = 0;
+};
@@ -0,0 +1,205 @@
+#include "HeroDedupe.h"
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+	const uint64_t ConfirmSeed = 0x9e3779b97f4a7c15ULL;
+	const char FieldEnd = '\x1f';
+	const char ListEnd = '\x1e';
+
+	//byte -> canonical byte: ASCII letters lowercased, every whitespace byte mapped to ' '
+	struct FoldTable
+	{
+		char Map[256];
+		FoldTable()
+		{
+			for (int c = 0; c < 256; c++)
+				Map[c] = static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+			Map[static_cast<unsigned char>('\t')] = Map[static_cast<unsigned char>('\r')] = Map[static_cast<unsigned char>('\n')] = ' ';
+		}
+	};
+	const FoldTable Fold;
+
+	void AppendText(std::string& out, const HeroString& value)
+	{
+		//at most one output byte per input byte plus the terminator; trimmed back below
+		size_t start = out.size();
+		out.resize(start + value.size() + 1);
+		char* begin = &out[start];
+		char* write = begin;
+		for (char c : value)
+		{
+			//always store, but only advance past a space that starts a run and is not leading
+			char folded = Fold.Map[static_cast<unsigned char>(c)];
+			*write = folded;
+			bool skip = folded == ' ' && (write == begin || write[-1] == ' ');
+			write += skip ? 0 : 1;
+		}
+		if (write != begin && write[-1] == ' ')
+			--write;
+		*write++ = FieldEnd;
+		out.resize(write - out.data());
+	}
+
+	void AppendList(std::string& out, const HeroStringList& values)
+	{
+		for (const auto& value : values)
+			AppendText(out, value);
+		out.push_back(ListEnd);
+	}
+
+	void AppendInt(std::string& out, int value)
+	{
+		char bytes[sizeof(value)];
+		std::memcpy(bytes, &value, sizeof(value));
+		out.append(bytes, sizeof(bytes));
+	}
+}
+
+void HeroDedupe::Canonicalize(const Hero& hero, std::string& out)
+{
+	out.clear();
+	AppendText(out, hero.Name());
+
+	const HeroStats& stats = hero.Powerstats();
+	AppendInt(out, stats.Intelligence);
+	AppendInt(out, stats.Strength);
+	AppendInt(out, stats.Speed);
+	AppendInt(out, stats.Durability);
+	AppendInt(out, stats.Power);
+	AppendInt(out, stats.Combat);
+
+	const HeroAppearance& appearance = hero.Appearance();
+	AppendText(out, appearance.Gender);
+	AppendText(out, appearance.Race);
+	AppendList(out, appearance.Height);
+	AppendList(out, appearance.Weight);
+	AppendText(out, appearance.EyeColor);
+	AppendText(out, appearance.HairColor);
+
+	const HeroBio& bio = hero.Biography();
+	AppendText(out, bio.FullName);
+	AppendText(out, bio.AlterEgos);
+	AppendList(out, bio.Aliases);
+	AppendText(out, bio.PlaceOfBirth);
+	AppendText(out, bio.FirstAppearance);
+	AppendText(out, bio.Publisher);
+	AppendText(out, bio.Alignment);
+
+	AppendText(out, hero.Work().Occupation);
+	AppendText(out, hero.Work().Base);
+	AppendText(out, hero.Connections().GroupAffiliation);
+	AppendText(out, hero.Connections().Relatives);
+
+	const HeroImages& images = hero.Images();
+	AppendText(out, images.XS);
+	AppendText(out, images.SM);
+	AppendText(out, images.MD);
+	AppendText(out, images.LG);
+}
+
+uint64_t HeroDedupe::ContentHash(const Hero& hero)
+{
+	std::string canonical;
+	Canonicalize(hero, canonical);
+	return Hash64(canonical.data(), canonical.size());
+}
+
+uint64_t HeroDedupe::Hash64(const void* data, size_t size, uint64_t seed)
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t h = seed ^ (size * m);
+
+	size_t blocks = size / 8;
+	for (size_t i = 0; i < blocks; i++)
+	{
+		uint64_t k;
+		std::memcpy(&k, bytes + i * 8, 8);
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+		h ^= k;
+		h *= m;
+	}
+
+	const unsigned char* tail = bytes + blocks * 8;
+	switch (size & 7)
+	{
+	case 7: h ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
+	case 6: h ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
+	case 5: h ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
+	case 4: h ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
+	case 3: h ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
+	case 2: h ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
+	case 1: h ^= static_cast<uint64_t>(tail[0]);
+		h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+	return h;
+}
+
+std::vector<HeroDuplicate> HeroDedupe::Find(const std::vector<Hero>& heroes)
+{
+	std::vector<HeroDuplicate> duplicates;
+	struct Content
+	{
+		uint64_t Confirm;
+		uint32_t Index;
+	};
+	std::unordered_map<uint64_t, Content> byContent;
+	std::unordered_map<int, uint32_t> byId;
+	std::string canonical;
+
+	for (size_t i = 0; i < heroes.size(); i++)
+	{
+		Canonicalize(heroes[i], canonical);
+		uint64_t hash = Hash64(canonical.data(), canonical.size());
+
+		uint64_t confirm = Hash64(canonical.data(), canonical.size(), ConfirmSeed);
+
+		auto content = byContent.find(hash);
+		if (content != byContent.end())
+		{
+			if (content->second.Confirm == confirm)
+			{
+				duplicates.push_back({ i, content->second.Index, HeroDuplicateKind::Exact });
+				continue;
+			}
+			//a genuine 64-bit collision: this hero stays unique but is not indexed by content
+		}
+
+		auto id = byId.find(heroes[i].Id());
+		if (id != byId.end())
+		{
+			duplicates.push_back({ i, id->second, HeroDuplicateKind::IdCollision });
+			continue;
+		}
+
+		byContent.emplace(hash, Content{ confirm, static_cast<uint32_t>(i) });
+		byId.emplace(heroes[i].Id(), static_cast<uint32_t>(i));
+	}
+	return duplicates;
+}
+
+void HeroDedupe::Print(const std::vector<Hero>& heroes, const std::vector<HeroDuplicate>& duplicates)
+{
+	size_t exact = 0;
+	for (const auto& duplicate : duplicates)
+	{
+		const Hero& hero = heroes[duplicate.Index];
+		const Hero& kept = heroes[duplicate.KeptIndex];
+		bool isExact = duplicate.Kind == HeroDuplicateKind::Exact;
+		exact += isExact ? 1 : 0;
+		std::cout << hero.Id() << ": " << hero.Name() << (isExact ? " duplicates " : " shares its id with ")
+			<< kept.Id() << ": " << kept.Name() << std::endl;
+	}
+	std::cout << duplicates.size() << " duplicates among " << heroes.size() << " heroes (" << exact << " exact, "
+		<< duplicates.size() - exact << " id collisions)" << std::endl;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Hero.h"
+
+enum class HeroDuplicateKind
+{
+    Exact,          // same content, whatever the id
+    IdCollision     // same id, different content
+};
+
+struct HeroDuplicate
+{
+    size_t Index;       // the later record
+    size_t KeptIndex;   // the first record it duplicates
+    HeroDuplicateKind Kind;
+};
+
+// Duplicate detection for hero imports.
+//
+// Each hero's content (every field but the id) is canonicalized: strings are trimmed, runs
+// of whitespace collapse to one space and ASCII letters are lowercased, while field and list
+// boundaries are kept. One pass hashes that text and checks two hash maps, one by content
+// hash and one by id, so both kinds of duplicate are found in O(n). A content match is
+// confirmed by a second, independently seeded hash of the same text rather than by
+// re-canonicalizing the earlier record. The maps hold one entry per unique hero.
+class HeroDedupe final
+{
+public:
+    static std::vector<HeroDuplicate> Find(const std::vector<Hero>& heroes);
+    static void Print(const std::vector<Hero>& heroes, const std::vector<HeroDuplicate>& duplicates);
+
+    static void Canonicalize(const Hero& hero, std::string& out);
+    static uint64_t ContentHash(const Hero& hero);
+    // MurmurHash64A: eight bytes per step, good spread, not cryptographic.
+    static uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+};
@@ -0,0 +1,534 @@
+#include "HeroExternalSort.h"
+#include "HeroMeasures.h"
+#include "HeroScript.h"
+#include "rapidjson/filereadstream.h"
+#include "rapidjson/reader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+	const char IndexMagic[4] = { 'H', 'I', 'D', 'X' };
+	const uint32_t IndexVersion = 1;
+
+	struct IndexHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint32_t SortKey;
+		uint32_t Reserved;
+		uint64_t Count;
+		uint64_t SourceSize;
+	};
+
+	const char* StatNames[] = { "intelligence", "strength", "speed", "durability", "power", "combat" };
+
+	//SAX handler that turns each top-level object into a record and pulls out its sort key
+	class RecordHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, RecordHandler>
+	{
+	public:
+		RecordHandler(const rapidjson::FileReadStream& stream, uint64_t base, SortBy sortBy,
+			std::vector<HeroExternalSort::Record>& records, size_t capacity, const std::function<bool()>& spill) :
+			_stream(stream), _base(base), _sortBy(sortBy), _records(records), _capacity(capacity), _spill(spill),
+			_measures(std::pmr::new_delete_resource())
+		{ }
+
+		bool Default() { return true; }
+		bool Null() { return true; }
+		bool Int(int i) { return Value(i); }
+		bool Uint(unsigned u) { return Value(static_cast<int>(std::min<unsigned>(u, INT32_MAX))); }
+		bool Int64(int64_t i) { return Value(static_cast<int>(std::clamp<int64_t>(i, INT32_MIN, INT32_MAX))); }
+		bool Uint64(uint64_t u) { return Value(static_cast<int>(std::min<uint64_t>(u, INT32_MAX))); }
+		bool Double(double d) { return Value(static_cast<int>(std::clamp(d, -2147483648.0, 2147483647.0))); }
+
+		bool String(const char* s, rapidjson::SizeType length, bool)
+		{
+			if (_depth == 4 && _collecting)
+				_measures.emplace_back(s, length);
+			return true;
+		}
+
+		bool Key(const char* s, rapidjson::SizeType length, bool)
+		{
+			if (_depth == 2)
+				_section.assign(s, length);
+			else if (_depth == 3)
+				_field.assign(s, length);
+			return true;
+		}
+
+		bool StartObject()
+		{
+			if (_depth == 1)
+			{
+				_start = _base + _stream.Tell() - 1;
+				_key = 0;
+			}
+			if (_depth == 2)
+				_field.clear();
+			_depth++;
+			return true;
+		}
+
+		bool EndObject(rapidjson::SizeType)
+		{
+			_depth--;
+			if (_depth != 1)
+				return true;
+			uint64_t end = _base + _stream.Tell();
+			_records.push_back({ _key, static_cast<uint32_t>(end - _start), _start });
+			return _records.size() < _capacity || _spill();
+		}
+
+		bool StartArray()
+		{
+			if (_depth == 0)
+				_sawArray = true;
+			_collecting = _depth == 3 && _section == "appearance" &&
+				((_sortBy == Height && _field == "height") || (_sortBy == Weight && _field == "weight"));
+			if (_collecting)
+				_measures.clear();
+			_depth++;
+			return true;
+		}
+
+		bool EndArray(rapidjson::SizeType)
+		{
+			_depth--;
+			if (_depth == 3 && _collecting)
+			{
+				//same rounding as Hero::GetSortByValue
+				float value = _sortBy == Height ? HeroMeasures::ParseHeightCm(_measures) : HeroMeasures::ParseWeightKg(_measures);
+				_key = static_cast<int>(value + 0.5f);
+				_collecting = false;
+			}
+			return true;
+		}
+
+		bool SawArray() const { return _sawArray; }
+
+	private:
+		const rapidjson::FileReadStream& _stream;
+		uint64_t _base;
+		SortBy _sortBy;
+		std::vector<HeroExternalSort::Record>& _records;
+		size_t _capacity;
+		const std::function<bool()>& _spill;
+
+		int _depth = 0;
+		bool _sawArray = false;
+		bool _collecting = false;
+		uint64_t _start = 0;
+		int _key = 0;
+		std::string _section;
+		std::string _field;
+		std::pmr::vector<std::pmr::string> _measures;
+
+		bool Value(int value)
+		{
+			if (_depth == 3 && _sortBy <= Combat && _section == "powerstats" && _field == StatNames[_sortBy - 1])
+				_key = value;
+			return true;
+		}
+	};
+
+	//buffered sequential reader over one run
+	class RunReader
+	{
+	public:
+		RunReader(const std::string& path, size_t bufferRecords) :
+			_file(std::fopen(path.c_str(), "rb")), _buffer(std::max<size_t>(bufferRecords, 1))
+		{ }
+		~RunReader()
+		{
+			if (_file != nullptr)
+				std::fclose(_file);
+		}
+
+		bool IsOpen() const { return _file != nullptr; }
+
+		bool Next(HeroExternalSort::Record& record)
+		{
+			if (_position == _count)
+			{
+				_count = _file == nullptr ? 0 : std::fread(_buffer.data(), sizeof(HeroExternalSort::Record), _buffer.size(), _file);
+				_position = 0;
+				if (_count == 0)
+					return false;
+			}
+			record = _buffer[_position++];
+			return true;
+		}
+
+	private:
+		std::FILE* _file;
+		std::vector<HeroExternalSort::Record> _buffer;
+		size_t _position = 0;
+		size_t _count = 0;
+	};
+
+	//Tree of losers over k sources: each internal node keeps the source that lost the match
+	//played there, node 0 keeps the overall winner. Replacing the winner's record replays only
+	//its leaf-to-root path: log2(k) comparisons per output record.
+	class LoserTree
+	{
+	public:
+		LoserTree(std::vector<RunReader*>& sources) :
+			_sources(sources), _k(sources.size()), _heads(_k), _live(_k), _tree(_k, Exhausted)
+		{
+			for (size_t i = 0; i < _k; i++)
+				_live[i] = _sources[i]->Next(_heads[i]);
+			for (size_t i = 0; i < _k; i++)
+				Replay(i);
+		}
+
+		bool Pop(HeroExternalSort::Record& record)
+		{
+			size_t winner = _tree[0];
+			if (winner == Exhausted || !_live[winner])
+				return false;
+			record = _heads[winner];
+			_live[winner] = _sources[winner]->Next(_heads[winner]);
+			Replay(winner);
+			return true;
+		}
+
+	private:
+		static const size_t Exhausted = SIZE_MAX;
+
+		std::vector<RunReader*>& _sources;
+		size_t _k;
+		std::vector<HeroExternalSort::Record> _heads;
+		std::vector<bool> _live;
+		std::vector<size_t> _tree;
+
+		//true if source a should come out before source b; empty sources lose to everything
+		bool Beats(size_t a, size_t b) const
+		{
+			if (b == Exhausted || !_live[b])
+				return true;
+			if (a == Exhausted || !_live[a])
+				return false;
+			return _heads[a] < _heads[b];
+		}
+
+		void Replay(size_t leaf)
+		{
+			size_t winner = leaf;
+			for (size_t node = (leaf + _k) / 2; node > 0; node /= 2)
+			{
+				if (_tree[node] == Exhausted)
+				{
+					//still being built: park here and stop until the sibling arrives
+					_tree[node] = winner;
+					return;
+				}
+				if (Beats(_tree[node], winner))
+					std::swap(_tree[node], winner);
+			}
+			_tree[0] = winner;
+		}
+	};
+
+	//sources can be far past 2 GB, where long is too small on Windows
+	bool Seek(std::FILE* file, uint64_t offset, int origin)
+	{
+#ifdef _WIN32
+		return _fseeki64(file, static_cast<long long>(offset), origin) == 0;
+#else
+		return fseeko(file, static_cast<off_t>(offset), origin) == 0;
+#endif
+	}
+
+	uint64_t Tell(std::FILE* file)
+	{
+#ifdef _WIN32
+		return static_cast<uint64_t>(_ftelli64(file));
+#else
+		return static_cast<uint64_t>(ftello(file));
+#endif
+	}
+
+	double SecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+HeroExternalSort::HeroExternalSort(const Options& options) :
+	_options(options)
+{
+	_options.MemoryBudget = std::max<size_t>(_options.MemoryBudget, 4 * MinMergeBuffer);
+}
+
+bool HeroExternalSort::SortToIndex(const std::string& sourcePath, SortBy sortBy, const std::string& indexPath)
+{
+	auto start = std::chrono::steady_clock::now();
+	_stats = Stats();
+	std::string tempPrefix = (_options.TempDirectory.empty() ? indexPath : _options.TempDirectory + "/heroes") + ".run";
+
+	std::vector<std::string> runs;
+	bool ok = CreateRuns(sourcePath, sortBy, tempPrefix, runs);
+	_stats.Runs = runs.size();
+
+	//merge until one pass fits: each input needs at least MinMergeBuffer, plus one for output
+	size_t fanIn = std::max<size_t>(2, _options.MemoryBudget / MinMergeBuffer - 1);
+	size_t generation = 0;
+	while (ok && runs.size() > fanIn)
+	{
+		std::vector<std::string> merged;
+		for (size_t first = 0; ok && first < runs.size(); first += fanIn)
+		{
+			std::vector<std::string> group(runs.begin() + first, runs.begin() + std::min(runs.size(), first + fanIn));
+			std::string path = tempPrefix + std::to_string(++generation) + ".merge";
+			_tempFiles.push_back(path);
+			std::FILE* out = std::fopen(path.c_str(), "wb");
+			ok = out != nullptr && Merge(group, out, _options.MemoryBudget / (group.size() + 1) / sizeof(Record));
+			if (out != nullptr)
+				ok = std::fclose(out) == 0 && ok;
+			for (const auto& run : group)
+				std::remove(run.c_str());
+			merged.push_back(path);
+		}
+		runs.swap(merged);
+		_stats.MergePasses++;
+	}
+
+	std::FILE* out = ok ? std::fopen(indexPath.c_str(), "wb") : nullptr;
+	if (out != nullptr)
+	{
+		IndexHeader header{};
+		std::memcpy(header.Magic, IndexMagic, sizeof(IndexMagic));
+		header.Version = IndexVersion;
+		header.SortKey = sortBy;
+		header.Count = _stats.Heroes;
+		std::FILE* source = std::fopen(sourcePath.c_str(), "rb");
+		if (source != nullptr)
+		{
+			Seek(source, 0, SEEK_END);
+			header.SourceSize = Tell(source);
+			std::fclose(source);
+		}
+		ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+			Merge(runs, out, _options.MemoryBudget / (runs.size() + 1) / sizeof(Record));
+		_stats.MergePasses++;
+		ok = std::fclose(out) == 0 && ok;
+	}
+	else
+	{
+		ok = false;
+	}
+
+	RemoveTempFiles();
+	_stats.Seconds = SecondsSince(start);
+	return ok;
+}
+
+bool HeroExternalSort::CreateRuns(const std::string& sourcePath, SortBy sortBy, const std::string& tempPrefix, std::vector<std::string>& runs)
+{
+	std::FILE* file = std::fopen(sourcePath.c_str(), "rb");
+	if (file == nullptr)
+	{
+		std::cerr << "Cannot open " << sourcePath << std::endl;
+		return false;
+	}
+
+	//skip a UTF-8 BOM; offsets stay relative to the start of the file
+	uint64_t base = 0;
+	unsigned char bom[3];
+	if (std::fread(bom, 1, 3, file) == 3 && bom[0] == 0xEF && bom[1] == 0xBB && bom[2] == 0xBF)
+		base = 3;
+	Seek(file, base, SEEK_SET);
+
+	//the read buffer and parser stack come out of the budget too
+	std::vector<char> readBuffer(64 * 1024);
+	size_t capacity = std::max<size_t>(1, (_options.MemoryBudget - readBuffer.size() - MinMergeBuffer) / sizeof(Record));
+	std::vector<Record> records;
+	records.reserve(capacity);
+
+	bool spillOk = true;
+	std::function<bool()> spill = [&]() {
+		std::string path = tempPrefix + std::to_string(runs.size());
+		_tempFiles.push_back(path);
+		runs.push_back(path);
+		spillOk = SpillRun(records, path);
+		return spillOk;
+	};
+
+	rapidjson::FileReadStream stream(file, readBuffer.data(), readBuffer.size());
+	RecordHandler handler(stream, base, sortBy, records, capacity, spill);
+	rapidjson::Reader reader;
+	rapidjson::ParseResult result = reader.Parse(stream, handler);
+	std::fclose(file);
+
+	if (!spillOk)
+	{
+		std::cerr << "Cannot write run file (disk full?)" << std::endl;
+		return false;
+	}
+	if (!result || !handler.SawArray())
+	{
+		std::cerr << sourcePath << " is not a JSON array of heroes (offset " << result.Offset() << ")" << std::endl;
+		return false;
+	}
+	return records.empty() || spill();
+}
+
+bool HeroExternalSort::SpillRun(std::vector<Record>& records, const std::string& path)
+{
+	std::sort(records.begin(), records.end());
+	std::FILE* out = std::fopen(path.c_str(), "wb");
+	bool ok = out != nullptr && std::fwrite(records.data(), sizeof(Record), records.size(), out) == records.size();
+	if (out != nullptr)
+		ok = std::fclose(out) == 0 && ok;
+	_stats.Heroes += records.size();
+	records.clear();
+	return ok;
+}
+
+bool HeroExternalSort::Merge(const std::vector<std::string>& inputs, std::FILE* out, size_t bufferRecords)
+{
+	std::vector<std::unique_ptr<RunReader>> readers;
+	std::vector<RunReader*> sources;
+	for (const auto& path : inputs)
+	{
+		readers.push_back(std::make_unique<RunReader>(path, bufferRecords));
+		if (!readers.back()->IsOpen())
+			return false;
+		sources.push_back(readers.back().get());
+	}
+
+	std::vector<Record> output;
+	output.reserve(std::max<size_t>(bufferRecords, 1));
+	bool ok = true;
+	if (!sources.empty())
+	{
+		LoserTree tree(sources);
+		Record record;
+		while (ok && tree.Pop(record))
+		{
+			output.push_back(record);
+			if (output.size() == output.capacity())
+			{
+				ok = std::fwrite(output.data(), sizeof(Record), output.size(), out) == output.size();
+				output.clear();
+			}
+		}
+	}
+	return ok && std::fwrite(output.data(), sizeof(Record), output.size(), out) == output.size();
+}
+
+void HeroExternalSort::RemoveTempFiles()
+{
+	for (const auto& path : _tempFiles)
+		std::remove(path.c_str());
+	_tempFiles.clear();
+}
+
+bool HeroExternalSort::WriteSortedJson(const std::string& sourcePath, const std::string& indexPath, const std::string& outPath)
+{
+	std::FILE* index = std::fopen(indexPath.c_str(), "rb");
+	std::FILE* source = std::fopen(sourcePath.c_str(), "rb");
+	std::FILE* out = std::fopen(outPath.c_str(), "wb");
+	IndexHeader header{};
+	bool ok = index != nullptr && source != nullptr && out != nullptr &&
+		std::fread(&header, sizeof(header), 1, index) == 1 &&
+		std::memcmp(header.Magic, IndexMagic, sizeof(IndexMagic)) == 0 && header.Version == IndexVersion;
+
+	//records are read in blocks; each hero is one seek and one read from the source
+	std::vector<Record> records(8192);
+	std::vector<char> hero;
+	ok = ok && std::fputc('[', out) != EOF;
+	bool first = true;
+	size_t count;
+	while (ok && (count = std::fread(records.data(), sizeof(Record), records.size(), index)) > 0)
+	{
+		for (size_t i = 0; ok && i < count; i++)
+		{
+			hero.resize(records[i].Length);
+			ok = Seek(source, records[i].Offset, SEEK_SET) &&
+				std::fread(hero.data(), 1, hero.size(), source) == hero.size() &&
+				std::fputs(first ? "\n" : ",\n", out) != EOF &&
+				std::fwrite(hero.data(), 1, hero.size(), out) == hero.size();
+			first = false;
+		}
+	}
+	ok = ok && std::fputs("\n]\n", out) != EOF;
+
+	if (index != nullptr)
+		std::fclose(index);
+	if (source != nullptr)
+		std::fclose(source);
+	if (out != nullptr)
+		ok = std::fclose(out) == 0 && ok;
+	return ok;
+}
+
+bool HeroExternalSort::IsExternalSort(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--external-sort") == 0)
+			return true;
+	}
+	return false;
+}
+
+int HeroExternalSort::Main(int argc, char* argv[])
+{
+	std::string sourcePath, indexPath, outPath;
+	SortBy sortBy = Intelligence;
+	bool hasSortBy = false, valid = true;
+	int budgetMb = 64;
+	for (int i = 1; valid && i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--external-sort" && hasValue)
+			sourcePath = argv[++i];
+		else if (arg == "--by" && hasValue)
+			valid = hasSortBy = HeroScript::ParseSortBy(argv[++i], sortBy);
+		else if (arg == "--index" && hasValue)
+			indexPath = argv[++i];
+		else if (arg == "--out" && hasValue)
+			outPath = argv[++i];
+		else if (arg == "--budget-mb" && hasValue)
+			valid = HeroScript::ParseInt(argv[++i], budgetMb) && budgetMb > 0;
+		else
+			valid = false;
+	}
+	if (!valid || sourcePath.empty() || !hasSortBy || (indexPath.empty() && outPath.empty()))
+	{
+		std::cerr << "Usage: HeroesV2 --external-sort <source.json> --by <stat> [--index <file>] [--out <file>] [--budget-mb <n>]" << std::endl;
+		return 2;
+	}
+
+	//without --index the index is only a stepping stone to the sorted JSON
+	bool keepIndex = !indexPath.empty();
+	if (!keepIndex)
+		indexPath = outPath + ".idx";
+
+	HeroExternalSort::Options options;
+	options.MemoryBudget = static_cast<size_t>(budgetMb) << 20;
+	HeroExternalSort sorter(options);
+	if (!sorter.SortToIndex(sourcePath, sortBy, indexPath))
+		return 1;
+	const Stats& stats = sorter.GetStats();
+	std::cout << "Sorted " << stats.Heroes << " heroes by attribute " << sortBy << ": " << stats.Runs << " runs, "
+		<< stats.MergePasses << " merge passes, " << stats.Seconds << " s" << std::endl;
+
+	bool ok = true;
+	if (!outPath.empty())
+	{
+		auto start = std::chrono::steady_clock::now();
+		ok = WriteSortedJson(sourcePath, indexPath, outPath);
+		std::cout << (ok ? "Wrote " : "Failed to write ") << outPath << " in " << SecondsSince(start) << " s" << std::endl;
+	}
+	if (!keepIndex)
+		std::remove(indexPath.c_str());
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "enums.h"
+
+// Out-of-core sort of a hero JSON array (heroes.json or a snapshot) too big to load.
+//
+// Pass 1 streams the source through rapidjson's SAX reader and keeps only a 16-byte
+// (key, length, offset) record per hero. Whenever the records fill the memory budget they
+// are sorted and spilled to a run file. Pass 2 merges the runs through a loser tree with one
+// buffered reader per run; when there are more runs than the budget has buffers for, groups
+// of runs are merged into longer runs first. Equal keys keep source order, so the result
+// matches HeroesDB::SortOrder.
+//
+// The index file is a 32-byte header ("HIDX", version, sort key, hero count, source size)
+// followed by the sorted records. WriteSortedJson turns it into a sorted hero array.
+class HeroExternalSort
+{
+public:
+    struct Record
+    {
+        int32_t Key;
+        uint32_t Length;    // bytes of the hero object in the source
+        uint64_t Offset;    // where it starts
+
+        bool operator<(const Record& other) const
+        {
+            return Key < other.Key || (Key == other.Key && Offset < other.Offset);
+        }
+    };
+
+    struct Options
+    {
+        size_t MemoryBudget = 64 << 20;
+        std::string TempDirectory;      // empty: next to the index file
+    };
+
+    struct Stats
+    {
+        uint64_t Heroes = 0;
+        size_t Runs = 0;
+        size_t MergePasses = 0;
+        double Seconds = 0;
+    };
+
+    static const size_t MinMergeBuffer = 64 * 1024;    // per run; bounds the merge fan-in
+
+    explicit HeroExternalSort(const Options& options);
+
+    bool SortToIndex(const std::string& sourcePath, SortBy sortBy, const std::string& indexPath);
+    // Copies the heroes from sourcePath into a JSON array in index order.
+    static bool WriteSortedJson(const std::string& sourcePath, const std::string& indexPath, const std::string& outPath);
+    const Stats& GetStats() const { return _stats; }
+
+    // --external-sort <source> --by <stat> [--index <file>] [--out <file>] [--budget-mb <n>]
+    static bool IsExternalSort(int argc, char* argv[]);
+    static int Main(int argc, char* argv[]);
+
+private:
+    Options _options;
+    Stats _stats;
+    std::vector<std::string> _tempFiles;
+
+    bool CreateRuns(const std::string& sourcePath, SortBy sortBy, const std::string& tempPrefix, std::vector<std::string>& runs);
+    bool SpillRun(std::vector<Record>& records, const std::string& path);
+    bool Merge(const std::vector<std::string>& inputs, std::FILE* out, size_t bufferRecords);
+    void RemoveTempFiles();
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include "Hero.h"
+
+// Declarative JSON-to-struct mapping used by the Hero Deserialize methods.
+//
+// A HeroFieldMap lists (key, member) pairs and reads them from either a DOM rapidjson::Value or
+// a rapidjson::OnDemandValue, which leaves the members it does not map unparsed. At compile time it searches for a hash seed and
+// table size that give every key its own slot (a perfect hash), so Read makes a single pass
+// over the object's members: hash the name, check one slot, compare one key, then store.
+// Unknown members are skipped. Missing members and members of the wrong type (e.g. null) leave
+// the target unchanged instead of asserting the way obj["key"].GetString() does.
+//
+//     static constexpr HeroFieldMap fields{
+//         MapField<&HeroWork::Occupation>("occupation"),
+//         MapField<&HeroWork::Base>("base") };
+//     static_assert(fields.IsPerfect());
+//     fields.Read(*this, obj);
+
+template <typename JsonValue>
+void ReadField(int& target, const JsonValue& value)
+{
+    if (value.IsInt())
+        target = value.GetInt();
+}
+
+template <typename JsonValue>
+void ReadField(HeroString& target, const JsonValue& value)
+{
+    if (value.IsString())
+        target.assign(value.GetString(), value.GetStringLength());
+}
+
+template <typename JsonValue>
+void ReadField(HeroStringList& target, const JsonValue& value)
+{
+    if (!value.IsArray())
+        return;
+    target.reserve(target.size() + value.Size());
+    for (const auto& item : value.GetArray())
+    {
+        if (item.IsString())
+            target.emplace_back(item.GetString(), item.GetStringLength());
+    }
+}
+
+// Nested objects (powerstats, appearance, ...) go through their own Deserialize.
+template <typename T, typename JsonValue>
+    requires requires (T& target, const JsonValue& value) { target.Deserialize(value); }
+void ReadField(T& target, const JsonValue& value)
+{
+    if (value.IsObject())
+        target.Deserialize(value);
+}
+
+template <typename T>
+struct HeroField
+{
+    std::string_view Key;
+    void (*Read)(T& target, const rapidjson::Value& value);
+    void (*ReadOnDemand)(T& target, const rapidjson::OnDemandValue& value);
+
+    void Apply(T& target, const rapidjson::Value& value) const { Read(target, value); }
+    void Apply(T& target, const rapidjson::OnDemandValue& value) const { ReadOnDemand(target, value); }
+};
+
+template <typename T, typename M>
+T* HeroFieldOwner(M T::*);
+
+// Binds a JSON key to a data member; the member's type picks the ReadField overload.
+template <auto Member>
+constexpr auto MapField(std::string_view key)
+{
+    using Owner = std::remove_pointer_t<decltype(HeroFieldOwner(Member))>;
+    auto read = [](Owner& target, const auto& value) { ReadField(target.*Member, value); };
+    return HeroField<Owner>{ key, read, read };
+}
+
+template <typename T, size_t N>
+class HeroFieldMap
+{
+public:
+    template <typename... Fields>
+    constexpr HeroFieldMap(const Fields&... fields) :
+        _fields{ { fields... } }
+    {
+        for (size_t size = std::bit_ceil(N); size <= MaxSlots && !_perfect; size *= 2)
+        {
+            for (uint32_t seed = 0; seed < 256 && !_perfect; seed++)
+                _perfect = TryBuild(seed, static_cast<uint32_t>(size - 1));
+        }
+    }
+
+    // False if no seed separates the keys (e.g. a key is listed twice); check with static_assert.
+    constexpr bool IsPerfect() const { return _perfect; }
+
+    template <typename JsonValue>
+    bool Read(T& target, const JsonValue& obj) const
+    {
+        if (!obj.IsObject())
+            return false;
+        for (auto member = obj.MemberBegin(); member != obj.MemberEnd(); ++member)
+        {
+            std::string_view key(member->name.GetString(), member->name.GetStringLength());
+            uint8_t slot = _slots[Hash(key, _seed) & _mask];
+            if (slot != 0 && _fields[slot - 1].Key == key)
+                _fields[slot - 1].Apply(target, member->value);
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t MaxSlots = std::bit_ceil(N) * 8;
+
+    std::array<HeroField<T>, N> _fields;
+    std::array<uint8_t, MaxSlots> _slots{};    // field index + 1, 0 for an empty slot
+    uint32_t _seed = 0;
+    uint32_t _mask = 0;
+    bool _perfect = false;
+
+    // Seeded FNV-1a, folded so the low bits used for the slot see the whole key.
+    static constexpr uint32_t Hash(std::string_view key, uint32_t seed)
+    {
+        uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+        for (char c : key)
+            hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+        return hash ^ (hash >> 15);
+    }
+
+    constexpr bool TryBuild(uint32_t seed, uint32_t mask)
+    {
+        _slots.fill(0);
+        for (size_t i = 0; i < N; i++)
+        {
+            uint8_t& slot = _slots[Hash(_fields[i].Key, seed) & mask];
+            if (slot != 0)
+                return false;
+            slot = static_cast<uint8_t>(i + 1);
+        }
+        _seed = seed;
+        _mask = mask;
+        return true;
+    }
+};
+
+template <typename T, typename... Fields>
+HeroFieldMap(const HeroField<T>&, const Fields&...) -> HeroFieldMap<T, 1 + sizeof...(Fields)>;
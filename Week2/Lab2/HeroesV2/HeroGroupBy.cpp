@@ -0,0 +1,92 @@
+#include "HeroGroupBy.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+	struct Partial
+	{
+		std::vector<long long> Count;
+		std::vector<long long> Sum;
+		std::vector<long long> SumSquares;
+		std::vector<int> Min;
+		std::vector<int> Max;
+
+		explicit Partial(size_t groups) :
+			Count(groups, 0), Sum(groups, 0), SumSquares(groups, 0), Min(groups, INT_MAX), Max(groups, INT_MIN)
+		{ }
+
+		void Accumulate(const uint32_t* codes, const int* values, size_t begin, size_t end)
+		{
+			long long* count = Count.data();
+			long long* sum = Sum.data();
+			long long* sumSquares = SumSquares.data();
+			int* low = Min.data();
+			int* high = Max.data();
+			for (size_t i = begin; i < end; i++)
+			{
+				uint32_t g = codes[i];
+				long long v = values[i];
+				count[g]++;
+				sum[g] += v;
+				sumSquares[g] += v * v;
+				low[g] = std::min(low[g], values[i]);
+				high[g] = std::max(high[g], values[i]);
+			}
+		}
+
+		void Merge(const Partial& other)
+		{
+			for (size_t g = 0; g < Count.size(); g++)
+			{
+				Count[g] += other.Count[g];
+				Sum[g] += other.Sum[g];
+				SumSquares[g] += other.SumSquares[g];
+				Min[g] = std::min(Min[g], other.Min[g]);
+				Max[g] = std::max(Max[g], other.Max[g]);
+			}
+		}
+	};
+}
+
+std::vector<GroupStats> HeroGroupBy::Aggregate(const HeroColumns& columns, GroupBy groupBy, SortBy stat, unsigned threads)
+{
+	const std::vector<uint32_t>& codes = columns.Codes(groupBy);
+	const std::vector<int>& values = columns.Stat(stat);
+	const std::vector<std::string>& labels = columns.Labels(groupBy);
+	size_t rows = columns.Size();
+
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	size_t workers = std::max<size_t>(1, std::min<size_t>(threads, rows / MinRowsPerThread));
+
+	std::vector<Partial> partials(workers, Partial(labels.size()));
+	std::vector<std::thread> pool;
+	size_t chunk = (rows + workers - 1) / workers;
+	for (size_t w = 1; w < workers; w++)
+	{
+		size_t begin = std::min(rows, w * chunk), end = std::min(rows, begin + chunk);
+		pool.emplace_back([&, w, begin, end]() { partials[w].Accumulate(codes.data(), values.data(), begin, end); });
+	}
+	partials[0].Accumulate(codes.data(), values.data(), 0, std::min(rows, chunk));
+	for (auto& worker : pool)
+		worker.join();
+	for (size_t w = 1; w < workers; w++)
+		partials[0].Merge(partials[w]);
+
+	const Partial& total = partials[0];
+	std::vector<GroupStats> groups;
+	for (size_t g = 0; g < labels.size(); g++)
+	{
+		if (total.Count[g] == 0)
+			continue;
+		double n = static_cast<double>(total.Count[g]);
+		double mean = total.Sum[g] / n;
+		double variance = std::max(0.0, total.SumSquares[g] / n - mean * mean);
+		groups.push_back({ labels[g], static_cast<size_t>(total.Count[g]), total.Min[g], total.Max[g], mean, std::sqrt(variance) });
+	}
+	std::sort(groups.begin(), groups.end(), [](const GroupStats& a, const GroupStats& b) { return a.Label < b.Label; });
+	return groups;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "HeroColumns.h"
+
+struct GroupStats
+{
+    std::string Label;
+    size_t Count;
+    int Min;
+    int Max;
+    double Mean;
+    double StdDev;      // population standard deviation
+};
+
+// Group-by aggregation over HeroColumns.
+//
+// Each worker makes one pass over its slice of the group-code and stat columns, keeping
+// partial count/sum/sum-of-squares/min/max per group; the partials are merged at the end.
+// Sums are kept as integers so the merge is exact regardless of thread count.
+class HeroGroupBy final
+{
+public:
+    static const size_t MinRowsPerThread = 64 * 1024;
+
+    // threads == 0 picks std::thread::hardware_concurrency(). Groups come back in label order.
+    static std::vector<GroupStats> Aggregate(const HeroColumns& columns, GroupBy groupBy, SortBy stat, unsigned threads = 0);
+};
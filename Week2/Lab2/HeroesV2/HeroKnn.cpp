@@ -0,0 +1,331 @@
+#include "HeroKnn.h"
+#include "HeroMemoryReport.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define HEROKNN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define HEROKNN_SSE2
+#endif
+
+namespace
+{
+	const size_t LeafSize = 16;
+	const size_t BatchSize = 256;
+}
+
+//bounded max-heap of the k best candidates seen so far
+class HeroKnn::TopK
+{
+public:
+	explicit TopK(size_t k) : _k(k) { _heap.reserve(k + 1); }
+
+	float Worst() const
+	{
+		return _heap.size() < _k ? std::numeric_limits<float>::infinity() : _heap.front().Distance;
+	}
+
+	void Offer(float distance, uint32_t index)
+	{
+		Candidate candidate{ distance, index };
+		if (_heap.size() < _k)
+		{
+			_heap.push_back(candidate);
+			std::push_heap(_heap.begin(), _heap.end());
+		}
+		else if (candidate < _heap.front())
+		{
+			std::pop_heap(_heap.begin(), _heap.end());
+			_heap.back() = candidate;
+			std::push_heap(_heap.begin(), _heap.end());
+		}
+	}
+
+	std::vector<Candidate>& Sorted()
+	{
+		std::sort_heap(_heap.begin(), _heap.end());
+		return _heap;
+	}
+
+private:
+	size_t _k;
+	std::vector<Candidate> _heap;
+};
+
+void HeroKnn::Build(const std::vector<HeroStats>& stats)
+{
+	Clear();
+	_count = stats.size();
+	for (int d = 0; d < Dimensions; d++)
+	{
+		_columns[d].resize(_count);
+		_unitColumns[d].resize(_count);
+	}
+	for (size_t i = 0; i < _count; i++)
+	{
+		StatVector raw = ToVector(stats[i]);
+		StatVector unit = Normalize(raw);
+		for (int d = 0; d < Dimensions; d++)
+		{
+			_columns[d][i] = raw[d];
+			_unitColumns[d][i] = unit[d];
+		}
+	}
+	_built = true;
+}
+
+void HeroKnn::BuildTree(DistanceMetric metric)
+{
+	KdTree& tree = metric == Cosine ? _unitTree : _rawTree;
+	const std::vector<float>* columns = ColumnsFor(metric);
+
+	tree.Order.resize(_count);
+	for (size_t i = 0; i < _count; i++)
+		tree.Order[i] = static_cast<uint32_t>(i);
+	tree.SplitDim.assign(_count, 0);
+	BuildNode(tree, columns, 0, _count);
+
+	//copy coordinates into tree order so leaf scans read contiguous memory
+	tree.Points.resize(_count * Dimensions);
+	for (size_t p = 0; p < _count; p++)
+	{
+		for (int d = 0; d < Dimensions; d++)
+			tree.Points[p * Dimensions + d] = columns[d][tree.Order[p]];
+	}
+	tree.Built = true;
+}
+
+void HeroKnn::Clear()
+{
+	for (int d = 0; d < Dimensions; d++)
+	{
+		_columns[d].clear();
+		_unitColumns[d].clear();
+	}
+	_rawTree = KdTree();
+	_unitTree = KdTree();
+	_count = 0;
+	_built = false;
+}
+
+size_t HeroKnn::MemoryBytes() const
+{
+	size_t bytes = 0;
+	for (int d = 0; d < Dimensions; d++)
+		bytes += HeroMemoryReport::HeapBytes(_columns[d]) + HeroMemoryReport::HeapBytes(_unitColumns[d]);
+	for (const KdTree* tree : { &_rawTree, &_unitTree })
+	{
+		bytes += HeroMemoryReport::HeapBytes(tree->Order) + HeroMemoryReport::HeapBytes(tree->Points) +
+			HeroMemoryReport::HeapBytes(tree->SplitDim);
+	}
+	return bytes;
+}
+
+std::vector<HeroNeighbor> HeroKnn::QueryHero(size_t index, size_t k, DistanceMetric metric) const
+{
+	return Query(Point(index), k, metric, index);
+}
+
+std::vector<HeroNeighbor> HeroKnn::Query(const StatVector& point, size_t k, DistanceMetric metric, size_t exclude) const
+{
+	if (TreeFor(metric).Built && _count >= TreeThreshold)
+		return QueryTree(point, k, metric, exclude);
+	return QueryBruteForce(point, k, metric, exclude);
+}
+
+std::vector<HeroNeighbor> HeroKnn::QueryBruteForce(const StatVector& point, size_t k, DistanceMetric metric, size_t exclude) const
+{
+	TopK best(k);
+	if (k == 0)
+		return Finish(best, metric);
+
+	const std::vector<float>* columns = ColumnsFor(metric);
+	StatVector query = metric == Cosine ? Normalize(point) : point;
+	float distances[BatchSize];
+
+	for (size_t start = 0; start < _count; start += BatchSize)
+	{
+		size_t end = std::min(_count, start + BatchSize);
+		size_t i = start;
+
+		//distances for a whole batch first, then one pass over the heap
+#if defined(HEROKNN_AVX2)
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 acc = _mm256_setzero_ps();
+			for (int d = 0; d < Dimensions; d++)
+			{
+				__m256 diff = _mm256_sub_ps(_mm256_loadu_ps(columns[d].data() + i), _mm256_set1_ps(query[d]));
+				acc = _mm256_add_ps(acc, metric == Manhattan ? _mm256_and_ps(diff, absMask) : _mm256_mul_ps(diff, diff));
+			}
+			_mm256_storeu_ps(distances + (i - start), acc);
+		}
+#elif defined(HEROKNN_SSE2)
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 acc = _mm_setzero_ps();
+			for (int d = 0; d < Dimensions; d++)
+			{
+				__m128 diff = _mm_sub_ps(_mm_loadu_ps(columns[d].data() + i), _mm_set1_ps(query[d]));
+				acc = _mm_add_ps(acc, metric == Manhattan ? _mm_and_ps(diff, absMask) : _mm_mul_ps(diff, diff));
+			}
+			_mm_storeu_ps(distances + (i - start), acc);
+		}
+#endif
+		for (; i < end; i++)
+		{
+			float acc = 0;
+			for (int d = 0; d < Dimensions; d++)
+			{
+				float diff = columns[d][i] - query[d];
+				acc += metric == Manhattan ? std::fabs(diff) : diff * diff;
+			}
+			distances[i - start] = acc;
+		}
+
+		for (size_t j = start; j < end; j++)
+		{
+			if (j != exclude && distances[j - start] <= best.Worst())
+				best.Offer(distances[j - start], static_cast<uint32_t>(j));
+		}
+	}
+	return Finish(best, metric);
+}
+
+std::vector<HeroNeighbor> HeroKnn::QueryTree(const StatVector& point, size_t k, DistanceMetric metric, size_t exclude) const
+{
+	TopK best(k);
+	const KdTree& tree = TreeFor(metric);
+	if (k > 0 && tree.Built)
+		SearchNode(tree, metric == Cosine ? Normalize(point) : point, metric, 0, _count, best, exclude);
+	return Finish(best, metric);
+}
+
+HeroKnn::StatVector HeroKnn::Point(size_t index) const
+{
+	StatVector point;
+	for (int d = 0; d < Dimensions; d++)
+		point[d] = _columns[d][index];
+	return point;
+}
+
+HeroKnn::StatVector HeroKnn::ToVector(const HeroStats& stats)
+{
+	return { static_cast<float>(stats.Intelligence), static_cast<float>(stats.Strength), static_cast<float>(stats.Speed),
+		static_cast<float>(stats.Durability), static_cast<float>(stats.Power), static_cast<float>(stats.Combat) };
+}
+
+//all-zero stats stay at the origin, half a unit from every other vector
+HeroKnn::StatVector HeroKnn::Normalize(const StatVector& point) const
+{
+	float norm = 0;
+	for (float value : point)
+		norm += value * value;
+	norm = std::sqrt(norm);
+
+	StatVector unit = point;
+	if (norm > 0)
+	{
+		for (float& value : unit)
+			value /= norm;
+	}
+	return unit;
+}
+
+void HeroKnn::BuildNode(KdTree& tree, const std::vector<float>* columns, size_t lo, size_t hi)
+{
+	if (hi - lo <= LeafSize)
+		return;
+
+	//split on the dimension with the widest spread in this range
+	int splitDim = 0;
+	float widest = -1;
+	for (int d = 0; d < Dimensions; d++)
+	{
+		float lowest = std::numeric_limits<float>::infinity(), highest = -lowest;
+		for (size_t p = lo; p < hi; p++)
+		{
+			float value = columns[d][tree.Order[p]];
+			lowest = std::min(lowest, value);
+			highest = std::max(highest, value);
+		}
+		if (highest - lowest > widest)
+		{
+			widest = highest - lowest;
+			splitDim = d;
+		}
+	}
+
+	size_t mid = lo + (hi - lo) / 2;
+	const std::vector<float>& column = columns[splitDim];
+	std::nth_element(tree.Order.begin() + lo, tree.Order.begin() + mid, tree.Order.begin() + hi,
+		[&](uint32_t a, uint32_t b) { return column[a] < column[b]; });
+	tree.SplitDim[mid] = static_cast<uint8_t>(splitDim);
+
+	BuildNode(tree, columns, lo, mid);
+	BuildNode(tree, columns, mid + 1, hi);
+}
+
+void HeroKnn::SearchNode(const KdTree& tree, const StatVector& point, DistanceMetric metric, size_t lo, size_t hi, TopK& best, size_t exclude) const
+{
+	if (hi - lo <= LeafSize)
+	{
+		for (size_t p = lo; p < hi; p++)
+		{
+			if (tree.Order[p] == exclude)
+				continue;
+			float distance = RawDistance(&tree.Points[p * Dimensions], point.data(), metric);
+			if (distance <= best.Worst())
+				best.Offer(distance, tree.Order[p]);
+		}
+		return;
+	}
+
+	size_t mid = lo + (hi - lo) / 2;
+	if (tree.Order[mid] != exclude)
+		best.Offer(RawDistance(&tree.Points[mid * Dimensions], point.data(), metric), tree.Order[mid]);
+
+	int splitDim = tree.SplitDim[mid];
+	float diff = point[splitDim] - tree.Points[mid * Dimensions + splitDim];
+	bool lowFirst = diff < 0;
+	SearchNode(tree, point, metric, lowFirst ? lo : mid + 1, lowFirst ? mid : hi, best, exclude);
+
+	//the far side can only help if the gap across the split is within the current worst
+	float bound = metric == Manhattan ? std::fabs(diff) : diff * diff;
+	if (bound <= best.Worst())
+		SearchNode(tree, point, metric, lowFirst ? mid + 1 : lo, lowFirst ? hi : mid, best, exclude);
+}
+
+float HeroKnn::RawDistance(const float* a, const float* b, DistanceMetric metric)
+{
+	float acc = 0;
+	for (int d = 0; d < Dimensions; d++)
+	{
+		float diff = a[d] - b[d];
+		acc += metric == Manhattan ? std::fabs(diff) : diff * diff;
+	}
+	return acc;
+}
+
+float HeroKnn::FinishDistance(float raw, DistanceMetric metric)
+{
+	switch (metric)
+	{
+	case Euclidean: return std::sqrt(raw);
+	case Cosine: return raw / 2;
+	default: return raw;
+	}
+}
+
+std::vector<HeroNeighbor> HeroKnn::Finish(TopK& best, DistanceMetric metric)
+{
+	std::vector<HeroNeighbor> neighbors;
+	for (const Candidate& candidate : best.Sorted())
+		neighbors.push_back({ candidate.Index, FinishDistance(candidate.Distance, metric) });
+	return neighbors;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Hero.h"
+#include "enums.h"
+
+struct HeroNeighbor
+{
+    size_t Index;       // position in the stats list the engine was built from
+    float Distance;     // L1, L2, or 1 - cosine similarity
+};
+
+// k-nearest-neighbor search over the six powerstats.
+//
+// Stats are kept as columns (one float array per stat) so brute force computes a batch
+// of distances per SIMD instruction. For large datasets an optional KD-tree can be built
+// per metric; cosine queries run on unit-length copies of the vectors, where
+// 1 - cos(a, b) == |a - b|^2 / 2. Ties are broken by index, so the tree and brute force
+// return identical results.
+class HeroKnn
+{
+public:
+    static const int Dimensions = 6;
+    static const size_t TreeThreshold = 16 * 1024;  // below this, brute force wins
+    using StatVector = std::array<float, Dimensions>;
+
+    void Build(const std::vector<HeroStats>& stats);
+    void BuildTree(DistanceMetric metric);
+    void Clear();
+    bool IsBuilt() const { return _built; }
+    size_t Size() const { return _count; }
+    size_t MemoryBytes() const;
+
+    // Neighbors of the hero at index, excluding the hero itself.
+    std::vector<HeroNeighbor> QueryHero(size_t index, size_t k, DistanceMetric metric) const;
+    // Uses the metric's tree if one was built and the dataset is large enough.
+    std::vector<HeroNeighbor> Query(const StatVector& point, size_t k, DistanceMetric metric, size_t exclude = SIZE_MAX) const;
+    std::vector<HeroNeighbor> QueryBruteForce(const StatVector& point, size_t k, DistanceMetric metric, size_t exclude = SIZE_MAX) const;
+    std::vector<HeroNeighbor> QueryTree(const StatVector& point, size_t k, DistanceMetric metric, size_t exclude = SIZE_MAX) const;
+
+    bool HasTree(DistanceMetric metric) const { return TreeFor(metric).Built; }
+    StatVector Point(size_t index) const;
+    static StatVector ToVector(const HeroStats& stats);
+
+private:
+    struct Candidate
+    {
+        float Distance;
+        uint32_t Index;
+        bool operator<(const Candidate& other) const
+        {
+            return Distance < other.Distance || (Distance == other.Distance && Index < other.Index);
+        }
+    };
+
+    class TopK;
+
+    struct KdTree
+    {
+        std::vector<uint32_t> Order;    // point indices, arranged as an implicit median tree
+        std::vector<float> Points;      // row-major coordinates in Order sequence
+        std::vector<uint8_t> SplitDim;  // split dimension of the node at each median slot
+        bool Built = false;
+    };
+
+    std::vector<float> _columns[Dimensions];      // raw stats
+    std::vector<float> _unitColumns[Dimensions];  // stats scaled to unit length, for cosine
+    size_t _count = 0;
+    bool _built = false;
+    KdTree _rawTree;    // L1 and L2
+    KdTree _unitTree;   // cosine
+
+    const KdTree& TreeFor(DistanceMetric metric) const { return metric == Cosine ? _unitTree : _rawTree; }
+    const std::vector<float>* ColumnsFor(DistanceMetric metric) const { return metric == Cosine ? _unitColumns : _columns; }
+    StatVector Normalize(const StatVector& point) const;
+    void BuildNode(KdTree& tree, const std::vector<float>* columns, size_t lo, size_t hi);
+    void SearchNode(const KdTree& tree, const StatVector& point, DistanceMetric metric, size_t lo, size_t hi, TopK& best, size_t exclude) const;
+    static float RawDistance(const float* a, const float* b, DistanceMetric metric);
+    static float FinishDistance(float raw, DistanceMetric metric);
+    static std::vector<HeroNeighbor> Finish(TopK& best, DistanceMetric metric);
+};
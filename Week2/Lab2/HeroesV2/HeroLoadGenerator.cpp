@@ -0,0 +1,390 @@
+#include "HeroLoadGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	bool ParseCount(const char* text, size_t& value)
+	{
+		char* end;
+		unsigned long long parsed = std::strtoull(text, &end, 10);
+		if (*text == '\0' || *end != '\0' || parsed == 0)
+			return false;
+		value = static_cast<size_t>(parsed);
+		return true;
+	}
+
+	double Percentile(const std::vector<double>& sorted, double fraction)
+	{
+		if (sorted.empty())
+			return 0;
+		size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+		return sorted[std::min(index, sorted.size() - 1)];
+	}
+}
+
+const std::vector<std::string>& HeroLoadGenerator::Requests()
+{
+	static const std::vector<std::string> requests{
+		"GET Batman", "GET Superman", "GET Wonder Woman", "GET Iron Man", "GET Spider-Man",
+		"GET Hulk", "GET Thor", "GET Nobody At All", "RANGE height 180 200", "RANGE intelligence 90 100",
+		"SIMILAR l2 10 Batman", "SIMILAR cosine 10 Storm", "COUNT", "PING" };
+	return requests;
+}
+
+void HeroLoadGenerator::Print(const Report& report)
+{
+	std::vector<double> sorted = report.LatenciesUs;
+	std::sort(sorted.begin(), sorted.end());
+	std::cout << "Completed " << report.Completed << " requests in " << report.Seconds << " s ("
+		<< report.Misses << " not found, " << report.Errors << " errors, " << report.FailedConnections << " failed connections)" << std::endl;
+	std::cout << "  QPS:     " << (report.Seconds > 0 ? report.Completed / report.Seconds : 0) << std::endl;
+	std::cout << "  Latency: p50 " << Percentile(sorted, 0.50) << " us, p90 " << Percentile(sorted, 0.90)
+		<< " us, p99 " << Percentile(sorted, 0.99) << " us, p99.9 " << Percentile(sorted, 0.999)
+		<< " us, max " << (sorted.empty() ? 0 : sorted.back()) << " us" << std::endl;
+}
+
+bool HeroLoadGenerator::IsLoad(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--load") == 0)
+			return true;
+	}
+	return false;
+}
+
+int HeroLoadGenerator::Main(int argc, char* argv[])
+{
+	Options options;
+	size_t floodBytes = 0;
+	bool valid = true;
+	for (int i = 1; valid && i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--load" && hasValue)
+			options.SocketPath = argv[++i];
+		else if (arg == "--clients" && hasValue)
+			valid = ParseCount(argv[++i], options.Clients);
+		else if (arg == "--requests" && hasValue)
+			valid = ParseCount(argv[++i], options.Requests);
+		else if (arg == "--pipeline" && hasValue)
+			valid = ParseCount(argv[++i], options.Pipeline);
+		else if (arg == "--threads" && hasValue)
+			valid = ParseCount(argv[++i], options.Threads);
+		else if (arg == "--flood" && hasValue)
+			valid = ParseCount(argv[++i], floodBytes);
+		else
+			valid = false;
+	}
+	if (!valid || options.SocketPath.empty())
+	{
+		std::cerr << "Usage: HeroesV2 --load <socket path> [--clients <n>] [--requests <n>] [--pipeline <n>] [--threads <n>] | [--flood <bytes>]" << std::endl;
+		return 2;
+	}
+
+	if (floodBytes > 0)
+	{
+		FloodReport flood;
+		if (!Flood(options.SocketPath, floodBytes, flood))
+			return 1;
+		bool pushedBack = flood.SentBytes < floodBytes;
+		std::cout << "Server took " << flood.SentBytes << " bytes (" << flood.Requests << " requests) without its answers being read"
+			<< (pushedBack ? "" : ", and kept taking more") << "; answered " << flood.Answered << std::endl;
+		return pushedBack && flood.Answered == flood.Requests ? 0 : 1;
+	}
+
+	Report report;
+	if (!Run(options, report))
+		return 1;
+	Print(report);
+	return report.Errors == 0 && report.FailedConnections == 0 && report.Completed == options.Requests ? 0 : 1;
+}
+
+#ifdef __linux__
+
+namespace
+{
+	struct ClientConnection
+	{
+		int Fd = -1;
+		size_t NextRequest = 0;
+		std::deque<Clock::time_point> SentAt;   // one per request in flight, oldest first
+		std::string In;
+	};
+
+	int Connect(const std::string& path)
+	{
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		std::memcpy(address.sun_path, path.c_str(), std::min(path.size() + 1, sizeof(address.sun_path) - 1));
+		int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+		{
+			close(fd);
+			fd = -1;
+		}
+		return fd;
+	}
+
+	bool SendAll(int fd, const std::string& data)
+	{
+		size_t sent = 0;
+		while (sent < data.size())
+		{
+			ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				return false;
+			sent += n;
+		}
+		return true;
+	}
+}
+
+bool HeroLoadGenerator::Run(const Options& options, Report& report)
+{
+	if (options.SocketPath.size() >= sizeof(sockaddr_un::sun_path))
+	{
+		std::cerr << "Socket path is too long: " << options.SocketPath << std::endl;
+		return false;
+	}
+	rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+
+	const std::vector<std::string>& requests = Requests();
+	std::atomic<size_t> issued{ 0 };
+	std::mutex reportMutex;
+	size_t threadCount = std::min(options.Threads, options.Clients);
+	report = Report();
+
+	auto client = [&](size_t clientCount, size_t firstClient) {
+		std::vector<ClientConnection> connections(clientCount);
+		std::vector<double> latencies;
+		size_t completed = 0, misses = 0, errors = 0, failed = 0;
+		int epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+		//sends up to count more requests on one connection, as one write
+		auto issue = [&](ClientConnection& connection, size_t count) {
+			std::string batch;
+			Clock::time_point now = Clock::now();
+			for (size_t i = 0; i < count && issued.fetch_add(1) < options.Requests; i++)
+			{
+				batch += requests[connection.NextRequest++ % requests.size()];
+				batch += '\n';
+				connection.SentAt.push_back(now);
+			}
+			return batch.empty() || SendAll(connection.Fd, batch);
+		};
+
+		size_t open = 0;
+		for (size_t c = 0; c < clientCount; c++)
+		{
+			ClientConnection& connection = connections[c];
+			connection.NextRequest = firstClient + c;
+			connection.Fd = Connect(options.SocketPath);
+			if (connection.Fd < 0)
+			{
+				failed++;
+				continue;
+			}
+			epoll_event event{};
+			event.events = EPOLLIN;
+			event.data.u64 = c;
+			epoll_ctl(epollFd, EPOLL_CTL_ADD, connection.Fd, &event);
+			open++;
+		}
+		for (auto& connection : connections)
+		{
+			if (connection.Fd >= 0 && !issue(connection, options.Pipeline))
+				failed++;
+		}
+
+		//a connection is done once nothing is in flight and no more requests are left to issue
+		size_t active = 0;
+		for (auto& connection : connections)
+		{
+			if (connection.Fd >= 0 && !connection.SentAt.empty())
+				active++;
+		}
+
+		epoll_event events[256];
+		char chunk[64 * 1024];
+		while (active > 0)
+		{
+			int ready = epoll_wait(epollFd, events, 256, 10000);
+			if (ready == 0)
+				break;  //server stalled
+			if (ready < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+			for (int e = 0; e < ready; e++)
+			{
+				ClientConnection& connection = connections[events[e].data.u64];
+				ssize_t received = read(connection.Fd, chunk, sizeof(chunk));
+				if (received <= 0)
+				{
+					if (received < 0 && errno == EINTR)
+						continue;
+					failed++;
+					active--;
+					epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.Fd, nullptr);
+					close(connection.Fd);
+					connection.Fd = -1;
+					continue;
+				}
+				connection.In.append(chunk, received);
+
+				size_t start = 0, newline, answered = 0;
+				Clock::time_point now = Clock::now();
+				while ((newline = connection.In.find('\n', start)) != std::string::npos && !connection.SentAt.empty())
+				{
+					latencies.push_back(std::chrono::duration<double, std::micro>(now - connection.SentAt.front()).count());
+					connection.SentAt.pop_front();
+					if (connection.In.compare(start, newline - start, "ERR not found") == 0)
+						misses++;
+					else if (connection.In.compare(start, 3, "OK ") != 0)
+						errors++;
+					start = newline + 1;
+					answered++;
+				}
+				connection.In.erase(0, start);
+				completed += answered;
+
+				if (answered > 0 && !issue(connection, answered))
+					failed++;
+				if (connection.SentAt.empty())
+				{
+					active--;
+					epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.Fd, nullptr);
+				}
+			}
+		}
+
+		for (auto& connection : connections)
+		{
+			if (connection.Fd >= 0)
+				close(connection.Fd);
+		}
+		close(epollFd);
+
+		std::lock_guard<std::mutex> lock(reportMutex);
+		report.Completed += completed;
+		report.Misses += misses;
+		report.Errors += errors;
+		report.FailedConnections += failed;
+		report.LatenciesUs.insert(report.LatenciesUs.end(), latencies.begin(), latencies.end());
+	};
+
+	auto start = Clock::now();
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < threadCount; t++)
+	{
+		size_t first = options.Clients * t / threadCount;
+		size_t last = options.Clients * (t + 1) / threadCount;
+		threads.emplace_back(client, last - first, first);
+	}
+	for (auto& thread : threads)
+		thread.join();
+	report.Seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	return true;
+}
+
+bool HeroLoadGenerator::Flood(const std::string& socketPath, size_t limitBytes, FloodReport& report)
+{
+	report = FloodReport();
+	int fd = socketPath.size() < sizeof(sockaddr_un::sun_path) ? Connect(socketPath) : -1;
+	if (fd < 0)
+	{
+		std::cerr << "Cannot connect to " << socketPath << std::endl;
+		return false;
+	}
+
+	//sent round and round; a send may stop mid-line, and only whole lines count as requests
+	std::string block;
+	while (block.size() < 64 * 1024)
+	{
+		for (const auto& request : Requests())
+		{
+			block += request;
+			block += '\n';
+		}
+	}
+
+	size_t offset = 0;
+	pollfd writable{ fd, POLLOUT, 0 };
+	while (report.SentBytes < limitBytes)
+	{
+		ssize_t sent = send(fd, block.data() + offset, block.size() - offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (sent > 0)
+		{
+			report.Requests += std::count(block.begin() + offset, block.begin() + offset + sent, '\n');
+			report.SentBytes += sent;
+			offset = (offset + sent) % block.size();
+			continue;
+		}
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && poll(&writable, 1, 1000) > 0)
+			continue;
+		break;  //pushed back for a second (or failed)
+	}
+
+	//the server answers every whole line, then closes once it sees the end of input
+	shutdown(fd, SHUT_WR);
+	pollfd readable{ fd, POLLIN, 0 };
+	char chunk[64 * 1024];
+	while (poll(&readable, 1, 10000) > 0)
+	{
+		ssize_t received = read(fd, chunk, sizeof(chunk));
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			break;
+		report.Answered += std::count(chunk, chunk + received, '\n');
+	}
+	close(fd);
+	return true;
+}
+
+#else
+
+bool HeroLoadGenerator::Run(const Options& options, Report& report)
+{
+	std::cerr << "The load generator needs Linux (epoll and Unix domain sockets)" << std::endl;
+	return false;
+}
+
+bool HeroLoadGenerator::Flood(const std::string& socketPath, size_t limitBytes, FloodReport& report)
+{
+	std::cerr << "The load generator needs Linux (epoll and Unix domain sockets)" << std::endl;
+	return false;
+}
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Load generator for HeroServer. Opens many connections spread over a few threads, keeps
+// a fixed number of requests pipelined on each, and reports throughput and latency
+// percentiles, e.g.
+//
+//     HeroesV2 --load /tmp/heroes.sock --clients 2000 --requests 500000 --pipeline 8
+//
+// With --flood it instead checks that the server pushes back on a client that pipelines
+// without reading its answers, e.g. HeroesV2 --load /tmp/heroes.sock --flood 16000000
+class HeroLoadGenerator final
+{
+public:
+    struct Options
+    {
+        std::string SocketPath;
+        size_t Clients = 1000;
+        size_t Requests = 200000;   // in total, over all clients
+        size_t Pipeline = 8;        // requests in flight per connection
+        size_t Threads = 4;
+    };
+
+    struct Report
+    {
+        size_t Completed = 0;
+        size_t Misses = 0;          // ERR not found, an expected answer for unknown names
+        size_t Errors = 0;          // any other ERR response
+        size_t FailedConnections = 0;
+        double Seconds = 0;
+        std::vector<double> LatenciesUs;
+    };
+
+    struct FloodReport
+    {
+        size_t SentBytes = 0;       // taken by the server and the socket before sends stopped going through
+        size_t Requests = 0;        // complete request lines among them
+        size_t Answered = 0;
+    };
+
+    // Mix of lookups sent round-robin by every connection.
+    static const std::vector<std::string>& Requests();
+
+    static bool Run(const Options& options, Report& report);
+    static void Print(const Report& report);
+
+    // Sends requests on one connection without reading answers until no send goes through for a
+    // second, or limitBytes went out. Then half-closes and reads every answer.
+    static bool Flood(const std::string& socketPath, size_t limitBytes, FloodReport& report);
+
+    // --load <socket> [--clients <n>] [--requests <n>] [--pipeline <n>] [--threads <n>] | [--flood <bytes>].
+    // Exit code 0 if every request got an OK answer (with --flood: if the server pushed back before
+    // <bytes> and then answered every request), 1 otherwise, 2 for bad arguments.
+    static bool IsLoad(int argc, char* argv[]);
+    static int Main(int argc, char* argv[]);
+};
@@ -0,0 +1,142 @@
+#include "HeroMeasures.h"
+#include <cstring>
+
+namespace
+{
+	struct Unit
+	{
+		const char* Name;
+		float Scale;
+		int Precision;
+	};
+
+	const Unit LengthUnits[] = {
+		{ "cm", 1.0f, 3 },
+		{ "m", 100.0f, 2 },
+		{ "meter", 100.0f, 2 },
+		{ "meters", 100.0f, 2 },
+		{ "in", 2.54f, 2 },
+		{ "ft", 30.48f, 2 },
+	};
+	const Unit MassUnits[] = {
+		{ "kg", 1.0f, 3 },
+		{ "lb", 0.45359237f, 2 },
+		{ "lbs", 0.45359237f, 2 },
+		{ "ton", 1000.0f, 1 },
+		{ "tons", 1000.0f, 1 },
+	};
+
+	void SkipSpaces(const char*& p)
+	{
+		while (*p == ' ' || *p == '\t')
+			++p;
+	}
+
+	//digits with optional thousands commas and a fraction; no locale, no allocation
+	bool ParseNumber(const char*& p, float& value)
+	{
+		double whole = 0;
+		bool digits = false;
+		for (; (*p >= '0' && *p <= '9') || (*p == ',' && digits); ++p)
+		{
+			if (*p == ',')
+				continue;
+			whole = whole * 10 + (*p - '0');
+			digits = true;
+		}
+		if (*p == '.')
+		{
+			double scale = 0.1;
+			for (++p; *p >= '0' && *p <= '9'; ++p, scale /= 10)
+			{
+				whole += (*p - '0') * scale;
+				digits = true;
+			}
+		}
+		value = static_cast<float>(whole);
+		return digits;
+	}
+
+	template <size_t N>
+	bool ParseWithUnit(const char* text, const Unit(&units)[N], float& result, int& precision)
+	{
+		const char* p = text;
+		SkipSpaces(p);
+		float value;
+		if (!ParseNumber(p, value))
+			return false;
+		SkipSpaces(p);
+
+		const char* end = p;
+		while ((*end >= 'a' && *end <= 'z') || (*end >= 'A' && *end <= 'Z'))
+			++end;
+		size_t length = static_cast<size_t>(end - p);
+		for (const Unit& unit : units)
+		{
+			if (std::strlen(unit.Name) == length && std::strncmp(unit.Name, p, length) == 0)
+			{
+				result = value * unit.Scale;
+				precision = unit.Precision;
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+float HeroMeasures::ParseHeightCm(const std::pmr::vector<std::pmr::string>& values)
+{
+	float best = 0;
+	int bestPrecision = 0;
+	for (const auto& text : values)
+	{
+		float centimeters;
+		int precision;
+		if (ParseLength(text.c_str(), centimeters, precision) && centimeters > 0 && precision > bestPrecision)
+		{
+			best = centimeters;
+			bestPrecision = precision;
+		}
+	}
+	return best;
+}
+
+float HeroMeasures::ParseWeightKg(const std::pmr::vector<std::pmr::string>& values)
+{
+	float best = 0;
+	int bestPrecision = 0;
+	for (const auto& text : values)
+	{
+		float kilograms;
+		int precision;
+		if (ParseMass(text.c_str(), kilograms, precision) && kilograms > 0 && precision > bestPrecision)
+		{
+			best = kilograms;
+			bestPrecision = precision;
+		}
+	}
+	return best;
+}
+
+bool HeroMeasures::ParseLength(const char* text, float& centimeters, int& precision)
+{
+	//feet and inches: 6'8, 5'10', 100'0
+	const char* p = text;
+	SkipSpaces(p);
+	float feet;
+	if (ParseNumber(p, feet) && *p == '\'')
+	{
+		float inches = 0;
+		++p;
+		ParseNumber(p, inches);
+		centimeters = feet * 30.48f + inches * 2.54f;
+		precision = 2;
+		return true;
+	}
+	return ParseWithUnit(text, LengthUnits, centimeters, precision);
+}
+
+bool HeroMeasures::ParseMass(const char* text, float& kilograms, int& precision)
+{
+	return ParseWithUnit(text, MassUnits, kilograms, precision);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Unit-aware parsing of the appearance height/weight strings, e.g. {"6'8", "203 cm"} or
+// {"980 lb", "441 kg"}. Every entry that parses is considered and the most precise unit
+// wins (cm/kg over feet/meters/lb over tons). 0 means unknown, as in the source data.
+class HeroMeasures final
+{
+public:
+    static float ParseHeightCm(const std::pmr::vector<std::pmr::string>& values);
+    static float ParseWeightKg(const std::pmr::vector<std::pmr::string>& values);
+
+    // Single null-terminated entries; return false if the text is not a number with a known unit.
+    static bool ParseLength(const char* text, float& centimeters, int& precision);
+    static bool ParseMass(const char* text, float& kilograms, int& precision);
+};
@@ -0,0 +1,215 @@
+#include "HeroMemoryReport.h"
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	void CountString(const HeroString& s, size_t& bytes, size_t& allocations)
+	{
+		size_t heap = HeroMemoryReport::HeapBytes(s);
+		bytes += heap;
+		allocations += heap > 0 ? 1 : 0;
+	}
+
+	void CountStrings(const HeroStringList& v, size_t& bytes, size_t& allocations)
+	{
+		bytes += v.capacity() * sizeof(HeroString);
+		allocations += v.capacity() > 0 ? 1 : 0;
+		for (const auto& s : v)
+			CountString(s, bytes, allocations);
+	}
+}
+
+void HeroMemoryReport::MeasureHeroes(const std::vector<Hero>& heroes)
+{
+	_heroCount = heroes.size();
+	size_t fieldInline = 0;
+	for (const Hero& hero : heroes)
+	{
+		MeasureInline("id", sizeof(int));
+		Measure("name", hero.Name());
+		MeasureInline("powerstats", sizeof(HeroStats));
+
+		const HeroAppearance& appearance = hero.Appearance();
+		Measure("appearance.gender", appearance.Gender);
+		Measure("appearance.race", appearance.Race);
+		Measure("appearance.height", appearance.Height);
+		Measure("appearance.weight", appearance.Weight);
+		Measure("appearance.eyeColor", appearance.EyeColor);
+		Measure("appearance.hairColor", appearance.HairColor);
+		MeasureInline("appearance.heightCm/weightKg", sizeof(appearance.HeightCm) + sizeof(appearance.WeightKg));
+
+		const HeroBio& bio = hero.Biography();
+		Measure("biography.fullName", bio.FullName);
+		Measure("biography.alterEgos", bio.AlterEgos);
+		Measure("biography.aliases", bio.Aliases);
+		Measure("biography.placeOfBirth", bio.PlaceOfBirth);
+		Measure("biography.firstAppearance", bio.FirstAppearance);
+		Measure("biography.publisher", bio.Publisher);
+		Measure("biography.alignment", bio.Alignment);
+
+		Measure("work.occupation", hero.Work().Occupation);
+		Measure("work.base", hero.Work().Base);
+		Measure("connections.groupAffiliation", hero.Connections().GroupAffiliation);
+		Measure("connections.relatives", hero.Connections().Relatives);
+
+		const HeroImages& images = hero.Images();
+		Measure("images.xs", images.XS);
+		Measure("images.sm", images.SM);
+		Measure("images.md", images.MD);
+		Measure("images.lg", images.LG);
+	}
+
+	//whatever sizeof(Hero) holds beyond the fields: vtable pointer, padding
+	for (const Field& field : _fields)
+		fieldInline += field.InlineBytes;
+	Field& other = FieldNamed("(vtable, padding)");
+	other.InlineBytes = sizeof(Hero) * heroes.size() - fieldInline;
+
+	AddSection("_heroes spare capacity", (heroes.capacity() - heroes.size()) * sizeof(Hero), 0);
+}
+
+void HeroMemoryReport::AddSection(const std::string& name, size_t bytes, size_t heapAllocations)
+{
+	Section section;
+	section.Name = name;
+	section.Bytes = bytes;
+	section.HeapAllocations = heapAllocations;
+	_sections.push_back(section);
+}
+
+size_t HeroMemoryReport::TotalBytes() const
+{
+	size_t total = 0;
+	for (const Field& field : _fields)
+		total += field.InlineBytes + field.HeapBytes;
+	for (const Section& section : _sections)
+		total += section.Bytes;
+	return total;
+}
+
+void HeroMemoryReport::Print() const
+{
+	std::cout << _heroCount << " heroes, " << TotalBytes() << " bytes total" << std::endl;
+	std::cout << std::left << std::setw(32) << "Field" << std::right
+		<< std::setw(12) << "Inline" << std::setw(12) << "Heap" << std::setw(10) << "Allocs" << std::setw(10) << "SSO %" << std::endl;
+	for (const Field& field : _fields)
+	{
+		std::cout << std::left << std::setw(32) << field.Name << std::right
+			<< std::setw(12) << field.InlineBytes << std::setw(12) << field.HeapBytes << std::setw(10) << field.HeapAllocations;
+		if (field.Strings > 0)
+			std::cout << std::setw(9) << std::fixed << std::setprecision(1) << 100.0 * field.SsoStrings / field.Strings << "%" << std::defaultfloat;
+		std::cout << std::endl;
+	}
+	std::cout << std::endl << std::left << std::setw(32) << "Section" << std::right << std::setw(12) << "Bytes" << std::setw(10) << "Allocs" << std::endl;
+	for (const Section& section : _sections)
+	{
+		std::cout << std::left << std::setw(32) << section.Name << std::right
+			<< std::setw(12) << section.Bytes << std::setw(10) << section.HeapAllocations << std::endl;
+	}
+}
+
+std::string HeroMemoryReport::ToJson() const
+{
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("heroes"); writer.Uint64(_heroCount);
+	writer.Key("totalBytes"); writer.Uint64(TotalBytes());
+	writer.Key("fields");
+	writer.StartArray();
+	for (const Field& field : _fields)
+	{
+		writer.StartObject();
+		writer.Key("field"); writer.String(field.Name.c_str());
+		writer.Key("inlineBytes"); writer.Uint64(field.InlineBytes);
+		writer.Key("heapBytes"); writer.Uint64(field.HeapBytes);
+		writer.Key("heapAllocations"); writer.Uint64(field.HeapAllocations);
+		writer.Key("strings"); writer.Uint64(field.Strings);
+		writer.Key("ssoStrings"); writer.Uint64(field.SsoStrings);
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.Key("sections");
+	writer.StartArray();
+	for (const Section& section : _sections)
+	{
+		writer.StartObject();
+		writer.Key("name"); writer.String(section.Name.c_str());
+		writer.Key("bytes"); writer.Uint64(section.Bytes);
+		writer.Key("heapAllocations"); writer.Uint64(section.HeapAllocations);
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.EndObject();
+	return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+size_t HeroMemoryReport::HeroHeapBytes(const Hero& hero, size_t* heapAllocations)
+{
+	size_t bytes = 0, allocations = 0;
+	CountString(hero.Name(), bytes, allocations);
+	const HeroAppearance& appearance = hero.Appearance();
+	CountString(appearance.Gender, bytes, allocations);
+	CountString(appearance.Race, bytes, allocations);
+	CountStrings(appearance.Height, bytes, allocations);
+	CountStrings(appearance.Weight, bytes, allocations);
+	CountString(appearance.EyeColor, bytes, allocations);
+	CountString(appearance.HairColor, bytes, allocations);
+	const HeroBio& bio = hero.Biography();
+	CountString(bio.FullName, bytes, allocations);
+	CountString(bio.AlterEgos, bytes, allocations);
+	CountStrings(bio.Aliases, bytes, allocations);
+	CountString(bio.PlaceOfBirth, bytes, allocations);
+	CountString(bio.FirstAppearance, bytes, allocations);
+	CountString(bio.Publisher, bytes, allocations);
+	CountString(bio.Alignment, bytes, allocations);
+	CountString(hero.Work().Occupation, bytes, allocations);
+	CountString(hero.Work().Base, bytes, allocations);
+	CountString(hero.Connections().GroupAffiliation, bytes, allocations);
+	CountString(hero.Connections().Relatives, bytes, allocations);
+	CountString(hero.Images().XS, bytes, allocations);
+	CountString(hero.Images().SM, bytes, allocations);
+	CountString(hero.Images().MD, bytes, allocations);
+	CountString(hero.Images().LG, bytes, allocations);
+	if (heapAllocations != nullptr)
+		*heapAllocations += allocations;
+	return bytes;
+}
+
+HeroMemoryReport::Field& HeroMemoryReport::FieldNamed(const char* name)
+{
+	for (Field& field : _fields)
+	{
+		if (field.Name == name)
+			return field;
+	}
+	Field field;
+	field.Name = name;
+	_fields.push_back(field);
+	return _fields.back();
+}
+
+void HeroMemoryReport::Measure(const char* name, const HeroString& value)
+{
+	Field& field = FieldNamed(name);
+	field.InlineBytes += sizeof(HeroString);
+	CountString(value, field.HeapBytes, field.HeapAllocations);
+	field.Strings++;
+	field.SsoStrings += IsInline(value) ? 1 : 0;
+}
+
+void HeroMemoryReport::Measure(const char* name, const HeroStringList& value)
+{
+	Field& field = FieldNamed(name);
+	field.InlineBytes += sizeof(value);
+	CountStrings(value, field.HeapBytes, field.HeapAllocations);
+	field.Strings += value.size();
+	for (const auto& s : value)
+		field.SsoStrings += IsInline(s) ? 1 : 0;
+}
+
+void HeroMemoryReport::MeasureInline(const char* name, size_t bytes)
+{
+	FieldNamed(name).InlineBytes += bytes;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Hero.h"
+
+// Memory accounting for HeroesDB: bytes, live heap blocks and small-string-optimization
+// hits per Hero field, plus totals for the containers and indexes built on top of them.
+// Heap figures count requested bytes; allocator headers and slack are not included.
+class HeroMemoryReport
+{
+public:
+    struct Field
+    {
+        std::string Name;
+        size_t InlineBytes = 0;     // bytes inside the Hero objects themselves
+        size_t HeapBytes = 0;
+        size_t HeapAllocations = 0;
+        size_t Strings = 0;
+        size_t SsoStrings = 0;      // strings stored inline, with no heap block
+    };
+
+    struct Section
+    {
+        std::string Name;
+        size_t Bytes = 0;
+        size_t HeapAllocations = 0;
+    };
+
+    // Per-field breakdown of the heroes list, including the vector's own buffer.
+    void MeasureHeroes(const std::vector<Hero>& heroes);
+    void AddSection(const std::string& name, size_t bytes, size_t heapAllocations);
+
+    size_t TotalBytes() const;
+    void Print() const;
+    std::string ToJson() const;
+
+    // Deep size of one hero outside its own object, for containers holding copies.
+    static size_t HeroHeapBytes(const Hero& hero, size_t* heapAllocations = nullptr);
+
+    // Work for std::string and the arena-backed HeroString alike; arena bytes count as heap.
+    template <typename Alloc>
+    static bool IsInline(const std::basic_string<char, std::char_traits<char>, Alloc>& s)
+    {
+        const char* data = s.data();
+        const char* self = reinterpret_cast<const char*>(&s);
+        return data >= self && data < self + sizeof(s);
+    }
+    template <typename Alloc>
+    static size_t HeapBytes(const std::basic_string<char, std::char_traits<char>, Alloc>& s) { return IsInline(s) ? 0 : s.capacity() + 1; }
+    template <typename Alloc, typename VectorAlloc>
+    static size_t HeapBytes(const std::vector<std::basic_string<char, std::char_traits<char>, Alloc>, VectorAlloc>& v)
+    {
+        size_t bytes = v.capacity() * sizeof(v[0]);
+        for (const auto& s : v)
+            bytes += HeapBytes(s);
+        return bytes;
+    }
+    template <typename T, typename VectorAlloc>
+    static size_t HeapBytes(const std::vector<T, VectorAlloc>& v) { return v.capacity() * sizeof(T); }
+
+private:
+    size_t _heroCount = 0;
+    std::vector<Field> _fields;
+    std::vector<Section> _sections;
+
+    Field& FieldNamed(const char* name);
+    void Measure(const char* name, const HeroString& value);
+    void Measure(const char* name, const HeroStringList& value);
+    void MeasureInline(const char* name, size_t bytes);
+};
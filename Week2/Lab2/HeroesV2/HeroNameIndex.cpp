@@ -0,0 +1,117 @@
+#include "HeroNameIndex.h"
+#include "HeroMemoryReport.h"
+#include <algorithm>
+#include <string_view>
+
+void HeroNameIndex::Build(const std::vector<Hero>& heroes)
+{
+	size_t n = heroes.size();
+	_keys.resize(n);
+	std::vector<Entry> entries(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		_keys[i] = Fold(heroes[i].Name());
+		entries[i] = { PackPrefix(_keys[i]), static_cast<uint32_t>(i) };
+	}
+
+	std::sort(entries.begin(), entries.end(), [this](const Entry& a, const Entry& b) {
+		if (a.Prefix != b.Prefix)
+			return a.Prefix < b.Prefix;
+		//prefixes tie: compare whatever is left past the first 8 bytes
+		std::string_view tailA(_keys[a.Index]), tailB(_keys[b.Index]);
+		int cmp = tailA.substr(std::min<size_t>(8, tailA.size())).compare(tailB.substr(std::min<size_t>(8, tailB.size())));
+		if (cmp != 0)
+			return cmp < 0;
+		return a.Index < b.Index;
+		});
+
+	_order.resize(n);
+	_runStart.resize(n);
+	_runEnd.resize(n);
+	for (size_t p = 0; p < n; p++)
+	{
+		_order[p] = entries[p].Index;
+		bool tiesPrevious = p > 0 && _keys[entries[p].Index] == _keys[entries[p - 1].Index];
+		_runStart[p] = tiesPrevious ? _runStart[p - 1] : static_cast<uint32_t>(p);
+	}
+	for (size_t p = n; p-- > 0; )
+	{
+		bool tiesNext = p + 1 < n && _runStart[p + 1] == _runStart[p];
+		_runEnd[p] = tiesNext ? _runEnd[p + 1] : static_cast<uint32_t>(p);
+	}
+	_built = true;
+}
+
+void HeroNameIndex::Clear()
+{
+	_keys.clear();
+	_order.clear();
+	_runStart.clear();
+	_runEnd.clear();
+	_built = false;
+}
+
+size_t HeroNameIndex::At(size_t position, bool descending) const
+{
+	if (!descending)
+		return _order[position];
+
+	//walk the runs backwards but keep list order inside a run of equal names
+	size_t mirrored = _order.size() - 1 - position;
+	return _order[_runStart[mirrored] + _runEnd[mirrored] - mirrored];
+}
+
+std::vector<size_t> HeroNameIndex::Page(size_t offset, size_t count, bool descending) const
+{
+	std::vector<size_t> page;
+	if (offset >= _order.size())
+		return page;
+
+	size_t end = std::min(_order.size(), offset + count);
+	page.reserve(end - offset);
+	for (size_t p = offset; p < end; p++)
+		page.push_back(At(p, descending));
+	return page;
+}
+
+//equal names sit in list order, so the lower bound is also the first in the list
+size_t HeroNameIndex::Find(std::string_view name) const
+{
+	std::string key = Fold(name);
+	auto it = std::lower_bound(_order.begin(), _order.end(), key, [this](size_t index, const std::string& value) {
+		return _keys[index] < value;
+		});
+	if (it == _order.end() || _keys[*it] != key)
+		return SIZE_MAX;
+	return *it;
+}
+
+size_t HeroNameIndex::MemoryBytes() const
+{
+	return HeroMemoryReport::HeapBytes(_keys) + HeroMemoryReport::HeapBytes(_order) +
+		HeroMemoryReport::HeapBytes(_runStart) + HeroMemoryReport::HeapBytes(_runEnd);
+}
+
+std::string HeroNameIndex::Fold(std::string_view name)
+{
+	std::string folded(name);
+	for (auto& c : folded)
+	{
+		if (c >= 'A' && c <= 'Z')
+			c = static_cast<char>(c - 'A' + 'a');
+	}
+	return folded;
+}
+
+//first 8 bytes big-endian, zero padded, so integer order matches byte order
+uint64_t HeroNameIndex::PackPrefix(const std::string& key)
+{
+	uint64_t prefix = 0;
+	for (size_t i = 0; i < 8; i++)
+	{
+		prefix <<= 8;
+		if (i < key.size())
+			prefix |= static_cast<unsigned char>(key[i]);
+	}
+	return prefix;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Hero.h"
+
+// Case-insensitive name ordering over a hero list.
+//
+// Build folds every name once and sorts compact (8-byte key prefix, index) entries; the
+// full folded key is only consulted when two prefixes tie. The resulting ascending
+// permutation serves ascending, descending and paged name order. Equal names keep their
+// list order in both directions.
+class HeroNameIndex
+{
+public:
+    void Build(const std::vector<Hero>& heroes);
+    void Clear();
+    bool IsBuilt() const { return _built; }
+    size_t Size() const { return _order.size(); }
+    size_t MemoryBytes() const;
+
+    // Index into the hero list of the hero at position in name order.
+    size_t At(size_t position, bool descending = false) const;
+    std::vector<size_t> Page(size_t offset, size_t count, bool descending = false) const;
+    // Index into the hero list of the first hero with this name (case-insensitive), or SIZE_MAX.
+    size_t Find(std::string_view name) const;
+
+    // Lowercases ASCII letters; the same folding _stricmp applies.
+    static std::string Fold(std::string_view name);
+
+private:
+    struct Entry
+    {
+        uint64_t Prefix;
+        uint32_t Index;
+    };
+
+    std::vector<std::string> _keys;
+    std::vector<size_t> _order;
+    std::vector<uint32_t> _runStart;    // first position of each position's run of equal names
+    std::vector<uint32_t> _runEnd;      // last position of that run
+    bool _built = false;
+
+    static uint64_t PackPrefix(const std::string& key);
+};
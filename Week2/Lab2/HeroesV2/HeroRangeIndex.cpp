@@ -0,0 +1,27 @@
+#include "HeroRangeIndex.h"
+#include <algorithm>
+
+void HeroRangeIndex::Build(const std::vector<int>& keys, const std::vector<size_t>& order)
+{
+	_order = order;
+	_sortedKeys.resize(order.size());
+	for (size_t i = 0; i < order.size(); i++)
+		_sortedKeys[i] = keys[order[i]];
+	_built = true;
+}
+
+void HeroRangeIndex::Clear()
+{
+	_sortedKeys.clear();
+	_order.clear();
+	_built = false;
+}
+
+std::vector<size_t> HeroRangeIndex::Range(int low, int high) const
+{
+	if (low > high)
+		return {};
+	auto first = std::lower_bound(_sortedKeys.begin(), _sortedKeys.end(), low);
+	auto last = std::upper_bound(first, _sortedKeys.end(), high);
+	return std::vector<size_t>(_order.begin() + (first - _sortedKeys.begin()), _order.begin() + (last - _sortedKeys.begin()));
+}
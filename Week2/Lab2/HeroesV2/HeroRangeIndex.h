@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Sorted (key, index) pairs for one sort key, answering inclusive range queries with two
+// binary searches.
+class HeroRangeIndex
+{
+public:
+    // order lists hero indices sorted by key; keys is indexed by hero.
+    void Build(const std::vector<int>& keys, const std::vector<size_t>& order);
+    void Clear();
+    bool IsBuilt() const { return _built; }
+    size_t MemoryBytes() const { return _sortedKeys.capacity() * sizeof(int) + _order.capacity() * sizeof(size_t); }
+
+    // Hero indices with low <= key <= high, in key order.
+    std::vector<size_t> Range(int low, int high) const;
+
+private:
+    std::vector<int> _sortedKeys;
+    std::vector<size_t> _order;
+    bool _built = false;
+};
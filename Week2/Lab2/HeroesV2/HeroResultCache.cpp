@@ -0,0 +1,91 @@
+#include "HeroResultCache.h"
+#include <iostream>
+
+HeroResultCache::HeroResultCache(size_t maxBytes, size_t maxEntries) :
+	_maxBytes(maxBytes),
+	_maxEntries(maxEntries == 0 ? 1 : maxEntries)
+{ }
+
+std::shared_ptr<const std::string> HeroResultCache::Find(const std::string& key, uint64_t generation)
+{
+	SyncGeneration(generation);
+	auto it = _entries.find(key);
+	if (it == _entries.end())
+	{
+		_stats.Misses++;
+		return nullptr;
+	}
+	_stats.Hits++;
+	_lru.splice(_lru.begin(), _lru, it->second);
+	return it->second->Value;
+}
+
+std::shared_ptr<const std::string> HeroResultCache::Insert(const std::string& key, std::string value, uint64_t generation)
+{
+	SyncGeneration(generation);
+	auto shared = std::make_shared<const std::string>(std::move(value));
+	Entry entry{ key, shared };
+	size_t bytes = EntryBytes(entry);
+	if (bytes > _maxBytes)
+		return shared;
+
+	auto existing = _entries.find(key);
+	if (existing != _entries.end())
+	{
+		_stats.Bytes -= EntryBytes(*existing->second);
+		_lru.erase(existing->second);
+		_entries.erase(existing);
+	}
+
+	while (!_lru.empty() && (_stats.Bytes + bytes > _maxBytes || _lru.size() >= _maxEntries))
+	{
+		_stats.Bytes -= EntryBytes(_lru.back());
+		_entries.erase(_lru.back().Key);
+		_lru.pop_back();
+		_stats.Evictions++;
+	}
+
+	_lru.push_front(std::move(entry));
+	_entries.emplace(key, _lru.begin());
+	_stats.Bytes += bytes;
+	_stats.Entries = _lru.size();
+	return shared;
+}
+
+void HeroResultCache::Clear()
+{
+	_lru.clear();
+	_entries.clear();
+	_stats.Bytes = 0;
+	_stats.Entries = 0;
+}
+
+void HeroResultCache::SyncGeneration(uint64_t generation)
+{
+	if (generation == _generation)
+		return;
+	if (!_lru.empty())
+		_stats.Invalidations++;
+	Clear();
+	_generation = generation;
+}
+
+//list node and map node overhead is approximated as a few pointers each
+size_t HeroResultCache::EntryBytes(const Entry& entry)
+{
+	return sizeof(Entry) + 2 * sizeof(void*) + entry.Key.capacity() + sizeof(std::string) + entry.Value->capacity() +
+		entry.Key.capacity() + sizeof(std::string) + 4 * sizeof(void*);
+}
+
+size_t HeroResultCache::MemoryBytes() const
+{
+	return _stats.Bytes + _entries.bucket_count() * sizeof(void*);
+}
+
+void HeroResultCache::PrintStats() const
+{
+	std::cout << "Result cache: " << _stats.Entries << " entries, " << MemoryBytes() << " bytes (limit " << _maxBytes
+		<< " bytes, " << _maxEntries << " entries)" << std::endl;
+	std::cout << "  Hits " << _stats.Hits << ", misses " << _stats.Misses << ", hit rate " << _stats.HitRate() * 100 << "%" << std::endl;
+	std::cout << "  Evictions " << _stats.Evictions << ", invalidations " << _stats.Invalidations << std::endl;
+}
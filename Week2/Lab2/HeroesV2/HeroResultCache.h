@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Bounded LRU cache of rendered query results, keyed by operation and parameters
+// (e.g. "sort 2" or "letter s").
+//
+// Entries belong to the DB generation they were computed at. The first lookup or insert
+// under a newer generation drops every entry, so mutations invalidate the cache without
+// having to know which results they affect.
+class HeroResultCache
+{
+public:
+    struct Stats
+    {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint64_t Evictions = 0;
+        uint64_t Invalidations = 0;     // whole-cache drops caused by a generation change
+        size_t Entries = 0;
+        size_t Bytes = 0;
+        double HitRate() const { return Hits + Misses == 0 ? 0 : static_cast<double>(Hits) / (Hits + Misses); }
+    };
+
+    explicit HeroResultCache(size_t maxBytes = 4 << 20, size_t maxEntries = 256);
+
+    // Null on a miss. A hit becomes the most recently used entry.
+    std::shared_ptr<const std::string> Find(const std::string& key, uint64_t generation);
+    // Stores the value and returns it; evicts least recently used entries to stay in bounds.
+    // Values larger than the whole budget are returned without being cached.
+    std::shared_ptr<const std::string> Insert(const std::string& key, std::string value, uint64_t generation);
+    void Clear();
+
+    const Stats& GetStats() const { return _stats; }
+    size_t MemoryBytes() const;
+    void PrintStats() const;
+
+private:
+    struct Entry
+    {
+        std::string Key;
+        std::shared_ptr<const std::string> Value;
+    };
+
+    std::list<Entry> _lru;      // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> _entries;
+    uint64_t _generation = 0;
+    size_t _maxBytes;
+    size_t _maxEntries;
+    Stats _stats;
+
+    void SyncGeneration(uint64_t generation);
+    static size_t EntryBytes(const Entry& entry);
+};
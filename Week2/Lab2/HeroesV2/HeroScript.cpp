@@ -0,0 +1,349 @@
+#include "HeroScript.h"
+#include "HeroAllocations.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	//swallows command output under --quiet so stdout carries only the summary
+	class NullBuffer : public std::streambuf
+	{
+	protected:
+		int overflow(int c) override { return c; }
+	};
+
+	std::string Lower(std::string text)
+	{
+		for (auto& c : text)
+		{
+			if (c >= 'A' && c <= 'Z')
+				c = static_cast<char>(c - 'A' + 'a');
+		}
+		return text;
+	}
+
+	bool ReadScript(const std::string& path, std::vector<std::string>& commands)
+	{
+		std::ifstream file;
+		if (path != "-")
+		{
+			file.open(path);
+			if (!file)
+				return false;
+		}
+		std::istream& in = path == "-" ? std::cin : file;
+		std::string line;
+		while (std::getline(in, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			size_t start = line.find_first_not_of(' ');
+			if (start != std::string::npos && line[start] != '#')
+				commands.push_back(line.substr(start));
+		}
+		return true;
+	}
+}
+
+bool HeroScript::IsBatch(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--cmd") == 0 || std::strcmp(argv[i], "--script") == 0)
+			return true;
+	}
+	return false;
+}
+
+int HeroScript::Run(int argc, char* argv[])
+{
+	std::vector<std::string> commands;
+	int repeat = 1;
+	bool quiet = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--cmd" && hasValue)
+			commands.push_back(argv[++i]);
+		else if (arg == "--script" && hasValue)
+		{
+			if (!ReadScript(argv[++i], commands))
+			{
+				std::cerr << "Cannot read script " << argv[i] << std::endl;
+				return 2;
+			}
+		}
+		else if (arg == "--repeat" && hasValue && ParseInt(argv[i + 1], repeat) && repeat > 0)
+			++i;
+		else if (arg == "--quiet")
+			quiet = true;
+		else
+		{
+			std::cerr << "Usage: HeroesV2 [--cmd \"<command>\"]... [--script <file>|-] [--repeat <n>] [--quiet]" << std::endl;
+			return 2;
+		}
+	}
+
+	NullBuffer nullBuffer;
+	std::streambuf* console = quiet ? std::cout.rdbuf(&nullBuffer) : nullptr;
+
+	//the load counts as an operation of its own
+	Result load;
+	load.Command = "load";
+	size_t allocations = HeroAllocations::Count(), bytes = HeroAllocations::Bytes();
+	auto start = std::chrono::steady_clock::now();
+	HeroesDB heroDB;
+	load.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	load.Allocations = HeroAllocations::Count() - allocations;
+	load.AllocatedBytes = HeroAllocations::Bytes() - bytes;
+	load.Ok = heroDB.Count() > 0;
+	std::cerr << "load: " << load.Milliseconds << " ms, " << load.Allocations << " allocations, " << load.AllocatedBytes << " bytes" << std::endl;
+
+	std::vector<Result> results;
+	results.reserve(commands.size() * repeat);
+	for (int r = 0; r < repeat; r++)
+	{
+		for (const auto& command : commands)
+			results.push_back(Measure(command, heroDB));
+	}
+
+	if (console != nullptr)
+		std::cout.rdbuf(console);
+	std::cout << Summary(load, results) << std::endl;
+
+	for (const auto& result : results)
+	{
+		if (!result.Ok)
+			return 1;
+	}
+	return load.Ok ? 0 : 1;
+}
+
+HeroScript::Result HeroScript::Measure(const std::string& command, HeroesDB& heroDB)
+{
+	Result result;
+	result.Command = command;
+	size_t allocations = HeroAllocations::Count(), bytes = HeroAllocations::Bytes();
+	auto start = std::chrono::steady_clock::now();
+	result.Ok = Execute(heroDB, command);
+	result.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	result.Allocations = HeroAllocations::Count() - allocations;
+	result.AllocatedBytes = HeroAllocations::Bytes() - bytes;
+
+	std::cerr << command << ": ";
+	if (!result.Ok)
+		std::cerr << "FAILED, ";
+	std::cerr << result.Milliseconds << " ms, " << result.Allocations << " allocations, " << result.AllocatedBytes << " bytes" << std::endl;
+	return result;
+}
+
+bool HeroScript::Execute(HeroesDB& heroDB, const std::string& command)
+{
+	std::string rest;
+	std::string verb = Lower(NextWord(command, rest));
+	std::string args;
+
+	if (verb == "sort")
+	{
+		SortBy sortBy;
+		if (Lower(rest) == "name")
+			heroDB.SortByNameDescending();
+		else if (ParseSortBy(rest, sortBy))
+			heroDB.SortByAttribute(sortBy);
+		else
+			return false;
+		return true;
+	}
+	if (verb == "find" && !rest.empty())
+	{
+		heroDB.FindHero(rest);
+		return true;
+	}
+	if (verb == "letter" && rest.size() == 1)
+	{
+		heroDB.FindHeroesByLetter(rest[0]);
+		return true;
+	}
+	if (verb == "groups" && rest.empty())
+	{
+		heroDB.PrintGroupCounts();
+		return true;
+	}
+	if (verb == "remove" && !rest.empty())
+	{
+		heroDB.RemoveHero(rest);
+		return true;
+	}
+	if (verb == "similar")
+	{
+		DistanceMetric metric;
+		std::string name;
+		if (!ParseMetric(NextWord(rest, name), metric) || name.empty())
+			return false;
+		heroDB.FindSimilarHeroes(name, 20, metric);
+		return true;
+	}
+	if (verb == "stats")
+	{
+		GroupBy groupBy;
+		SortBy stat;
+		if (!ParseGroupBy(NextWord(rest, args), groupBy) || !ParseSortBy(args, stat))
+			return false;
+		heroDB.PrintGroupStats(groupBy, stat);
+		return true;
+	}
+	if (verb == "range")
+	{
+		SortBy sortBy;
+		int low, high;
+		std::string bounds;
+		if (!ParseSortBy(NextWord(rest, args), sortBy) || !ParseInt(NextWord(args, bounds), low) || !ParseInt(bounds, high))
+			return false;
+		heroDB.FindHeroesInRange(sortBy, low, high);
+		return true;
+	}
+	if (verb == "memory" && (rest.empty() || Lower(rest) == "json"))
+	{
+		HeroMemoryReport report = heroDB.MemoryReport();
+		if (rest.empty())
+			report.Print();
+		else
+			std::cout << report.ToJson() << std::endl;
+		return true;
+	}
+	if (verb == "cache" && rest.empty())
+	{
+		heroDB.ResultCache().PrintStats();
+		return true;
+	}
+	if (verb == "import" && !rest.empty())
+		return heroDB.ImportHeroes(rest);
+	if (verb == "dupes" && (rest.empty() || Lower(rest) == "merge"))
+	{
+		heroDB.FindDuplicates(!rest.empty());
+		return true;
+	}
+	if (verb == "checkpoint" && rest.empty())
+		return heroDB.Checkpoint();
+	if (verb == "reload" && rest.empty())
+	{
+		heroDB.Reload();
+		return true;
+	}
+	return false;
+}
+
+std::string HeroScript::Summary(const Result& load, const std::vector<Result>& results)
+{
+	double totalMilliseconds = 0;
+	size_t totalAllocations = 0, totalBytes = 0, failed = 0;
+	for (const auto& result : results)
+	{
+		totalMilliseconds += result.Milliseconds;
+		totalAllocations += result.Allocations;
+		totalBytes += result.AllocatedBytes;
+		failed += result.Ok ? 0 : 1;
+	}
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	auto writeResult = [&writer](const Result& result) {
+		writer.StartObject();
+		writer.Key("cmd"); writer.String(result.Command.c_str(), static_cast<rapidjson::SizeType>(result.Command.size()));
+		writer.Key("ok"); writer.Bool(result.Ok);
+		writer.Key("ms"); writer.Double(result.Milliseconds);
+		writer.Key("allocations"); writer.Uint64(result.Allocations);
+		writer.Key("bytes"); writer.Uint64(result.AllocatedBytes);
+		writer.EndObject();
+	};
+
+	writer.StartObject();
+	writer.Key("load"); writeResult(load);
+	writer.Key("commands"); writer.Uint64(results.size());
+	writer.Key("failed"); writer.Uint64(failed);
+	writer.Key("totalMs"); writer.Double(totalMilliseconds);
+	writer.Key("totalAllocations"); writer.Uint64(totalAllocations);
+	writer.Key("totalBytes"); writer.Uint64(totalBytes);
+	writer.Key("ops");
+	writer.StartArray();
+	for (const auto& result : results)
+		writeResult(result);
+	writer.EndArray();
+	writer.EndObject();
+	return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+std::string HeroScript::NextWord(const std::string& text, std::string& rest)
+{
+	size_t start = text.find_first_not_of(' ');
+	if (start == std::string::npos)
+	{
+		rest.clear();
+		return "";
+	}
+	size_t end = text.find(' ', start);
+	std::string word = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+	size_t restStart = end == std::string::npos ? std::string::npos : text.find_first_not_of(' ', end);
+	size_t restEnd = text.find_last_not_of(' ');
+	rest = restStart == std::string::npos ? "" : text.substr(restStart, restEnd - restStart + 1);
+	return word;
+}
+
+bool HeroScript::ParseSortBy(const std::string& word, SortBy& sortBy)
+{
+	const char* names[] = { "intelligence", "strength", "speed", "durability", "power", "combat", "height", "weight" };
+	for (int i = 0; i < 8; i++)
+	{
+		if (Lower(word) == names[i])
+		{
+			sortBy = static_cast<SortBy>(i + 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool HeroScript::ParseGroupBy(const std::string& word, GroupBy& groupBy)
+{
+	const char* names[] = { "publisher", "alignment", "race", "gender" };
+	for (int i = 0; i < 4; i++)
+	{
+		if (Lower(word) == names[i])
+		{
+			groupBy = static_cast<GroupBy>(i + 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool HeroScript::ParseMetric(const std::string& word, DistanceMetric& metric)
+{
+	const char* names[] = { "l1", "l2", "cosine" };
+	for (int i = 0; i < 3; i++)
+	{
+		if (Lower(word) == names[i])
+		{
+			metric = static_cast<DistanceMetric>(i + 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool HeroScript::ParseInt(const std::string& word, int& value)
+{
+	try
+	{
+		size_t used;
+		value = std::stoi(word, &used);
+		return used == word.size();
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "HeroesDB.h"
+
+// Non-interactive driver for HeroesDB, e.g.
+//
+//     HeroesV2 --cmd "sort strength" --cmd "find Batman" --quiet
+//
+// Commands run back to back. Each one reports its wall time and heap allocations on stderr,
+// and a JSON summary of the whole run is printed on stdout at the end. Commands:
+//
+//     sort name | sort <stat>            find <name>          letter <c>
+//     groups                             remove <name>        similar <l1|l2|cosine> <name>
+//     stats <group> <stat>               range <stat> <low> <high>
+//     memory [json]                      cache                checkpoint           reload
+//     import <file>                      dupes [merge]
+//
+// where <stat> is intelligence..combat, height or weight and <group> is publisher,
+// alignment, race or gender.
+class HeroScript final
+{
+public:
+    struct Result
+    {
+        std::string Command;
+        bool Ok = false;
+        double Milliseconds = 0;
+        size_t Allocations = 0;
+        size_t AllocatedBytes = 0;
+    };
+
+    // True if the arguments ask for batch mode (--cmd or --script) instead of the menu.
+    static bool IsBatch(int argc, char* argv[]);
+    // Loads the DB and runs the commands. Exit code 0 if all ran, 1 if any failed, 2 for bad arguments.
+    static int Run(int argc, char* argv[]);
+    // Runs one command. False if it is unknown or its arguments do not parse.
+    static bool Execute(HeroesDB& heroDB, const std::string& command);
+
+    // Argument parsing, shared with HeroServer. Names are case-insensitive.
+    // NextWord splits off the first word; rest gets what follows it, trimmed of spaces.
+    static std::string NextWord(const std::string& text, std::string& rest);
+    static bool ParseSortBy(const std::string& word, SortBy& sortBy);
+    static bool ParseGroupBy(const std::string& word, GroupBy& groupBy);
+    static bool ParseMetric(const std::string& word, DistanceMetric& metric);
+    static bool ParseInt(const std::string& word, int& value);
+
+private:
+    static Result Measure(const std::string& command, HeroesDB& heroDB);
+    static std::string Summary(const Result& load, const std::vector<Result>& results);
+};
@@ -0,0 +1,509 @@
+#include "HeroServer.h"
+#include "HeroScript.h"
+#include <algorithm>
+#include <cstring>
+#ifdef __linux__
+#include <csignal>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	HeroServer* signalTarget = nullptr;
+
+	void OnSignal(int)
+	{
+		if (signalTarget != nullptr)
+			signalTarget->Stop();
+	}
+
+	std::string Upper(std::string text)
+	{
+		for (auto& c : text)
+		{
+			if (c >= 'a' && c <= 'z')
+				c = static_cast<char>(c - 'a' + 'A');
+		}
+		return text;
+	}
+
+	std::string Ok(const rapidjson::StringBuffer& buffer)
+	{
+		return "OK " + std::string(buffer.GetString(), buffer.GetSize());
+	}
+}
+
+HeroServer::HeroServer(HeroesDB& heroDB, const std::string& socketPath, size_t workers) :
+	_heroDB(heroDB),
+	_socketPath(socketPath),
+	_workerCount(workers == 0 ? 1 : workers)
+{ }
+
+HeroServer::~HeroServer()
+{
+	Stop();
+}
+
+std::string HeroServer::Handle(const std::string& request)
+{
+	std::string rest, args;
+	std::string verb = Upper(HeroScript::NextWord(request, rest));
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+	if (verb == "PING" && rest.empty())
+		return "OK PONG";
+	if (verb == "COUNT" && rest.empty())
+		return "OK " + std::to_string(_heroDB.Count());
+	if (verb == "GET" && !rest.empty())
+	{
+		const Hero* hero = _heroDB.FindByName(rest);
+		if (hero == nullptr)
+			return "ERR not found";
+		hero->Serialize(&writer);
+		return Ok(buffer);
+	}
+	if (verb == "RANGE")
+	{
+		SortBy sortBy;
+		int low, high;
+		std::string bounds;
+		if (!HeroScript::ParseSortBy(HeroScript::NextWord(rest, args), sortBy) ||
+			!HeroScript::ParseInt(HeroScript::NextWord(args, bounds), low) || !HeroScript::ParseInt(bounds, high))
+			return "ERR usage: RANGE <stat> <low> <high>";
+		const std::vector<Hero>& heroes = _heroDB.Heroes();
+		writer.StartArray();
+		for (size_t index : _heroDB.HeroesInRange(sortBy, low, high))
+			writer.Int(heroes[index].Id());
+		writer.EndArray();
+		return Ok(buffer);
+	}
+	if (verb == "SIMILAR")
+	{
+		DistanceMetric metric;
+		int k;
+		std::string name;
+		if (!HeroScript::ParseMetric(HeroScript::NextWord(rest, args), metric) ||
+			!HeroScript::ParseInt(HeroScript::NextWord(args, name), k) || k < 1 || k > 1000 || name.empty())
+			return "ERR usage: SIMILAR <l1|l2|cosine> <k 1-1000> <name>";
+		const Hero* hero = _heroDB.FindByName(name);
+		if (hero == nullptr)
+			return "ERR not found";
+		const std::vector<Hero>& heroes = _heroDB.Heroes();
+		writer.StartArray();
+		for (const HeroNeighbor& neighbor : _heroDB.SimilarTo(hero - heroes.data(), k, metric))
+		{
+			writer.StartArray();
+			writer.Int(heroes[neighbor.Index].Id());
+			writer.Double(neighbor.Distance);
+			writer.EndArray();
+		}
+		writer.EndArray();
+		return Ok(buffer);
+	}
+	return "ERR unknown command";
+}
+
+bool HeroServer::IsServe(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--serve") == 0)
+			return true;
+	}
+	return false;
+}
+
+int HeroServer::Main(int argc, char* argv[])
+{
+	std::string socketPath;
+	int workers = static_cast<int>(std::thread::hardware_concurrency());
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--serve" && i + 1 < argc)
+			socketPath = argv[++i];
+		else if (arg == "--workers" && i + 1 < argc && HeroScript::ParseInt(argv[i + 1], workers) && workers > 0)
+			++i;
+		else
+		{
+			std::cerr << "Usage: HeroesV2 --serve <socket path> [--workers <n>]" << std::endl;
+			return 2;
+		}
+	}
+	if (socketPath.empty())
+	{
+		std::cerr << "Usage: HeroesV2 --serve <socket path> [--workers <n>]" << std::endl;
+		return 2;
+	}
+
+	HeroesDB heroDB;
+	HeroServer server(heroDB, socketPath, workers);
+#ifdef __linux__
+	std::signal(SIGPIPE, SIG_IGN);
+	signalTarget = &server;
+	std::signal(SIGINT, OnSignal);
+	std::signal(SIGTERM, OnSignal);
+#endif
+	bool ok = server.Run();
+	signalTarget = nullptr;
+	return ok ? 0 : 1;
+}
+
+#ifdef __linux__
+
+bool HeroServer::Run()
+{
+	_heroDB.WarmIndexes();
+	if (!Listen())
+		return false;
+
+	_stopping = false;
+	for (size_t i = 0; i < _workerCount; i++)
+		_workers.emplace_back(&HeroServer::WorkerLoop, this);
+	std::cerr << "Serving " << _heroDB.Count() << " heroes on " << _socketPath << " with " << _workerCount << " workers" << std::endl;
+
+	epoll_event events[256];
+	while (!_stopping)
+	{
+		int ready = epoll_wait(_epollFd, events, 256, -1);
+		if (ready < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		for (int e = 0; e < ready; e++)
+		{
+			int fd = events[e].data.fd;
+			if (fd == _listenFd)
+			{
+				Accept();
+				continue;
+			}
+			if (fd == _wakeFd)
+			{
+				uint64_t count;
+				while (read(_wakeFd, &count, sizeof(count)) > 0) {}
+				CollectDone();
+				continue;
+			}
+
+			auto it = _connections.find(fd);
+			if (it == _connections.end())
+				continue;
+			if (events[e].events & EPOLLOUT)
+				WriteTo(it->second);
+			//WriteTo may have closed it
+			it = _connections.find(fd);
+			if (it == _connections.end())
+				continue;
+			if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+				ReadFrom(it->second);
+			else if (events[e].events & EPOLLOUT)
+				Dispatch(it->second);   //lines held back while the client was not reading its answers
+		}
+	}
+
+	//shut down: workers first, then every socket
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		_stopping = true;
+	}
+	_jobReady.notify_all();
+	for (auto& worker : _workers)
+		worker.join();
+	_workers.clear();
+	_jobs.clear();
+	_done.clear();
+	for (auto& entry : _connections)
+		close(entry.first);
+	_connections.clear();
+	close(_listenFd);
+	close(_epollFd);
+	close(_wakeFd);
+	_listenFd = _epollFd = _wakeFd = -1;
+	unlink(_socketPath.c_str());
+	std::cerr << "Server stopped" << std::endl;
+	return true;
+}
+
+void HeroServer::Stop()
+{
+	_stopping = true;
+	Wake();
+}
+
+void HeroServer::Wake()
+{
+	if (_wakeFd >= 0)
+	{
+		uint64_t one = 1;
+		ssize_t written = write(_wakeFd, &one, sizeof(one));
+		(void)written;
+	}
+}
+
+bool HeroServer::Listen()
+{
+	sockaddr_un address{};
+	if (_socketPath.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << "Socket path is too long: " << _socketPath << std::endl;
+		return false;
+	}
+
+	//thousands of clients need thousands of descriptors
+	rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, _socketPath.c_str(), _socketPath.size() + 1);
+	unlink(_socketPath.c_str());
+
+	_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	_epollFd = epoll_create1(EPOLL_CLOEXEC);
+	_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_listenFd < 0 || _epollFd < 0 || _wakeFd < 0 ||
+		bind(_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+		listen(_listenFd, 4096) != 0)
+	{
+		std::cerr << "Cannot listen on " << _socketPath << ": " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = _listenFd;
+	epoll_ctl(_epollFd, EPOLL_CTL_ADD, _listenFd, &event);
+	event.data.fd = _wakeFd;
+	epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &event);
+	return true;
+}
+
+void HeroServer::Accept()
+{
+	while (true)
+	{
+		int fd = accept4(_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0)
+		{
+			if (errno == EMFILE || errno == ENFILE)
+				std::cerr << "Out of file descriptors; raise the open files limit" << std::endl;
+			return;
+		}
+
+		Connection& connection = _connections[fd];
+		connection = Connection();
+		connection.Fd = fd;
+		connection.Id = _nextId++;
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event);
+	}
+}
+
+void HeroServer::ReadFrom(Connection& connection)
+{
+	char chunk[64 * 1024];
+	//past MaxPendingInput the rest waits in the socket until Dispatch has worked through In
+	while (connection.In.size() < MaxPendingInput)
+	{
+		ssize_t received = read(connection.Fd, chunk, std::min(sizeof(chunk), MaxPendingInput - connection.In.size()));
+		if (received > 0)
+		{
+			connection.In.append(chunk, received);
+			continue;
+		}
+		if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (received < 0 && errno == EINTR)
+			continue;
+
+		//peer closed (or failed): answer what it already sent, then close
+		connection.Closing = true;
+		break;
+	}
+	Dispatch(connection);
+}
+
+void HeroServer::Dispatch(Connection& connection)
+{
+	if (!connection.Busy && connection.Out.size() - connection.OutPos < MaxPendingOutput)
+	{
+		Job job{ connection.Fd, connection.Id, {}, {} };
+		size_t start = 0, newline;
+		while (job.Requests.size() < MaxBatch && (newline = connection.In.find('\n', start)) != std::string::npos)
+		{
+			size_t end = newline > start && connection.In[newline - 1] == '\r' ? newline - 1 : newline;
+			job.Requests.emplace_back(connection.In, start, end - start);
+			start = newline + 1;
+		}
+		connection.In.erase(0, start);
+
+		if (!job.Requests.empty())
+		{
+			connection.Busy = true;
+			{
+				std::lock_guard<std::mutex> lock(_jobMutex);
+				_jobs.push_back(std::move(job));
+			}
+			_jobReady.notify_one();
+			UpdateEvents(connection);
+			return;
+		}
+		if (connection.In.size() > MaxLineLength)
+		{
+			connection.Out += "ERR line too long\n";
+			connection.In.clear();
+			connection.Closing = true;
+			WriteTo(connection);
+			return;
+		}
+	}
+	if (connection.Closing && !connection.Busy && connection.OutPos == connection.Out.size())
+		Close(connection);
+	else
+		UpdateEvents(connection);
+}
+
+void HeroServer::UpdateEvents(Connection& connection)
+{
+	bool wantRead = !connection.Closing && !connection.Busy && connection.In.size() < MaxPendingInput &&
+		connection.Out.size() - connection.OutPos < MaxPendingOutput;
+	bool wantWrite = connection.OutPos < connection.Out.size();
+	if (wantRead == connection.WantRead && wantWrite == connection.WantWrite)
+		return;
+
+	connection.WantRead = wantRead;
+	connection.WantWrite = wantWrite;
+	epoll_event event{};
+	event.events = (wantRead ? static_cast<uint32_t>(EPOLLIN) : 0) | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0);
+	event.data.fd = connection.Fd;
+	epoll_ctl(_epollFd, EPOLL_CTL_MOD, connection.Fd, &event);
+}
+
+void HeroServer::WriteTo(Connection& connection)
+{
+	while (connection.OutPos < connection.Out.size())
+	{
+		ssize_t sent = send(connection.Fd, connection.Out.data() + connection.OutPos,
+			connection.Out.size() - connection.OutPos, MSG_NOSIGNAL);
+		if (sent > 0)
+		{
+			connection.OutPos += sent;
+			continue;
+		}
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		Close(connection);
+		return;
+	}
+
+	bool pending = connection.OutPos < connection.Out.size();
+	if (!pending)
+	{
+		connection.Out.clear();
+		connection.OutPos = 0;
+	}
+	//a client that half-closed still gets answers to the lines left in In; Dispatch closes after those
+	if (!pending && connection.Closing && !connection.Busy && connection.In.find('\n') == std::string::npos)
+		Close(connection);
+	else
+		UpdateEvents(connection);
+}
+
+void HeroServer::CollectDone()
+{
+	std::vector<Job> done;
+	{
+		std::lock_guard<std::mutex> lock(_doneMutex);
+		done.swap(_done);
+	}
+	for (Job& job : done)
+	{
+		//the client may have gone and its descriptor been reused meanwhile
+		auto it = _connections.find(job.Fd);
+		if (it == _connections.end() || it->second.Id != job.ConnectionId)
+			continue;
+		Connection& connection = it->second;
+		connection.Busy = false;
+		connection.Out += job.Responses;
+		if (job.Quit)
+		{
+			connection.Closing = true;
+			connection.In.clear();
+		}
+		WriteTo(connection);
+		it = _connections.find(job.Fd);
+		if (it != _connections.end() && it->second.Id == job.ConnectionId)
+			Dispatch(it->second);
+	}
+}
+
+void HeroServer::Close(Connection& connection)
+{
+	int fd = connection.Fd;
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+	close(fd);
+	_connections.erase(fd);
+}
+
+void HeroServer::WorkerLoop()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_jobMutex);
+			_jobReady.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+			if (_stopping)
+				return;
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		for (const auto& request : job.Requests)
+		{
+			if (Upper(request) == "QUIT")
+			{
+				job.Quit = true;
+				break;
+			}
+			job.Responses += Handle(request);
+			job.Responses += '\n';
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_doneMutex);
+			_done.push_back(std::move(job));
+		}
+		Wake();
+	}
+}
+
+#else
+
+bool HeroServer::Run()
+{
+	std::cerr << "The query server needs Linux (epoll and Unix domain sockets)" << std::endl;
+	return false;
+}
+
+void HeroServer::Stop() { }
+
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "HeroesDB.h"
+
+// Read-only query server over a Unix domain socket, so many local processes can share one
+// loaded HeroesDB instead of each loading heroes.json. Linux only (epoll); elsewhere Run()
+// reports that and fails.
+//
+// One request per line, one response line per request, in request order, so clients may
+// pipeline as deep as they like:
+//
+//     PING                                  OK PONG
+//     COUNT                                 OK 563
+//     GET <name>                            OK {hero json}          | ERR not found
+//     RANGE <stat> <low> <high>             OK [id,...]
+//     SIMILAR <l1|l2|cosine> <k> <name>     OK [[id,distance],...]  | ERR not found
+//     QUIT                                  closes the connection
+//
+// One thread runs the epoll loop (accept, read, write); complete request lines are handed
+// to a worker pool as one batch per connection. A connection has at most one batch in
+// flight, which keeps its responses ordered. A connection is not read while its batch is out,
+// while its answers pile up unread, or once MaxPendingInput is buffered, so a client that
+// pipelines without reading waits in its socket instead of in server memory. Indexes are warmed before serving, so the
+// workers only read the DB.
+class HeroServer
+{
+public:
+    static const size_t MaxLineLength = 4096;
+    static const size_t MaxBatch = 256;                 // requests handed to a worker at once
+    static const size_t MaxPendingOutput = 1 << 20;     // stop dispatching a client that is not reading
+    static const size_t MaxPendingInput = MaxBatch * MaxLineLength;    // stop reading a client that is this far ahead
+
+    HeroServer(HeroesDB& heroDB, const std::string& socketPath, size_t workers);
+    ~HeroServer();
+
+    HeroServer(const HeroServer&) = delete;
+    HeroServer& operator=(const HeroServer&) = delete;
+
+    // Serves until Stop(). False if the socket could not be set up.
+    bool Run();
+    // Safe to call from another thread or a signal handler.
+    void Stop();
+
+    // Answers one request line (without the newline). Used by the workers.
+    std::string Handle(const std::string& request);
+
+    // --serve <socket> [--workers <n>]. Exit code 0 after a clean shutdown, 1 on errors, 2 for bad arguments.
+    static bool IsServe(int argc, char* argv[]);
+    static int Main(int argc, char* argv[]);
+
+private:
+    struct Connection
+    {
+        int Fd = -1;
+        uint64_t Id = 0;
+        std::string In;
+        std::string Out;
+        size_t OutPos = 0;          // bytes of Out already written
+        bool Busy = false;          // a batch is with the workers
+        bool Closing = false;       // close once Out is flushed and no batch is pending
+        bool WantRead = true;       // registered for EPOLLIN
+        bool WantWrite = false;     // registered for EPOLLOUT
+    };
+
+    struct Job
+    {
+        int Fd;
+        uint64_t ConnectionId;
+        std::vector<std::string> Requests;
+        std::string Responses;
+        bool Quit = false;
+    };
+
+    HeroesDB& _heroDB;
+    std::string _socketPath;
+    size_t _workerCount;
+    int _listenFd = -1;
+    int _epollFd = -1;
+    int _wakeFd = -1;           // eventfd: finished jobs or Stop()
+    uint64_t _nextId = 1;
+    std::atomic<bool> _stopping{ false };
+    std::unordered_map<int, Connection> _connections;
+
+    std::mutex _jobMutex;
+    std::condition_variable _jobReady;
+    std::deque<Job> _jobs;
+    std::mutex _doneMutex;
+    std::vector<Job> _done;
+    std::vector<std::thread> _workers;
+
+    bool Listen();
+    void Accept();
+    void ReadFrom(Connection& connection);
+    void WriteTo(Connection& connection);
+    void Dispatch(Connection& connection);
+    void UpdateEvents(Connection& connection);     // arms EPOLLIN/EPOLLOUT for the connection's state
+    void CollectDone();
+    void Close(Connection& connection);
+    void WorkerLoop();
+    void Wake();
+};
@@ -5,6 +5,11 @@
 #include <string_view>
 #include <locale>
 #include <cctype>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "rapidjson/parallelwriter.h"
 
 
 
@@ -75,18 +80,239 @@ void HeroesDB::MergeSort(std::vector<Hero>& heroes, int left, int right, SortBy
 
 void HeroesDB::SortByAttribute(SortBy sortBy)
 {
+	PrintCached("sort " + std::to_string(sortBy), [&](std::ostream& out) {
+		for (size_t index : SortOrder(sortBy))
+		{
+			const Hero& hero = _heroes[index];
+			std::string attribute = hero.GetSortByAttribute(sortBy);
+			out << hero.Id() << ": " << attribute << " - " << hero.Name() << '\n';
+		}
+		});
+}
 
-	std::vector<Hero> sortedHeroes = _heroes;
-	MergeSort(sortedHeroes, 0, sortedHeroes.size() - 1, sortBy);
-	for (const Hero& hero : sortedHeroes)
+std::vector<size_t> HeroesDB::CountingSort(const std::vector<Hero>& heroes, SortBy sortBy, const std::vector<size_t>& order) const
+{
+	size_t n = order.empty() ? heroes.size() : order.size();
+
+	//pull each key out once so the passes below never touch the Hero objects
+	std::vector<int> keys(n);
+	int minKey = INT_MAX, maxKey = INT_MIN;
+	for (size_t i = 0; i < n; i++)
 	{
+		size_t index = order.empty() ? i : order[i];
+		keys[i] = heroes[index].GetSortByValue(sortBy);
+		minKey = std::min(minKey, keys[i]);
+		maxKey = std::max(maxKey, keys[i]);
+	}
+	return CountingSort(keys, minKey, maxKey, order);
+}
+
+std::vector<size_t> HeroesDB::CountingSort(const std::vector<int>& keys, int minKey, int maxKey, const std::vector<size_t>& order)
+{
+	size_t n = keys.size();
+	std::vector<size_t> sorted(n);
+	if (n == 0)
+		return sorted;
+
+	std::vector<size_t> counts(static_cast<size_t>(maxKey) - minKey + 2, 0);
+	for (int key : keys)
+		counts[key - minKey + 1]++;
+	for (size_t k = 1; k < counts.size(); k++)
+		counts[k] += counts[k - 1];
+
+	//scatter in input order so equal keys keep their relative position
+	for (size_t i = 0; i < n; i++)
+		sorted[counts[keys[i] - minKey]++] = order.empty() ? i : order[i];
+	return sorted;
+}
+
+std::vector<size_t> HeroesDB::SortOrder(SortBy sortBy)
+{
+	std::vector<size_t> order;
+	if (_heroes.empty())
+		return order;
+
+	std::vector<int> keys(_heroes.size());
+	for (size_t i = 0; i < _heroes.size(); i++)
+		keys[i] = _heroes[i].GetSortByValue(sortBy);
+
+	auto range = std::minmax_element(keys.begin(), keys.end());
+	if (static_cast<long long>(*range.second) - *range.first < CountingSortMaxRange)
+		return CountingSort(keys, *range.first, *range.second);
+
+	//wide keys: fall back to a comparison sort over the extracted keys
+	order.resize(_heroes.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+	return order;
+}
 
-		std::string attribute = hero.GetSortByAttribute(sortBy);
-		std::cout << hero.Id() << ": " << attribute << " - " << hero.Name() << std::endl;
+void HeroesDB::FindHeroesInRange(SortBy sortBy, int low, int high)
+{
+	std::string key = "range " + std::to_string(sortBy) + " " + std::to_string(low) + " " + std::to_string(high);
+	PrintCached(key, [&](std::ostream& out) {
+		std::vector<size_t> matches = HeroesInRange(sortBy, low, high);
+		if (matches.empty())
+			out << "No heroes found in that range" << '\n';
+		for (size_t i : matches)
+		{
+			const Hero& hero = _heroes[i];
+			out << hero.Id() << ": " << hero.GetSortByAttribute(sortBy) << " - " << hero.Name() << '\n';
+		}
+		});
+}
+
+const Hero* HeroesDB::FindByName(std::string_view name)
+{
+	if (!_nameIndex.IsBuilt())
+		_nameIndex.Build(_heroes);
+	size_t index = _nameIndex.Find(name);
+	return index == SIZE_MAX ? nullptr : &_heroes[index];
+}
+
+std::vector<size_t> HeroesDB::HeroesInRange(SortBy sortBy, int low, int high)
+{
+	//find() rather than [] so a built index is only read
+	auto it = _rangeIndexes.find(sortBy);
+	if (it == _rangeIndexes.end())
+	{
+		std::vector<int> keys(_heroes.size());
+		for (size_t i = 0; i < _heroes.size(); i++)
+			keys[i] = _heroes[i].GetSortByValue(sortBy);
+		it = _rangeIndexes.emplace(sortBy, HeroRangeIndex()).first;
+		it->second.Build(keys, SortOrder(sortBy));
+	}
+	return it->second.Range(low, high);
+}
+
+std::vector<HeroNeighbor> HeroesDB::SimilarTo(size_t heroIndex, size_t count, DistanceMetric metric)
+{
+	if (!_knn.IsBuilt())
+	{
+		std::vector<HeroStats> stats;
+		stats.reserve(_heroes.size());
+		for (const auto& hero : _heroes)
+			stats.push_back(hero.Powerstats());
+		_knn.Build(stats);
 	}
+	return _knn.QueryHero(heroIndex, count, metric);
+}
+
+void HeroesDB::WarmIndexes()
+{
+	FindByName("");
+	for (int sortBy = Intelligence; sortBy <= Weight; sortBy++)
+		HeroesInRange(static_cast<SortBy>(sortBy), 0, -1);
+	if (!_heroes.empty())
+		SimilarTo(0, 0, Manhattan);
+}
+
+HeroCursor HeroesDB::OpenNameCursor(size_t pageSize, bool descending)
+{
+	return HeroCursor(Permutation(0, descending), 0, _heroes.size(), pageSize, _generation);
+}
+
+HeroCursor HeroesDB::OpenSortCursor(SortBy sortBy, size_t pageSize, bool descending)
+{
+	return HeroCursor(Permutation(sortBy, descending), 0, _heroes.size(), pageSize, _generation);
+}
+
+HeroCursor HeroesDB::OpenRangeCursor(SortBy sortBy, int low, int high, size_t pageSize)
+{
+	auto order = Permutation(sortBy, false);
+	auto first = std::lower_bound(order->begin(), order->end(), low, [&](size_t index, int value) {
+		return _heroes[index].GetSortByValue(sortBy) < value;
+		});
+	auto last = std::upper_bound(first, order->end(), high, [&](int value, size_t index) {
+		return value < _heroes[index].GetSortByValue(sortBy);
+		});
+	if (low > high)
+		last = first;
+	return HeroCursor(order, first - order->begin(), last - order->begin(), pageSize, _generation);
+}
+
+HeroCursor HeroesDB::OpenLetterCursor(char letter, size_t pageSize)
+{
+	auto order = Permutation(0, false);
+	auto firstChar = [&](size_t index) {
+		const HeroString& name = _heroes[index].Name();
+		return name.empty() ? '\0' : static_cast<char>(std::tolower(static_cast<unsigned char>(name[0])));
+	};
+	char target = static_cast<char>(std::tolower(static_cast<unsigned char>(letter)));
+	auto first = std::lower_bound(order->begin(), order->end(), target, [&](size_t index, char value) {
+		return static_cast<unsigned char>(firstChar(index)) < static_cast<unsigned char>(value);
+		});
+	auto last = std::upper_bound(first, order->end(), target, [&](char value, size_t index) {
+		return static_cast<unsigned char>(value) < static_cast<unsigned char>(firstChar(index));
+		});
+	return HeroCursor(order, first - order->begin(), last - order->begin(), pageSize, _generation);
 }
-std::string toLower(const std::string& str) {
-	std::string lowerStr = str;
+
+bool HeroesDB::FetchPage(HeroCursor& cursor, std::vector<const Hero*>& page)
+{
+	page.clear();
+	if (cursor.Generation() != _generation || !cursor.Next(_pageIndices))
+		return false;
+	for (size_t index : _pageIndices)
+		page.push_back(&_heroes[index]);
+	return true;
+}
+
+HeroMemoryReport HeroesDB::MemoryReport() const
+{
+	HeroMemoryReport report;
+	report.MeasureHeroes(_heroes);
+
+	//map nodes hold a key, a vector and roughly three tree pointers plus a color flag
+	size_t groupBytes = 0, groupAllocations = 0;
+	for (const auto& group : _groupedHeroes)
+	{
+		groupBytes += sizeof(group) + 4 * sizeof(void*) + group.second.capacity() * sizeof(Hero);
+		groupAllocations += group.second.capacity() > 0 ? 2 : 1;
+		for (const Hero& hero : group.second)
+			groupBytes += HeroMemoryReport::HeroHeapBytes(hero, &groupAllocations);
+	}
+	report.AddSection("_groupedHeroes", groupBytes, groupAllocations);
+
+	report.AddSection("name index", _nameIndex.MemoryBytes(), 0);
+	report.AddSection("k-NN columns and trees", _knn.MemoryBytes(), 0);
+	report.AddSection("group-by columns", _columns.MemoryBytes(), 0);
+	size_t rangeBytes = 0;
+	for (const auto& index : _rangeIndexes)
+		rangeBytes += index.second.MemoryBytes();
+	report.AddSection("range indexes", rangeBytes, 0);
+	size_t permutationBytes = 0;
+	for (const auto& permutation : _permutations)
+		permutationBytes += permutation.second ? HeroMemoryReport::HeapBytes(*permutation.second) : 0;
+	report.AddSection("cursor permutations", permutationBytes, 0);
+	report.AddSection("change log buffer", _changeLog.BufferedBytes(), 0);
+	report.AddSection("result cache", _resultCache.MemoryBytes(), 0);
+	return report;
+}
+
+std::shared_ptr<const std::vector<size_t>> HeroesDB::Permutation(int sortKey, bool descending)
+{
+	auto& cached = _permutations[sortKey * 2 + (descending ? 1 : 0)];
+	if (cached)
+		return cached;
+
+	if (sortKey == 0)
+	{
+		cached = std::make_shared<const std::vector<size_t>>(NameOrderPage(0, _heroes.size(), descending));
+	}
+	else
+	{
+		std::vector<size_t> order = SortOrder(static_cast<SortBy>(sortKey));
+		if (descending)
+			std::reverse(order.begin(), order.end());
+		cached = std::make_shared<const std::vector<size_t>>(std::move(order));
+	}
+	return cached;
+}
+
+std::string toLower(std::string_view str) {
+	std::string lowerStr(str);
 	std::transform(lowerStr.begin(), lowerStr.end(), lowerStr.begin(), [](unsigned char c) { return std::tolower(c); });
 	return lowerStr;
 }
@@ -153,21 +379,38 @@ void HeroesDB::PrintGroupCounts() {
 	}
  }
 
-void HeroesDB::FindHeroesByLetter(char letter) {
-	if (_groupedHeroes.empty()) {
-		GroupHeroes();
+void HeroesDB::PrintGroupStats(GroupBy groupBy, SortBy stat) {
+	if (!_columns.IsBuilt()) {
+		_columns.Build(_heroes);
 	}
-	char lowercaseLetter = std::tolower(letter);
-	auto it = _groupedHeroes.find(lowercaseLetter);
-	if (it == _groupedHeroes.end()) {
-		std::cout << "No heroes found whose names start with '" << letter << "'" << std::endl;
+	for (const GroupStats& group : HeroGroupBy::Aggregate(_columns, groupBy, stat)) {
+		std::cout << (group.Label.empty() ? "(none)" : group.Label)
+			<< ": count " << group.Count
+			<< ", min " << group.Min
+			<< ", max " << group.Max
+			<< ", mean " << group.Mean
+			<< ", stddev " << group.StdDev << std::endl;
 	}
-	else {
-		const std::vector<Hero>& heroesStartingWithLetter = it->second;
-		for (const auto& hero : heroesStartingWithLetter) {
-			std::cout << hero.Id() << ": " << hero.Name() << std::endl;
+}
+
+void HeroesDB::FindHeroesByLetter(char letter) {
+	//keyed by the letter as typed: the not-found message echoes it
+	PrintCached(std::string("letter ") + letter, [&](std::ostream& out) {
+		if (_groupedHeroes.empty()) {
+			GroupHeroes();
 		}
-	}
+		char lowercaseLetter = std::tolower(letter);
+		auto it = _groupedHeroes.find(lowercaseLetter);
+		if (it == _groupedHeroes.end()) {
+			out << "No heroes found whose names start with '" << letter << "'" << '\n';
+		}
+		else {
+			const std::vector<Hero>& heroesStartingWithLetter = it->second;
+			for (const auto& hero : heroesStartingWithLetter) {
+				out << hero.Id() << ": " << hero.Name() << '\n';
+			}
+		}
+		});
 }
 
 void HeroesDB::RemoveHero(const std::string& heroName) {
@@ -187,10 +430,12 @@ void HeroesDB::RemoveHero(const std::string& heroName) {
 
 	heroesStartingWithLetter.erase(heroesStartingWithLetter.begin() + index);
 auto iter = std::remove_if(_heroes.begin(), _heroes.end(), [&](const Hero& hero) {
-				return hero.Name() == heroName;
+				return std::string_view(hero.Name()) == heroName;
 				});
 			_heroes.erase(iter, _heroes.end());
+			InvalidateIndexes();
 std::cout << heroName << " was removed." << std::endl;
+			LogChange(HeroChangeOp::Remove, heroName);
 			if (heroesStartingWithLetter.empty()) {
 				_groupedHeroes.erase(it);
 			}
@@ -202,15 +447,267 @@ std::cout << heroName << " was removed." << std::endl;
 	}
 }
 
+void HeroesDB::FindSimilarHeroes(const std::string& heroName, size_t count, DistanceMetric metric) {
+	const Hero* match = FindByName(heroName);
+	if (match == nullptr) {
+		std::cout << heroName << " was not found" << std::endl;
+		return;
+	}
+
+	std::cout << "Heroes most similar to " << match->Name() << ":" << std::endl;
+	for (const HeroNeighbor& neighbor : SimilarTo(match - _heroes.data(), count, metric)) {
+		const Hero& hero = _heroes[neighbor.Index];
+		std::cout << hero.Id() << ": " << hero.Name() << " (" << neighbor.Distance << ")" << std::endl;
+	}
+}
+
+void HeroesDB::AddHero(const Hero& hero) {
+	UpsertHero(hero);
+	LogChange(HeroChangeOp::Add, ToJson(hero));
+}
+
+bool HeroesDB::UpdateHero(const Hero& hero) {
+	auto it = std::find_if(_heroes.begin(), _heroes.end(), [&](const Hero& existing) {
+		return existing.Id() == hero.Id();
+		});
+	if (it == _heroes.end()) {
+		return false;
+	}
+	*it = hero;
+	_groupedHeroes.clear();
+	InvalidateIndexes();
+	LogChange(HeroChangeOp::Update, ToJson(hero));
+	return true;
+}
+
+void HeroesDB::RemoveAllHeroes() {
+	_heroes.clear();
+	_groupedHeroes.clear();
+	InvalidateIndexes();
+	LogChange(HeroChangeOp::RemoveAll, "");
+}
+
+bool HeroesDB::ImportHeroes(const std::string& path) {
+	size_t before = _heroes.size();
+	if (!DeserializeFromFile(path)) {
+		std::cout << "Could not import " << path << std::endl;
+		return false;
+	}
+	_groupedHeroes.clear();
+	InvalidateIndexes();
+	std::cout << "Imported " << _heroes.size() - before << " heroes from " << path << std::endl;
+	//imports bypass the change log, so make them durable straight away
+	return Checkpoint();
+}
+
+size_t HeroesDB::FindDuplicates(bool merge) {
+	std::vector<HeroDuplicate> duplicates = HeroDedupe::Find(_heroes);
+	HeroDedupe::Print(_heroes, duplicates);
+	if (!merge || duplicates.empty()) {
+		return duplicates.size();
+	}
+
+	std::vector<bool> dropped(_heroes.size(), false);
+	for (const HeroDuplicate& duplicate : duplicates) {
+		if (duplicate.Kind == HeroDuplicateKind::IdCollision) {
+			_heroes[duplicate.KeptIndex].FillMissingFrom(_heroes[duplicate.Index]);
+		}
+		dropped[duplicate.Index] = true;
+	}
+	size_t kept = 0;
+	for (size_t i = 0; i < _heroes.size(); i++) {
+		if (!dropped[i]) {
+			if (kept != i) {
+				_heroes[kept] = std::move(_heroes[i]);
+			}
+			kept++;
+		}
+	}
+	_heroes.erase(_heroes.begin() + kept, _heroes.end());
+	_groupedHeroes.clear();
+	InvalidateIndexes();
+	Checkpoint();
+	std::cout << "Merged: " << _heroes.size() << " heroes remain" << std::endl;
+	return duplicates.size();
+}
+
+bool HeroesDB::Checkpoint() {
+	_changeLog.Flush();
+	//the snapshot makes this a point where the strings of replaced heroes can go, so a long-running
+	//process does not grow with every update
+	CompactArena();
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	if (!Serialize(&writer)) {
+		return false;
+	}
+
+	//write the new snapshot beside the old one and have it on disk before it replaces the old one, so
+	//a crash leaves either the old snapshot with its log or the new one; the log goes only after that
+	std::string tempFile = std::string(SnapshotFile) + ".tmp";
+	std::FILE* out = std::fopen(tempFile.c_str(), "wb");
+	if (out == nullptr) {
+		return false;
+	}
+	bool written = std::fwrite(buffer.GetString(), 1, buffer.GetSize(), out) == buffer.GetSize()
+		&& HeroChangeLog::SyncFile(out);
+	if (std::fclose(out) != 0 || !written || !HeroChangeLog::ReplaceFile(tempFile, SnapshotFile)) {
+		std::remove(tempFile.c_str());
+		return false;
+	}
+	return _changeLog.Reset();
+}
+
+void HeroesDB::CompactArena() {
+	if (_arenaGeneration == _generation) {
+		return;
+	}
+	auto arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+	std::vector<Hero> heroes;
+	heroes.reserve(_heroes.size());
+	for (const Hero& hero : _heroes) {
+		heroes.emplace_back(hero, HeroAllocator(arena.get()));
+	}
+	_heroes.swap(heroes);
+	_arena.swap(arena);
+	//the old heroes go before the old arena that holds their strings
+	std::vector<Hero>().swap(heroes);
+	arena.reset();
+	_arenaGeneration = _generation;
+}
+
+void HeroesDB::InvalidateIndexes() {
+	_nameIndex.Clear();
+	_knn.Clear();
+	_columns.Clear();
+	_rangeIndexes.clear();
+	_permutations.clear();
+	++_generation;
+}
+
+void HeroesDB::PrintCached(const std::string& key, const std::function<void(std::ostream&)>& render) {
+	std::shared_ptr<const std::string> text = _resultCache.Find(key, _generation);
+	if (!text) {
+		std::ostringstream out;
+		render(out);
+		text = _resultCache.Insert(key, out.str(), _generation);
+	}
+	std::cout << *text << std::flush;
+}
+
+std::vector<size_t> HeroesDB::NameOrderPage(size_t offset, size_t count, bool descending) {
+	if (!_nameIndex.IsBuilt()) {
+		_nameIndex.Build(_heroes);
+	}
+	return _nameIndex.Page(offset, count, descending);
+}
+
+void HeroesDB::LogChange(HeroChangeOp op, const std::string& payload) {
+	_changeLog.Append(op, payload);
+	if (_changeLog.RecordCount() >= CheckpointInterval) {
+		Checkpoint();
+	}
+}
+
+//Replay is applied on top of whatever the snapshot holds. Every op is keyed (id, name or all),
+//so re-applying records that a checkpoint already folded in lands on the same state.
+void HeroesDB::ApplyChange(const HeroChange& change) {
+	switch (change.Op)
+	{
+	case HeroChangeOp::Add:
+	case HeroChangeOp::Update:
+	{
+		rapidjson::Document doc(&_replayAllocator);
+		doc.Parse(change.Payload.c_str(), change.Payload.size());
+		if (!doc.HasParseError() && doc.IsObject()) {
+			UpsertHero(Hero(doc));
+		}
+		doc.SetNull();
+		_replayAllocator.Clear();
+		break;
+	}
+	case HeroChangeOp::Remove:
+		EraseHeroesNamed(change.Payload);
+		break;
+	case HeroChangeOp::RemoveAll:
+		_heroes.clear();
+		_groupedHeroes.clear();
+		InvalidateIndexes();
+		break;
+	}
+}
+
+void HeroesDB::EraseHeroesNamed(const std::string& heroName) {
+	auto iter = std::remove_if(_heroes.begin(), _heroes.end(), [&](const Hero& hero) {
+		return std::string_view(hero.Name()) == heroName;
+		});
+	_heroes.erase(iter, _heroes.end());
+	_groupedHeroes.clear();
+	InvalidateIndexes();
+}
+
+void HeroesDB::UpsertHero(const Hero& hero) {
+	auto it = std::find_if(_heroes.begin(), _heroes.end(), [&](const Hero& existing) {
+		return existing.Id() == hero.Id();
+		});
+	if (it == _heroes.end()) {
+		_heroes.emplace_back(hero, HeroAllocator(_arena.get()));
+	}
+	else {
+		*it = hero;	//copy-assignment keeps the arena allocator of *it
+	}
+	_groupedHeroes.clear();
+	InvalidateIndexes();
+}
+
+std::string HeroesDB::ToJson(const Hero& hero) {
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	hero.Serialize(&writer);
+	return std::string(buffer.GetString(), buffer.GetSize());
+}
+
 //----------------------------------------------------------------
 //                                                              //
 //		        DO NOT EDIT THE CODE BELOW                      //
 //                                                              //
 
 
-HeroesDB::HeroesDB()
+const char* HeroesDB::SourceFile = "heroes.json";
+const char* HeroesDB::SnapshotFile = "heroes.snapshot.json";
+const char* HeroesDB::ChangeLogFile = "heroes.wal";
+
+HeroesDB::HeroesDB() :
+	_arena(std::make_unique<std::pmr::monotonic_buffer_resource>())
+{
+	Load();
+}
+
+void HeroesDB::Load()
 {
-	DeserializeFromFile("heroes.json");
+	//start from the last checkpoint if there is one, then replay the mutations logged since. A leftover
+	//temp snapshot is from a checkpoint that crashed before replacing the snapshot, so the log still
+	//belongs to the old snapshot and the temp file is dropped
+	std::remove((std::string(SnapshotFile) + ".tmp").c_str());
+	bool hasSnapshot = std::ifstream(SnapshotFile).good();
+	DeserializeFromFile(hasSnapshot ? SnapshotFile : SourceFile);
+	_replayAllocator.SetRetainedCapacity(ReplayRetainedCapacity);
+	_changeLog.Open(ChangeLogFile, [this](const HeroChange& change) { ApplyChange(change); });
+	//replayed updates leave the heroes they replaced behind in the arena
+	CompactArena();
+}
+
+void HeroesDB::Reload()
+{
+	_changeLog.Close();
+	//destructors still run, but arena deallocation is a no-op; release() frees the blocks in bulk
+	std::vector<Hero>().swap(_heroes);
+	_groupedHeroes.clear();
+	InvalidateIndexes();
+	_arena->release();
+	_arenaGeneration = _generation;
+	Load();
 }
 
 std::string HeroesDB::toUpper(const std::string& str)
@@ -232,35 +729,14 @@ std::string HeroesDB::toUpper2(const std::string& str)
 
 void HeroesDB::SortByNameDescending()
 {
-	std::vector<Hero> sorted(_heroes); //clone the list
-
-	size_t n = sorted.size();
-	bool swapped;
-	do
-	{
-		swapped = false;
-		for (size_t i = 1; i <= n - 1; i++)
+	PrintCached("sort name", [&](std::ostream& out) {
+		for (size_t index : NameOrderPage(0, _heroes.size(), true))
 		{
-			int compResult = _stricmp(sorted[i - 1].Name().c_str(), sorted[i].Name().c_str());
-			//int compResult = toUpper(sorted[i - 1].Name()).compare(toUpper(sorted[i].Name()));
-			if (compResult < 0)
-			{
-				swapped = true;
-				std::swap(sorted[i - 1], sorted[i]);
-
-				//int temp = vec[i - 1];
-				//vec[i - 1] = vec[i];
-				//vec[i] = temp;
-			}
+			const Hero& hero = _heroes[index];
+			out << hero.Id() << ": " << hero.Name() << '\n';
 		}
-		--n;
-	} while (swapped);
-
-	for (auto& hero : sorted)
-	{
-		std::cout << hero.Id() << ": " << hero.Name() << std::endl;
-	}
-	std::cout << std::endl;
+		out << '\n';
+		});
 }
 bool HeroesDB::charComparer(char c1, char c2)
 {
@@ -276,6 +752,21 @@ bool HeroesDB::isPrefix(const std::string& prefix, const std::string& word)
 
 bool HeroesDB::Deserialize(const std::string& s)
 {
+	//read the heroes straight from the text, without building a DOM first; members Hero does
+	//not map are only bracket-matched, not validated
+	size_t before = _heroes.size();
+	rapidjson::OnDemandDocument lazy;
+	rapidjson::OnDemandValue nodes = lazy.Parse(s.data(), s.size());
+	if (nodes.IsArray())
+	{
+		for (const rapidjson::OnDemandValue& node : nodes.GetArray())
+			_heroes.emplace_back(node, HeroAllocator(_arena.get()));
+		if (!lazy.HasParseError())
+			return true;
+		_heroes.erase(_heroes.begin() + before, _heroes.end());
+	}
+
+	//malformed text: the DOM parse reports the error
 	rapidjson::Document doc;
 	if (!InitDocument(s, doc))
 		return false;
@@ -289,8 +780,7 @@ bool HeroesDB::Deserialize(const std::string& s)
 	for (rapidjson::SizeType i = 0; i < doc.Size(); ++i)
 	{
 		rapidjson::Value& node = doc[i];
-		Hero myHero(node);
-		_heroes.push_back(myHero);
+		_heroes.emplace_back(node, HeroAllocator(_arena.get()));
 	}
 
 	return true;
@@ -298,5 +788,9 @@ bool HeroesDB::Deserialize(const std::string& s)
 
 bool HeroesDB::Serialize(rapidjson::Writer<rapidjson::StringBuffer>* writer) const
 {
-	return true;
+	//large databases are rendered in ranges on several threads; small ones stay on this thread
+	return rapidjson::WriteArrayParallel(*writer, _heroes.size(), [this](rapidjson::Writer<rapidjson::StringBuffer>& rangeWriter, size_t i)
+		{
+			return _heroes[i].Serialize(&rangeWriter);
+		});
 }
\ No newline at end of file
@@ -1,10 +1,22 @@
 ﻿#pragma once
 
+#include <functional>
 #include <iostream>
 #include <string>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include "Hero.h"
 #include "enums.h"
+#include "HeroChangeLog.h"
+#include "HeroNameIndex.h"
+#include "HeroKnn.h"
+#include "HeroGroupBy.h"
+#include "HeroRangeIndex.h"
+#include "HeroCursor.h"
+#include "HeroMemoryReport.h"
+#include "HeroResultCache.h"
+#include "HeroDedupe.h"
 
 
 class HeroesDB : public JSONBase
@@ -15,21 +27,112 @@ public:
     size_t Count() { return _heroes.size(); }
 
     void SortByNameDescending();
+    // Indices of _heroes for one page of case-insensitive name order.
+    std::vector<size_t> NameOrderPage(size_t offset, size_t count, bool descending = false);
    
 
     void MergeSort(std::vector<Hero>& heroes, int left, int right, SortBy sortby);
     void Merge(std::vector<Hero>& heroes, int left, int mid, int right, SortBy sortBy);
     void SortByAttribute(SortBy sortBy);
+
+    // Stable O(n + k) counting sort of hero indices by a powerstat. order is the input
+    // sequence (empty = 0..n-1), so sorting by a secondary key first gives multi-key order.
+    std::vector<size_t> CountingSort(const std::vector<Hero>& heroes, SortBy sortBy, const std::vector<size_t>& order = {}) const;
+    // The same over keys already extracted: keys[i] belongs to order[i] (or to i), all within [minKey, maxKey].
+    static std::vector<size_t> CountingSort(const std::vector<int>& keys, int minKey, int maxKey, const std::vector<size_t>& order = {});
+    // Indices of _heroes sorted by sortBy; uses CountingSort when the key range is small, else std::stable_sort.
+    std::vector<size_t> SortOrder(SortBy sortBy);
+    // Prints heroes whose sortBy value lies in [low, high], e.g. Height 180..200 (cm).
+    void FindHeroesInRange(SortBy sortBy, int low, int high);
+
+    // Lookups that return results instead of printing them. Each builds its index on first use;
+    // after WarmIndexes() they only read, so several threads may call them at once as long as
+    // nothing modifies the heroes meanwhile.
+    const Hero* FindByName(std::string_view name);
+    std::vector<size_t> HeroesInRange(SortBy sortBy, int low, int high);
+    std::vector<HeroNeighbor> SimilarTo(size_t heroIndex, size_t count, DistanceMetric metric);
+    void WarmIndexes();
+
+    // Paged access over cached orderings. Filtered cursors cover the contiguous run of an
+    // ordering that matches (a key range of a SortBy order, a first letter of name order).
+    HeroCursor OpenNameCursor(size_t pageSize, bool descending = false);
+    HeroCursor OpenSortCursor(SortBy sortBy, size_t pageSize, bool descending = false);
+    HeroCursor OpenRangeCursor(SortBy sortBy, int low, int high, size_t pageSize);
+    HeroCursor OpenLetterCursor(char letter, size_t pageSize);
+    // Fills page with the cursor's next heroes. False at the end, or if heroes changed since the cursor was opened.
+    bool FetchPage(HeroCursor& cursor, std::vector<const Hero*>& page);
+    uint64_t Generation() const { return _generation; }
+
+    // Where the DB's memory goes: per Hero field, the grouped copies, and each index.
+    HeroMemoryReport MemoryReport() const;
+    // Rendered output of the sort, name, letter and range queries, dropped whenever the heroes change.
+    const HeroResultCache& ResultCache() const { return _resultCache; }
+    const std::vector<Hero>& Heroes() const { return _heroes; }
     int BinarySearch(const std::vector<Hero>& _heroes, const std::string& searchTerm, int low, int high);
     void FindHero(const std::string& heroName);
     void GroupHeroes();
     void PrintGroupCounts();
+    void PrintGroupStats(GroupBy groupBy, SortBy stat);
     void FindHeroesByLetter(char letter);
     void RemoveHero(const std::string& heroName);
+    void FindSimilarHeroes(const std::string& heroName, size_t count, DistanceMetric metric);
+    void AddHero(const Hero& hero);
+    bool UpdateHero(const Hero& hero);
+    void RemoveAllHeroes();
+
+    // Folds the change log into a new snapshot and truncates the log. Heroes replaced or removed
+    // since the last checkpoint have their strings freed here (see CompactArena).
+    bool Checkpoint();
+    // Appends every hero in a JSON array file, duplicates included, and checkpoints.
+    bool ImportHeroes(const std::string& path);
+    // Prints exact and id-collision duplicates. With merge, exact copies are dropped and id
+    // collisions are folded into the first record (FillMissingFrom), then the DB checkpoints.
+    size_t FindDuplicates(bool merge);
+    // Drops everything and loads again from the snapshot (or source) and the change log.
+    // The previous load's hero strings are freed in one go by releasing the arena.
+    void Reload();
 
 private:
+    // Owns the strings of every hero in _heroes. Declared first so it outlives them. Heroes
+    // replaced by later mutations stay in it until CompactArena() moves the live ones out.
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> _arena;
     std::vector<Hero> _heroes;
     std::map<char, std::vector<Hero>> _groupedHeroes;
+    HeroChangeLog _changeLog;
+    // Change log records are parsed one at a time into the same chunks, kept by Clear() between
+    // records and across reloads instead of going back to the heap each time.
+    rapidjson::MemoryPoolAllocator<> _replayAllocator;
+    HeroNameIndex _nameIndex;
+    HeroKnn _knn;
+    HeroColumns _columns;
+    std::map<SortBy, HeroRangeIndex> _rangeIndexes;
+    std::map<int, std::shared_ptr<const std::vector<size_t>>> _permutations;    // keyed by Permutation()'s sortKey * 2 + descending
+    std::vector<size_t> _pageIndices;
+    uint64_t _generation = 0;   // bumped on every change to _heroes
+    uint64_t _arenaGeneration = 0;  // _generation when _arena last held only live heroes
+    HeroResultCache _resultCache;
+
+    static const char* SourceFile;
+    static const char* SnapshotFile;
+    static const char* ChangeLogFile;
+    static const size_t CheckpointInterval = 1000;    // log records between automatic checkpoints
+    static const size_t ReplayRetainedCapacity = 1 << 20;   // most chunk capacity _replayAllocator keeps
+    static const int CountingSortMaxRange = 1 << 16;   // largest key span worth a counts array
+
+    // sortKey 0 is name order, otherwise a SortBy value.
+    std::shared_ptr<const std::vector<size_t>> Permutation(int sortKey, bool descending);
+    void InvalidateIndexes();    // drops everything derived from _heroes except _groupedHeroes
+    // Copies the heroes into a fresh arena and releases the old one, unless _heroes is unchanged
+    // since the last time. Hero order, and so every index, stays the same.
+    void CompactArena();
+    // Prints the cached output for key, rendering and caching it first on a miss.
+    void PrintCached(const std::string& key, const std::function<void(std::ostream&)>& render);
+    void Load();
+    void LogChange(HeroChangeOp op, const std::string& payload);
+    void ApplyChange(const HeroChange& change);
+    void EraseHeroesNamed(const std::string& heroName);
+    void UpsertHero(const Hero& hero);
+    static std::string ToJson(const Hero& hero);
 
     static std::string toUpper(const std::string& str);
     static std::string toUpper2(const std::string& str);
@@ -4,17 +4,37 @@
 #include "Input.h"
 #include <locale>
 #include "Tester.h"
+#include "HeroBenchmarks.h"
+#include "HeroScript.h"
+#include "HeroServer.h"
+#include "HeroLoadGenerator.h"
+#include "HeroExternalSort.h"
 
-int main()
+int main(int argc, char* argv[])
 {
     Tester v2Test;
+    if (HeroScript::IsBatch(argc, argv))
+        return HeroScript::Run(argc, argv);
+    if (HeroServer::IsServe(argc, argv))
+        return HeroServer::Main(argc, argv);
+    if (HeroLoadGenerator::IsLoad(argc, argv))
+        return HeroLoadGenerator::Main(argc, argv);
+    if (HeroExternalSort::IsExternalSort(argc, argv))
+        return HeroExternalSort::Main(argc, argv);
+
     Console::ResizeWindow(150, 30);
 
     HeroesDB heroDB;
 
     int menuSelection = 0;
-    std::vector<std::string> menuOptions{ "1. Sort by Name (descending)", "2. Sort By", "3. Find Hero (Binary Search)", "4. Print Group Counts", "5. Find All Heroes by first letter", "6. Remove Hero", "7. Exit" };
-    std::vector<std::string> sortByOptions{ "1. Intelligence", "2. Strength", "3. Speed", "4. Durability", "5. Power", "6. Combat" };
+    std::vector<std::string> menuOptions{ "1. Sort by Name (descending)", "2. Sort By", "3. Find Hero (Binary Search)", "4. Print Group Counts", "5. Find All Heroes by first letter", "6. Remove Hero", "7. Find Similar Heroes", "8. Group Stats", "9. Find Heroes in Range", "10. Browse Heroes", "11. Memory Report", "12. Benchmarks", "13. Result Cache Stats", "14. Import Heroes", "15. Duplicates", "16. Exit" };
+    std::vector<std::string> sortByOptions{ "1. Intelligence", "2. Strength", "3. Speed", "4. Durability", "5. Power", "6. Combat", "7. Height", "8. Weight" };
+    std::vector<std::string> groupByOptions{ "1. Publisher", "2. Alignment", "3. Race", "4. Gender" };
+    std::vector<std::string> browseOptions{ "1. Name (ascending)", "2. Name (descending)", "3. Sort By" };
+    std::vector<std::string> reportOptions{ "1. Table", "2. JSON" };
+    std::vector<std::string> duplicateOptions{ "1. Report", "2. Report and merge" };
+    std::vector<std::string> metricOptions{ "1. Manhattan (L1)", "2. Euclidean (L2)", "3. Cosine" };
+    std::vector<std::string> benchmarkOptions{ "1. Sort By (merge vs counting)", "2. Similar Heroes (1M heroes)", "3. Load/Destroy (heap vs arena)", "4. Deserialize (lookups vs field map)", "5. JSON Parse (SIMD levels)", "6. On-demand JSON (DOM vs lazy)", "7. Parallel JSON write (threads)", "8. Number write (Grisu2 vs Ryu)", "9. Number parse (exact doubles)", "10. Parallel DOM build (threads)", "11. Reparse (retained chunks)", "12. JSON pointer set (batch)" };
 
     do
     {
@@ -37,7 +57,7 @@ int main()
         case 2:
         {
             int sortBySelection = Input::GetMenuSelection(sortByOptions, "Sort by? ");
-            if (sortBySelection < 0 || sortBySelection >= sortByOptions.size())
+            if (sortBySelection < 1 || sortBySelection > sortByOptions.size())
             {
                 std::cout << "Invalid choice!" << std::endl;
                 break;
@@ -82,6 +102,196 @@ int main()
             heroDB.RemoveHero(heroName);
             break;
         }
+        case 7:
+        {
+            std::string heroName;
+            std::cout << "Enter the hero to match: ";
+            std::getline(std::cin, heroName);
+            int metricSelection = Input::GetMenuSelection(metricOptions, "Distance? ");
+            if (metricSelection < 1 || metricSelection > metricOptions.size())
+            {
+                std::cout << "Invalid choice!" << std::endl;
+                break;
+            }
+            heroDB.FindSimilarHeroes(heroName, 20, static_cast<DistanceMetric>(metricSelection));
+            break;
+        }
+        case 8:
+        {
+            int groupBySelection = Input::GetMenuSelection(groupByOptions, "Group by? ");
+            int sortBySelection = Input::GetMenuSelection(sortByOptions, "Stat? ");
+            if (groupBySelection < 1 || groupBySelection > groupByOptions.size() ||
+                sortBySelection < 1 || sortBySelection > sortByOptions.size())
+            {
+                std::cout << "Invalid choice!" << std::endl;
+                break;
+            }
+            heroDB.PrintGroupStats(static_cast<GroupBy>(groupBySelection), static_cast<SortBy>(sortBySelection));
+            break;
+        }
+        case 9:
+        {
+            int sortBySelection = Input::GetMenuSelection(sortByOptions, "Range on? ");
+            if (sortBySelection < 1 || sortBySelection > sortByOptions.size())
+            {
+                std::cout << "Invalid choice!" << std::endl;
+                break;
+            }
+            std::string low, high;
+            std::cout << "Lowest value (height in cm, weight in kg): ";
+            std::getline(std::cin, low);
+            std::cout << "Highest value: ";
+            std::getline(std::cin, high);
+            try
+            {
+                heroDB.FindHeroesInRange(static_cast<SortBy>(sortBySelection), std::stoi(low), std::stoi(high));
+            }
+            catch (const std::exception&)
+            {
+                std::cout << "Invalid input. Please enter whole numbers." << std::endl;
+            }
+            break;
+        }
+        case 10:
+        {
+            int browseSelection = Input::GetMenuSelection(browseOptions, "Order by? ");
+            int sortBySelection = 0;
+            if (browseSelection == 3)
+                sortBySelection = Input::GetMenuSelection(sortByOptions, "Sort by? ");
+            if (browseSelection < 1 || browseSelection > browseOptions.size() ||
+                (browseSelection == 3 && (sortBySelection < 1 || sortBySelection > sortByOptions.size())))
+            {
+                std::cout << "Invalid choice!" << std::endl;
+                break;
+            }
+
+            const size_t pageSize = 20;
+            SortBy sortBy = static_cast<SortBy>(sortBySelection);
+            HeroCursor cursor = browseSelection == 3 ?
+                heroDB.OpenSortCursor(sortBy, pageSize) :
+                heroDB.OpenNameCursor(pageSize, browseSelection == 2);
+            std::vector<const Hero*> page;
+            size_t pageNumber = 0;
+            std::string command;
+            do
+            {
+                Console::Clear();
+                cursor.SeekPage(pageNumber);
+                heroDB.FetchPage(cursor, page);
+                for (const Hero* hero : page)
+                {
+                    std::cout << hero->Id() << ": ";
+                    if (browseSelection == 3)
+                        std::cout << hero->GetSortByAttribute(sortBy) << " - ";
+                    std::cout << hero->Name() << std::endl;
+                }
+                std::cout << "Page " << pageNumber + 1 << " of " << cursor.PageCount() << std::endl;
+                std::cout << "n = next, p = previous, a page number, or q to quit: ";
+                std::getline(std::cin, command);
+                if (command == "n" && pageNumber + 1 < cursor.PageCount())
+                    pageNumber++;
+                else if (command == "p" && pageNumber > 0)
+                    pageNumber--;
+                else if (!command.empty() && command.size() < 10 && command.find_first_not_of("0123456789") == std::string::npos)
+                {
+                    size_t requested = std::stoul(command);
+                    if (requested >= 1 && requested <= cursor.PageCount())
+                        pageNumber = requested - 1;
+                }
+            } while (command != "q" && std::cin);
+            break;
+        }
+        case 11:
+        {
+            int reportSelection = Input::GetMenuSelection(reportOptions, "Format? ");
+            HeroMemoryReport report = heroDB.MemoryReport();
+            if (reportSelection == 1)
+                report.Print();
+            else if (reportSelection == 2)
+                std::cout << report.ToJson() << std::endl;
+            else
+                std::cout << "Invalid choice!" << std::endl;
+            break;
+        }
+        case 12:
+        {
+            int benchmarkSelection = Input::GetMenuSelection(benchmarkOptions, "Benchmark? ");
+            switch (benchmarkSelection)
+            {
+            case 1:
+            {
+                int sortBySelection = Input::GetMenuSelection(sortByOptions, "Sort by? ");
+                if (sortBySelection < 1 || sortBySelection > sortByOptions.size())
+                {
+                    std::cout << "Invalid choice!" << std::endl;
+                    break;
+                }
+                HeroBenchmarks::SortByAttribute(heroDB, static_cast<SortBy>(sortBySelection));
+                break;
+            }
+            case 2:
+                HeroBenchmarks::SimilarHeroes(heroDB);
+                break;
+            case 3:
+                HeroBenchmarks::LoadAndDestroy(heroDB);
+                break;
+            case 4:
+                HeroBenchmarks::Deserialize(heroDB);
+                break;
+            case 5:
+                HeroBenchmarks::ParseJson(heroDB);
+                break;
+            case 6:
+                HeroBenchmarks::OnDemand(heroDB);
+                break;
+            case 7:
+                HeroBenchmarks::ParallelWrite(heroDB);
+                break;
+            case 8:
+                HeroBenchmarks::NumberWrite(heroDB);
+                break;
+            case 9:
+                HeroBenchmarks::NumberParse(heroDB);
+                break;
+            case 10:
+                HeroBenchmarks::ParallelBuild(heroDB);
+                break;
+            case 11:
+                HeroBenchmarks::Reparse(heroDB);
+                break;
+            case 12:
+                HeroBenchmarks::PointerLookup(heroDB);
+                break;
+            default:
+                std::cout << "Invalid choice!" << std::endl;
+                break;
+            }
+            break;
+        }
+        case 13:
+        {
+            heroDB.ResultCache().PrintStats();
+            break;
+        }
+        case 14:
+        {
+            std::string path;
+            std::cout << "JSON file to import: ";
+            std::getline(std::cin, path);
+            heroDB.ImportHeroes(path);
+            break;
+        }
+        case 15:
+        {
+            int duplicateSelection = Input::GetMenuSelection(duplicateOptions, "Duplicates? ");
+            if (duplicateSelection < 1 || duplicateSelection > duplicateOptions.size())
+            {
+                std::cout << "Invalid choice!" << std::endl;
+                break;
+            }
+            heroDB.FindDuplicates(duplicateSelection == 2);
+            break;
+        }
       
         }
 
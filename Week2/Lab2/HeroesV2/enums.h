@@ -7,5 +7,22 @@ enum SortBy
     Speed,
     Durability,
     Power,
-    Combat
+    Combat,
+    Height,     // centimeters
+    Weight      // kilograms
+};
+
+enum DistanceMetric
+{
+    Manhattan = 1,  // L1
+    Euclidean,      // L2
+    Cosine
+};
+
+enum GroupBy
+{
+    GroupByPublisher = 1,
+    GroupByAlignment,
+    GroupByRace,
+    GroupByGender
 };
\ No newline at end of file
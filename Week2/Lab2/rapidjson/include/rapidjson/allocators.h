@@ -123,6 +123,10 @@ public:
 
     The user-buffer is not deallocated by this allocator.
 
+    For documents parsed over and over, SetRetainedCapacity() makes Clear() keep chunks for
+    the next round instead of returning them to BaseAllocator, and GetStats() tells how
+    the chunks are used.
+
     \tparam BaseAllocator the allocator type for allocating memory chunks. Default is CrtAllocator.
     \note implements Allocator concept
 */
@@ -137,10 +141,24 @@ class MemoryPoolAllocator {
         ChunkHeader *next;  //!< Next chunk in the linked list.
     };
 
+public:
+    //! Allocation counters, accumulated until ResetStats().
+    struct Stats {
+        size_t requestedBytes;      //!< Bytes asked for by Malloc() and Realloc().
+        size_t chunkAllocations;    //!< Chunks allocated by BaseAllocator.
+        size_t chunkReuses;         //!< Chunks taken from those kept by Clear() instead.
+        size_t chunkFrees;          //!< Chunks returned to BaseAllocator.
+        size_t wastedBytes;         //!< Space left unused at the end of chunks when allocation moved on to a new chunk.
+    };
+
+private:
     struct SharedData {
         ChunkHeader *chunkHead;  //!< Head of the chunk linked-list. Only the head chunk serves allocation.
+        ChunkHeader *spareHead;  //!< Chunks kept by Clear() for reuse, see SetRetainedCapacity().
         BaseAllocator* ownBaseAllocator; //!< base allocator created by this object.
         size_t refcount;
+        size_t retainedCapacity; //!< Most chunk capacity Clear() keeps.
+        Stats stats;
         bool ownBuffer;
     };
 
@@ -184,8 +202,11 @@ public:
         shared_->chunkHead->capacity = 0;
         shared_->chunkHead->size = 0;
         shared_->chunkHead->next = 0;
+        shared_->spareHead = 0;
         shared_->ownBuffer = true;
         shared_->refcount = 1;
+        shared_->retainedCapacity = 0;
+        ResetStats();
     }
 
     //! Constructor with user-supplied buffer.
@@ -208,9 +229,12 @@ public:
         shared_->chunkHead->capacity = size - SIZEOF_SHARED_DATA - SIZEOF_CHUNK_HEADER;
         shared_->chunkHead->size = 0;
         shared_->chunkHead->next = 0;
+        shared_->spareHead = 0;
         shared_->ownBaseAllocator = 0;
         shared_->ownBuffer = false;
         shared_->refcount = 1;
+        shared_->retainedCapacity = 0;
+        ResetStats();
     }
 
     MemoryPoolAllocator(const MemoryPoolAllocator& rhs) RAPIDJSON_NOEXCEPT :
@@ -266,6 +290,7 @@ public:
             return;
         }
         Clear();
+        FreeSpareChunks();
         BaseAllocator *a = shared_->ownBaseAllocator;
         if (shared_->ownBuffer) {
             baseAllocator_->Free(shared_);
@@ -274,20 +299,56 @@ public:
     }
 
     //! Deallocates all memory chunks, excluding the first/user one.
+    /*! With SetRetainedCapacity(), chunks are kept for reuse instead, up to the retained
+        capacity. Chunks kept by the previous Clear() that the allocations since did not need
+        are freed, so what is kept follows the high-water mark of the last round.
+    */
     void Clear() RAPIDJSON_NOEXCEPT {
         RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        FreeSpareChunks();
+        size_t retained = 0;
         for (;;) {
             ChunkHeader* c = shared_->chunkHead;
             if (!c->next) {
                 break;
             }
             shared_->chunkHead = c->next;
-            baseAllocator_->Free(c);
+            if (c->capacity <= shared_->retainedCapacity - retained) {
+                retained += c->capacity;
+                c->next = shared_->spareHead;
+                shared_->spareHead = c;
+            }
+            else {
+                baseAllocator_->Free(c);
+                shared_->stats.chunkFrees++;
+            }
         }
         shared_->chunkHead->size = 0;
     }
 
-    //! Computes the total capacity of allocated memory chunks.
+    //! Makes Clear() keep chunks for reuse.
+    /*! \param capacity Most chunk capacity in bytes to keep, for example the capacity a
+            typical document needs. 0 (the default) frees all chunks; \c SIZE_MAX keeps
+            every chunk the last round used.
+    */
+    void SetRetainedCapacity(size_t capacity) RAPIDJSON_NOEXCEPT {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        shared_->retainedCapacity = capacity;
+    }
+
+    //! Allocation counters since construction or the last ResetStats().
+    const Stats& GetStats() const RAPIDJSON_NOEXCEPT {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        return shared_->stats;
+    }
+
+    //! Sets the allocation counters to zero.
+    void ResetStats() RAPIDJSON_NOEXCEPT {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        std::memset(&shared_->stats, 0, sizeof(shared_->stats));
+    }
+
+    //! Computes the total capacity of allocated memory chunks, including those kept by Clear().
     /*! \return total capacity in bytes.
     */
     size_t Capacity() const RAPIDJSON_NOEXCEPT {
@@ -295,6 +356,8 @@ public:
         size_t capacity = 0;
         for (ChunkHeader* c = shared_->chunkHead; c != 0; c = c->next)
             capacity += c->capacity;
+        for (ChunkHeader* c = shared_->spareHead; c != 0; c = c->next)
+            capacity += c->capacity;
         return capacity;
     }
 
@@ -323,6 +386,7 @@ public:
         if (!size)
             return NULL;
 
+        shared_->stats.requestedBytes += size;
         size = RAPIDJSON_ALIGN(size);
         if (RAPIDJSON_UNLIKELY(shared_->chunkHead->size + size > shared_->chunkHead->capacity))
             if (!AddChunk(chunk_capacity_ > size ? chunk_capacity_ : size))
@@ -354,6 +418,7 @@ public:
             size_t increment = static_cast<size_t>(newSize - originalSize);
             if (shared_->chunkHead->size + increment <= shared_->chunkHead->capacity) {
                 shared_->chunkHead->size += increment;
+                shared_->stats.requestedBytes += increment;
                 return originalPtr;
             }
         }
@@ -383,22 +448,37 @@ public:
     }
 
 private:
-    //! Creates a new chunk.
+    //! Creates a new chunk, or reuses one kept by Clear().
     /*! \param capacity Capacity of the chunk in bytes.
         \return true if success.
     */
     bool AddChunk(size_t capacity) {
-        if (!baseAllocator_)
-            shared_->ownBaseAllocator = baseAllocator_ = RAPIDJSON_NEW(BaseAllocator)();
-        if (ChunkHeader* chunk = static_cast<ChunkHeader*>(baseAllocator_->Malloc(SIZEOF_CHUNK_HEADER + capacity))) {
+        ChunkHeader* chunk = shared_->spareHead;
+        if (chunk && chunk->capacity >= capacity) {
+            shared_->spareHead = chunk->next;
+            shared_->stats.chunkReuses++;
+        }
+        else {
+            if (!baseAllocator_)
+                shared_->ownBaseAllocator = baseAllocator_ = RAPIDJSON_NEW(BaseAllocator)();
+            if (!(chunk = static_cast<ChunkHeader*>(baseAllocator_->Malloc(SIZEOF_CHUNK_HEADER + capacity))))
+                return false;
             chunk->capacity = capacity;
-            chunk->size = 0;
-            chunk->next = shared_->chunkHead;
-            shared_->chunkHead = chunk;
-            return true;
+            shared_->stats.chunkAllocations++;
+        }
+        shared_->stats.wastedBytes += shared_->chunkHead->capacity - shared_->chunkHead->size;
+        chunk->size = 0;
+        chunk->next = shared_->chunkHead;
+        shared_->chunkHead = chunk;
+        return true;
+    }
+
+    void FreeSpareChunks() RAPIDJSON_NOEXCEPT {
+        while (ChunkHeader* c = shared_->spareHead) {
+            shared_->spareHead = c->next;
+            baseAllocator_->Free(c);
+            shared_->stats.chunkFrees++;
         }
-        else
-            return false;
     }
 
     static inline void* AlignBuffer(void* buf, size_t &size)
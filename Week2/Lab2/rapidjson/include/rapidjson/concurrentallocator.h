@@ -0,0 +1,474 @@
+// Tencent is pleased to support the open source community by making RapidJSON available.
+//
+// Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef RAPIDJSON_CONCURRENTALLOCATOR_H_
+#define RAPIDJSON_CONCURRENTALLOCATOR_H_
+
+/*! \file concurrentallocator.h
+    A MemoryPoolAllocator that several threads can allocate from at once.
+
+    Each thread allocates from chunks of its own, so the allocation path is the same bump of
+    a pointer as in MemoryPoolAllocator, without locks or atomic operations. Chunks come from
+    a free list shared by all threads, which is lock-free, and go back to it all at once on
+    Clear(), in time that does not depend on how many chunks there are.
+
+    Together with GenericDocument's constructor taking an allocator, this lets one document
+    be built by several threads: each parses or builds its part into values of the shared
+    allocator, and the parts are then moved into the document.
+
+    \code
+    typedef GenericDocument<UTF8<>, ConcurrentMemoryPoolAllocator<> > ConcurrentDocument;
+    ConcurrentDocument doc;
+    // on each thread:
+    ConcurrentDocument part(&doc.GetAllocator());
+    part.Parse(json);
+    \endcode
+
+    Requires C++11.
+*/
+
+#include "allocators.h"
+
+#if RAPIDJSON_HAS_CXX11
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+RAPIDJSON_NAMESPACE_BEGIN
+
+///////////////////////////////////////////////////////////////////////////////
+// ConcurrentMemoryPoolAllocator
+
+//! Thread-safe variant of MemoryPoolAllocator with a chunk list per thread.
+/*! Malloc() and Realloc() may be called from any number of threads at once, and so may
+    copying and destroying copies of the allocator. Clear(), Reserve(), Capacity() and Size()
+    must not run concurrently with allocations.
+
+    Like MemoryPoolAllocator it does not free memory blocks, and Realloc() only grows the
+    last block a thread allocated in place. Memory allocated by one thread may be used and
+    passed to other threads freely.
+
+    Clear() hands every chunk back to the shared free list instead of freeing it, so that
+    the next document built with the allocator reuses them. The chunks are returned to
+    BaseAllocator when the last copy of the allocator is destroyed. Only the chunks made for
+    single blocks larger than the chunk size are freed by Clear().
+
+    \tparam BaseAllocator the allocator type for allocating memory chunks. It is called from
+        several threads and must be thread-safe, as CrtAllocator is.
+    \note implements Allocator concept
+*/
+template <typename BaseAllocator = CrtAllocator>
+class ConcurrentMemoryPoolAllocator {
+    //! Chunk header for prepending to each chunk.
+    /*! A chunk is either in the list of the thread allocating from it or in the free list.
+    */
+    struct ChunkHeader {
+        size_t capacity;    //!< Capacity of the chunk in bytes (excluding the header itself).
+        size_t size;        //!< Current size of allocated memory in bytes.
+        std::atomic<ChunkHeader*> next; //!< Next chunk in the linked list.
+    };
+
+    //! Chunks of one thread.
+    struct ThreadArena {
+        std::thread::id owner;
+        ChunkHeader* chunkHead; //!< Head of the chunk linked-list. Only the head chunk serves allocation.
+        ChunkHeader* chunkTail; //!< Last chunk, so that Clear() can hand the whole list back at once.
+        ChunkHeader* largeChunks; //!< Chunks of single blocks larger than the chunk size, freed by Clear().
+        ThreadArena* next;      //!< Next thread in the pool, set before the arena is published.
+    };
+
+    struct SharedData {
+        std::atomic<uint64_t> freeChunks;   //!< Tagged head of the free list, see Tag().
+        std::atomic<ThreadArena*> arenas;
+        std::atomic<size_t> refcount;
+        BaseAllocator* ownBaseAllocator;    //!< base allocator created by this object.
+        uint64_t id;                        //!< Unique among all pools ever created, for the per-thread cache.
+    };
+
+    //! The arena of the pool a thread allocated from last.
+    struct ArenaCache {
+        uint64_t poolId;
+        ThreadArena* arena;
+    };
+
+    static const size_t SIZEOF_SHARED_DATA = RAPIDJSON_ALIGN(sizeof(SharedData));
+    static const size_t SIZEOF_CHUNK_HEADER = RAPIDJSON_ALIGN(sizeof(ChunkHeader));
+
+    static inline uint8_t *GetChunkBuffer(ChunkHeader *chunk)
+    {
+        return reinterpret_cast<uint8_t*>(chunk) + SIZEOF_CHUNK_HEADER;
+    }
+
+    static const size_t kDefaultChunkCapacity = RAPIDJSON_ALLOCATOR_DEFAULT_CHUNK_CAPACITY; //!< Default chunk capacity.
+
+public:
+    static const bool kNeedFree = false;    //!< Tell users that no need to call Free() with this allocator. (concept Allocator)
+    static const bool kRefCounted = true;   //!< Tell users that this allocator is reference counted on copy
+
+    //! Constructor with chunkSize.
+    /*! \param chunkSize The size of memory chunk. The default is kDefaultChunkSize.
+        \param baseAllocator The allocator for allocating memory chunks.
+    */
+    explicit
+    ConcurrentMemoryPoolAllocator(size_t chunkSize = kDefaultChunkCapacity, BaseAllocator* baseAllocator = 0) :
+        chunk_capacity_(chunkSize),
+        baseAllocator_(baseAllocator ? baseAllocator : RAPIDJSON_NEW(BaseAllocator)()),
+        shared_(static_cast<SharedData*>(baseAllocator_ ? baseAllocator_->Malloc(SIZEOF_SHARED_DATA) : 0))
+    {
+        RAPIDJSON_ASSERT(baseAllocator_ != 0);
+        RAPIDJSON_ASSERT(shared_ != 0);
+        new (shared_) SharedData();
+        shared_->freeChunks.store(0, std::memory_order_relaxed);
+        shared_->arenas.store(0, std::memory_order_relaxed);
+        shared_->refcount.store(1, std::memory_order_relaxed);
+        shared_->ownBaseAllocator = baseAllocator ? 0 : baseAllocator_;
+        shared_->id = NextPoolId();
+    }
+
+    ConcurrentMemoryPoolAllocator(const ConcurrentMemoryPoolAllocator& rhs) RAPIDJSON_NOEXCEPT :
+        chunk_capacity_(rhs.chunk_capacity_),
+        baseAllocator_(rhs.baseAllocator_),
+        shared_(rhs.shared_)
+    {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        shared_->refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+    ConcurrentMemoryPoolAllocator& operator=(const ConcurrentMemoryPoolAllocator& rhs) RAPIDJSON_NOEXCEPT
+    {
+        RAPIDJSON_NOEXCEPT_ASSERT(rhs.shared_->refcount > 0);
+        rhs.shared_->refcount.fetch_add(1, std::memory_order_relaxed);
+        this->~ConcurrentMemoryPoolAllocator();
+        baseAllocator_ = rhs.baseAllocator_;
+        chunk_capacity_ = rhs.chunk_capacity_;
+        shared_ = rhs.shared_;
+        return *this;
+    }
+
+    ConcurrentMemoryPoolAllocator(ConcurrentMemoryPoolAllocator&& rhs) RAPIDJSON_NOEXCEPT :
+        chunk_capacity_(rhs.chunk_capacity_),
+        baseAllocator_(rhs.baseAllocator_),
+        shared_(rhs.shared_)
+    {
+        RAPIDJSON_NOEXCEPT_ASSERT(rhs.shared_->refcount > 0);
+        rhs.shared_ = 0;
+    }
+    ConcurrentMemoryPoolAllocator& operator=(ConcurrentMemoryPoolAllocator&& rhs) RAPIDJSON_NOEXCEPT
+    {
+        RAPIDJSON_NOEXCEPT_ASSERT(rhs.shared_->refcount > 0);
+        this->~ConcurrentMemoryPoolAllocator();
+        baseAllocator_ = rhs.baseAllocator_;
+        chunk_capacity_ = rhs.chunk_capacity_;
+        shared_ = rhs.shared_;
+        rhs.shared_ = 0;
+        return *this;
+    }
+
+    //! Destructor.
+    /*! The last copy deallocates all memory chunks, in use or free.
+    */
+    ~ConcurrentMemoryPoolAllocator() RAPIDJSON_NOEXCEPT {
+        if (!shared_) {
+            // do nothing if moved
+            return;
+        }
+        if (shared_->refcount.fetch_sub(1, std::memory_order_acq_rel) > 1)
+            return;
+
+        ThreadArena* arena = shared_->arenas.load(std::memory_order_acquire);
+        while (arena) {
+            ThreadArena* next = arena->next;
+            FreeChunks(arena->chunkHead);
+            FreeChunks(arena->largeChunks);
+            arena->~ThreadArena();
+            baseAllocator_->Free(arena);
+            arena = next;
+        }
+        FreeChunks(TaggedChunk(shared_->freeChunks.load(std::memory_order_acquire)));
+        BaseAllocator *a = shared_->ownBaseAllocator;
+        shared_->~SharedData();
+        baseAllocator_->Free(shared_);
+        RAPIDJSON_DELETE(a);
+    }
+
+    //! Hands all memory chunks back to the free list for reuse.
+    /*! Takes one step per thread that has allocated from the pool, however many chunks there
+        are, plus one per block larger than the chunk size. Every block allocated so far becomes
+        invalid.
+    */
+    void Clear() RAPIDJSON_NOEXCEPT {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        for (ThreadArena* arena = shared_->arenas.load(std::memory_order_acquire); arena; arena = arena->next) {
+            if (arena->chunkHead) {
+                PushFree(arena->chunkHead, arena->chunkTail);
+                arena->chunkHead = arena->chunkTail = 0;
+            }
+            FreeChunks(arena->largeChunks);
+            arena->largeChunks = 0;
+        }
+    }
+
+    //! Allocates chunks into the free list ahead of use.
+    /*! \param chunkCount Number of chunks of the chunk size to add.
+        \return true if success.
+    */
+    bool Reserve(size_t chunkCount) {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        for (size_t i = 0; i < chunkCount; i++) {
+            ChunkHeader* chunk = NewChunk(chunk_capacity_);
+            if (!chunk)
+                return false;
+            PushFree(chunk, chunk);
+        }
+        return true;
+    }
+
+    //! Computes the total capacity of allocated memory chunks, including the free ones.
+    /*! \return total capacity in bytes.
+    */
+    size_t Capacity() const RAPIDJSON_NOEXCEPT {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        size_t capacity = 0;
+        for (ThreadArena* arena = shared_->arenas.load(std::memory_order_acquire); arena; arena = arena->next)
+            for (int list = 0; list < 2; list++)
+                for (ChunkHeader* c = list ? arena->largeChunks : arena->chunkHead; c != 0; c = c->next.load(std::memory_order_relaxed))
+                    capacity += c->capacity;
+        for (ChunkHeader* c = TaggedChunk(shared_->freeChunks.load(std::memory_order_acquire)); c != 0; c = c->next.load(std::memory_order_relaxed))
+            capacity += c->capacity;
+        return capacity;
+    }
+
+    //! Computes the memory blocks allocated.
+    /*! \return total used bytes.
+    */
+    size_t Size() const RAPIDJSON_NOEXCEPT {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        size_t size = 0;
+        for (ThreadArena* arena = shared_->arenas.load(std::memory_order_acquire); arena; arena = arena->next)
+            for (int list = 0; list < 2; list++)
+                for (ChunkHeader* c = list ? arena->largeChunks : arena->chunkHead; c != 0; c = c->next.load(std::memory_order_relaxed))
+                    size += c->size;
+        return size;
+    }
+
+    //! Whether the allocator is shared.
+    /*! \return true or false.
+    */
+    bool Shared() const RAPIDJSON_NOEXCEPT {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        return shared_->refcount.load(std::memory_order_relaxed) > 1;
+    }
+
+    //! Allocates a memory block. (concept Allocator)
+    void* Malloc(size_t size) {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        if (!size)
+            return NULL;
+
+        size = RAPIDJSON_ALIGN(size);
+        ThreadArena* arena = LocalArena();
+        if (RAPIDJSON_UNLIKELY(!arena))
+            return NULL;
+        ChunkHeader* chunk = arena->chunkHead;
+        if (RAPIDJSON_UNLIKELY(!chunk || chunk->size + size > chunk->capacity))
+            if (!(chunk = AddChunk(arena, size)))
+                return NULL;
+
+        void *buffer = GetChunkBuffer(chunk) + chunk->size;
+        chunk->size += size;
+        return buffer;
+    }
+
+    //! Resizes a memory block (concept Allocator)
+    void* Realloc(void* originalPtr, size_t originalSize, size_t newSize) {
+        if (originalPtr == 0)
+            return Malloc(newSize);
+
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        if (newSize == 0)
+            return NULL;
+
+        originalSize = RAPIDJSON_ALIGN(originalSize);
+        newSize = RAPIDJSON_ALIGN(newSize);
+
+        // Do not shrink if new size is smaller than original
+        if (originalSize >= newSize)
+            return originalPtr;
+
+        // Simply expand it if it is the last allocation of this thread and there is sufficient space
+        ThreadArena* arena = LocalArena();
+        if (ChunkHeader* chunk = arena ? arena->chunkHead : 0) {
+            if (originalPtr == GetChunkBuffer(chunk) + chunk->size - originalSize) {
+                size_t increment = static_cast<size_t>(newSize - originalSize);
+                if (chunk->size + increment <= chunk->capacity) {
+                    chunk->size += increment;
+                    return originalPtr;
+                }
+            }
+        }
+
+        // Realloc process: allocate and copy memory, do not free original buffer.
+        if (void* newBuffer = Malloc(newSize)) {
+            if (originalSize)
+                std::memcpy(newBuffer, originalPtr, originalSize);
+            return newBuffer;
+        }
+        else
+            return NULL;
+    }
+
+    //! Frees a memory block (concept Allocator)
+    static void Free(void *ptr) RAPIDJSON_NOEXCEPT { (void)ptr; } // Do nothing
+
+    //! Compare (equality) with another ConcurrentMemoryPoolAllocator
+    bool operator==(const ConcurrentMemoryPoolAllocator& rhs) const RAPIDJSON_NOEXCEPT {
+        RAPIDJSON_NOEXCEPT_ASSERT(shared_->refcount > 0);
+        RAPIDJSON_NOEXCEPT_ASSERT(rhs.shared_->refcount > 0);
+        return shared_ == rhs.shared_;
+    }
+    //! Compare (inequality) with another ConcurrentMemoryPoolAllocator
+    bool operator!=(const ConcurrentMemoryPoolAllocator& rhs) const RAPIDJSON_NOEXCEPT {
+        return !operator==(rhs);
+    }
+
+private:
+    static uint64_t NextPoolId() {
+        static std::atomic<uint64_t> nextId(1);
+        return nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static ArenaCache& LocalCache() {
+        static thread_local ArenaCache cache = { 0, 0 };
+        return cache;
+    }
+
+    //! The calling thread's arena, created on its first allocation from the pool.
+    ThreadArena* LocalArena() {
+        ArenaCache& cache = LocalCache();
+        if (RAPIDJSON_LIKELY(cache.poolId == shared_->id))
+            return cache.arena;
+
+        const std::thread::id self = std::this_thread::get_id();
+        ThreadArena* head = shared_->arenas.load(std::memory_order_acquire);
+        ThreadArena* arena = head;
+        while (arena && arena->owner != self)
+            arena = arena->next;
+        if (!arena) {
+            // Only this thread adds an arena for itself, so it cannot appear while this one is pushed.
+            arena = static_cast<ThreadArena*>(baseAllocator_->Malloc(sizeof(ThreadArena)));
+            if (!arena)
+                return 0;
+            new (arena) ThreadArena();
+            arena->owner = self;
+            arena->chunkHead = arena->chunkTail = arena->largeChunks = 0;
+            arena->next = head;
+            while (!shared_->arenas.compare_exchange_weak(arena->next, arena, std::memory_order_release, std::memory_order_relaxed))
+                ;
+        }
+        cache.poolId = shared_->id;
+        cache.arena = arena;
+        return arena;
+    }
+
+    //! Makes a chunk with room for size bytes the head of the arena's list.
+    /*! Requests larger than the chunk size get a chunk of their own, kept aside so that the
+        rest of the head chunk keeps serving smaller ones.
+        \return the chunk, or 0 if out of memory.
+    */
+    ChunkHeader* AddChunk(ThreadArena* arena, size_t size) {
+        ChunkHeader* chunk;
+        if (size > chunk_capacity_) {
+            if (!(chunk = NewChunk(size)))
+                return 0;
+            chunk->next.store(arena->largeChunks, std::memory_order_relaxed);
+            arena->largeChunks = chunk;
+            return chunk;
+        }
+        if (!(chunk = PopFree()) && !(chunk = NewChunk(chunk_capacity_)))
+            return 0;
+
+        chunk->size = 0;
+        chunk->next.store(arena->chunkHead, std::memory_order_relaxed);
+        if (!arena->chunkHead)
+            arena->chunkTail = chunk;
+        arena->chunkHead = chunk;
+        return chunk;
+    }
+
+    void FreeChunks(ChunkHeader* c) RAPIDJSON_NOEXCEPT {
+        while (c) {
+            ChunkHeader* next = c->next.load(std::memory_order_relaxed);
+            c->~ChunkHeader();
+            baseAllocator_->Free(c);
+            c = next;
+        }
+    }
+
+    ChunkHeader* NewChunk(size_t capacity) {
+        ChunkHeader* chunk = static_cast<ChunkHeader*>(baseAllocator_->Malloc(SIZEOF_CHUNK_HEADER + capacity));
+        if (chunk) {
+            new (chunk) ChunkHeader();
+            chunk->capacity = capacity;
+            chunk->size = 0;
+            chunk->next.store(0, std::memory_order_relaxed);
+        }
+        return chunk;
+    }
+
+    // The free list head packs a chunk pointer with a counter bumped on every change, so that
+    // a pop does not succeed against a head that was popped and pushed back meanwhile (ABA).
+    // 64-bit targets keep the pointer in the lower 48 bits, as RAPIDJSON_48BITPOINTER_OPTIMIZATION does.
+    static const unsigned kTagShift = sizeof(void*) == 8 ? 48 : 32;
+
+    static ChunkHeader* TaggedChunk(uint64_t tagged) {
+        return reinterpret_cast<ChunkHeader*>(static_cast<uintptr_t>(tagged & ((uint64_t(1) << kTagShift) - 1)));
+    }
+    static uint64_t Tag(ChunkHeader* chunk, uint64_t previous) {
+        const uint64_t pointer = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(chunk));
+        RAPIDJSON_NOEXCEPT_ASSERT((pointer >> kTagShift) == 0);
+        return ((previous >> kTagShift) + 1) << kTagShift | pointer;
+    }
+
+    //! Pushes the chunks first..last, already linked, onto the free list.
+    void PushFree(ChunkHeader* first, ChunkHeader* last) RAPIDJSON_NOEXCEPT {
+        uint64_t head = shared_->freeChunks.load(std::memory_order_relaxed);
+        do {
+            last->next.store(TaggedChunk(head), std::memory_order_relaxed);
+        } while (!shared_->freeChunks.compare_exchange_weak(head, Tag(first, head), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    ChunkHeader* PopFree() RAPIDJSON_NOEXCEPT {
+        uint64_t head = shared_->freeChunks.load(std::memory_order_acquire);
+        for (;;) {
+            ChunkHeader* chunk = TaggedChunk(head);
+            if (!chunk)
+                return 0;
+            // chunk may be taken by another thread meanwhile; then the tag has moved on and the exchange fails.
+            // Chunks are only freed with the pool, so reading its link stays safe.
+            ChunkHeader* next = chunk->next.load(std::memory_order_relaxed);
+            if (shared_->freeChunks.compare_exchange_weak(head, Tag(next, head), std::memory_order_acquire, std::memory_order_acquire))
+                return chunk;
+        }
+    }
+
+    size_t chunk_capacity_;         //!< The minimum capacity of chunk when they are allocated.
+    BaseAllocator* baseAllocator_;  //!< base allocator for allocating memory chunks.
+    SharedData *shared_;            //!< The shared data of the allocator
+};
+
+RAPIDJSON_NAMESPACE_END
+
+#endif // RAPIDJSON_HAS_CXX11
+
+#endif // RAPIDJSON_CONCURRENTALLOCATOR_H_
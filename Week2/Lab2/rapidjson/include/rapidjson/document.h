@@ -2263,7 +2263,148 @@ private:
         }
     }
 
-#else // !RAPIDJSON_USE_MEMBERSMAP
+#elif RAPIDJSON_USE_MEMBERINDEX
+
+    //
+    // Layout of the members' array of an object with a capacity of at least
+    // RAPIDJSON_MEMBERINDEX_THRESHOLD, re(al)located according to the needed capacity:
+    //
+    //    {Member[capacity]}<>{MemberIndex}{SizeType[slots]}
+    //
+    // (where <> stands for the RAPIDJSON_ALIGN-ment, if needed)
+    //
+    // A slot holds 1 + the position of a member, or 0. Names are probed linearly from their
+    // hash, and the table has at least twice as many slots as the capacity, so it never fills
+    // up. Without deletions the first member with a given name is also the first one probed.
+    //
+
+    struct MemberIndex {
+        SizeType mask;      // slots - 1
+        SizeType built;     // 1 if the slots reflect the members
+    };
+
+    static RAPIDJSON_FORCEINLINE bool HasMemberIndex(SizeType capacity) {
+        return capacity >= RAPIDJSON_MEMBERINDEX_THRESHOLD;
+    }
+
+    static size_t GetMemberIndexSlots(SizeType capacity) {
+        size_t slots = 1;
+        while (slots < 2 * static_cast<size_t>(capacity))
+            slots <<= 1;
+        return slots;
+    }
+
+    static size_t GetMembersLayoutSize(SizeType capacity) {
+        if (!HasMemberIndex(capacity))
+            return capacity * sizeof(Member);
+        return RAPIDJSON_ALIGN(capacity * sizeof(Member)) +
+               sizeof(MemberIndex) +
+               GetMemberIndexSlots(capacity) * sizeof(SizeType);
+    }
+
+    static RAPIDJSON_FORCEINLINE MemberIndex* GetMemberIndex(Member* members, SizeType capacity) {
+        RAPIDJSON_ASSERT(members != 0 && HasMemberIndex(capacity));
+        return reinterpret_cast<MemberIndex*>(reinterpret_cast<uintptr_t>(members) +
+                                              RAPIDJSON_ALIGN(capacity * sizeof(Member)));
+    }
+
+    static RAPIDJSON_FORCEINLINE SizeType* GetMemberIndexSlots(MemberIndex* index) {
+        return reinterpret_cast<SizeType*>(index + 1);
+    }
+
+    // FNV-1a over the bytes of the name
+    template <typename SourceAllocator>
+    static SizeType HashMemberName(const GenericValue<Encoding, SourceAllocator>& name) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(name.GetString());
+        const unsigned char* end = p + name.GetStringLength() * sizeof(Ch);
+        uint32_t h = 2166136261u;
+        for (; p != end; ++p)
+            h = (h ^ *p) * 16777619u;
+        return static_cast<SizeType>(h);
+    }
+
+    static void InsertMemberIndex(MemberIndex* index, const GenericValue& name, SizeType pos) {
+        SizeType* slots = GetMemberIndexSlots(index);
+        SizeType i = HashMemberName(name) & index->mask;
+        while (slots[i] != 0)
+            i = (i + 1) & index->mask;
+        slots[i] = pos + 1;
+    }
+
+    static void ResetMemberIndex(Member* members, SizeType capacity) {
+        if (members && HasMemberIndex(capacity)) {
+            MemberIndex* index = GetMemberIndex(members, capacity);
+            index->mask = static_cast<SizeType>(GetMemberIndexSlots(capacity) - 1);
+            index->built = 0;
+        }
+    }
+
+    void InvalidateMemberIndex() {
+        if (HasMemberIndex(data_.o.capacity))
+            GetMemberIndex(GetMembersPointer(), data_.o.capacity)->built = 0;
+    }
+
+    Member* DoAllocMembers(SizeType capacity, Allocator& allocator) {
+        Member* members = static_cast<Member*>(allocator.Malloc(GetMembersLayoutSize(capacity)));
+        ResetMemberIndex(members, capacity);
+        return members;
+    }
+
+    void DoReserveMembers(SizeType newCapacity, Allocator& allocator) {
+        ObjectData& o = data_.o;
+        if (newCapacity > o.capacity) {
+            Member* newMembers = static_cast<Member*>(allocator.Realloc(GetMembersPointer(),
+                GetMembersLayoutSize(o.capacity), GetMembersLayoutSize(newCapacity)));
+            RAPIDJSON_SETPOINTER(Member, o.members, newMembers);
+            o.capacity = newCapacity;
+            ResetMemberIndex(newMembers, newCapacity);
+        }
+    }
+
+    template <typename SourceAllocator>
+    MemberIterator DoFindIndexedMember(const GenericValue<Encoding, SourceAllocator>& name) {
+        const ObjectData& o = data_.o;
+        Member* members = GetMembersPointer();
+        MemberIndex* index = GetMemberIndex(members, o.capacity);
+        SizeType* slots = GetMemberIndexSlots(index);
+        if (!index->built) {
+            std::memset(slots, 0, (static_cast<size_t>(index->mask) + 1) * sizeof(SizeType));
+            for (SizeType i = 0; i < o.size; i++)
+                InsertMemberIndex(index, members[i].name, i);
+            index->built = 1;
+        }
+        for (SizeType i = HashMemberName(name) & index->mask; slots[i] != 0; i = (i + 1) & index->mask)
+            if (name.StringEqual(members[slots[i] - 1].name))
+                return MemberIterator(&members[slots[i] - 1]);
+        return MemberEnd();
+    }
+
+    template <typename SourceAllocator>
+    MemberIterator DoFindMember(const GenericValue<Encoding, SourceAllocator>& name) {
+        if (data_.o.size >= RAPIDJSON_MEMBERINDEX_THRESHOLD)
+            return DoFindIndexedMember(name);
+
+        MemberIterator member = MemberBegin();
+        for ( ; member != MemberEnd(); ++member)
+            if (name.StringEqual(member->name))
+                break;
+        return member;
+    }
+
+    void DoClearMembers() {
+        for (MemberIterator m = MemberBegin(); m != MemberEnd(); ++m)
+            m->~Member();
+        data_.o.size = 0;
+        InvalidateMemberIndex();
+    }
+
+    void DoFreeMembers() {
+        for (MemberIterator m = MemberBegin(); m != MemberEnd(); ++m)
+            m->~Member();
+        Allocator::Free(GetMembersPointer());
+    }
+
+#else // !RAPIDJSON_USE_MEMBERSMAP && !RAPIDJSON_USE_MEMBERINDEX
 
     RAPIDJSON_FORCEINLINE Member* DoAllocMembers(SizeType capacity, Allocator& allocator) {
         return Malloc<Member>(allocator, capacity);
@@ -2299,7 +2440,7 @@ private:
         Allocator::Free(GetMembersPointer());
     }
 
-#endif // !RAPIDJSON_USE_MEMBERSMAP
+#endif // !RAPIDJSON_USE_MEMBERSMAP && !RAPIDJSON_USE_MEMBERINDEX
 
     void DoAddMember(GenericValue& name, GenericValue& value, Allocator& allocator) {
         ObjectData& o = data_.o;
@@ -2313,6 +2454,12 @@ private:
         Map* &map = GetMap(members);
         MapIterator* mit = GetMapIterators(map);
         new (&mit[o.size]) MapIterator(map->insert(MapPair(m->name.data_, o.size)));
+#elif RAPIDJSON_USE_MEMBERINDEX
+        if (HasMemberIndex(o.capacity)) {
+            MemberIndex* index = GetMemberIndex(members, o.capacity);
+            if (index->built)
+                InsertMemberIndex(index, m->name, o.size);
+        }
 #endif
         ++o.size;
     }
@@ -2325,6 +2472,8 @@ private:
         MapIterator* mit = GetMapIterators(map);
         SizeType mpos = static_cast<SizeType>(&*m - members);
         map->erase(DropMapIterator(mit[mpos]));
+#elif RAPIDJSON_USE_MEMBERINDEX
+        InvalidateMemberIndex();
 #endif
         MemberIterator last(members + (o.size - 1));
         if (o.size > 1 && m != last) {
@@ -2370,6 +2519,10 @@ private:
 #else
         std::memmove(static_cast<void*>(&*pos), &*last,
                      static_cast<size_t>(end - last) * sizeof(Member));
+#if RAPIDJSON_USE_MEMBERINDEX
+        if (first != last)
+            InvalidateMemberIndex();
+#endif
 #endif
         o.size -= static_cast<SizeType>(last - first);
         return pos;
@@ -22,6 +22,7 @@
 #include "itoa.h" // GetDigitsLut()
 #include "diyfp.h"
 #include "ieee754.h"
+#include "ryu.h"
 
 RAPIDJSON_NAMESPACE_BEGIN
 namespace internal {
@@ -234,7 +235,11 @@ inline char* dtoa(double value, char* buffer, int maxDecimalPlaces = 324) {
             value = -value;
         }
         int length, K;
+#if RAPIDJSON_DTOA_RYU
+        Ryu(value, buffer, &length, &K);
+#else
         Grisu2(value, buffer, &length, &K);
+#endif
         return Prettify(buffer, length, K, maxDecimalPlaces);
     }
 }
@@ -36,80 +36,92 @@ inline const char* GetDigitsLut() {
     return cDigitsLut;
 }
 
-inline char* u32toa(uint32_t value, char* buffer) {
-    RAPIDJSON_ASSERT(buffer != 0);
-
-    const char* cDigitsLut = GetDigitsLut();
-
-    if (value < 10000) {
-        const uint32_t d1 = (value / 100) << 1;
-        const uint32_t d2 = (value % 100) << 1;
+inline void WriteDigitPair(uint32_t value, char* buffer) {
+    RAPIDJSON_ASSERT(value < 100);
+    const char* d = GetDigitsLut() + value * 2;
+    buffer[0] = d[0];
+    buffer[1] = d[1];
+}
 
-        if (value >= 1000)
-            *buffer++ = cDigitsLut[d1];
-        if (value >= 100)
-            *buffer++ = cDigitsLut[d1 + 1];
-        if (value >= 10)
-            *buffer++ = cDigitsLut[d2];
-        *buffer++ = cDigitsLut[d2 + 1];
+template <int N>
+struct Pow10U32 { static const uint32_t kValue = 10 * Pow10U32<N - 1>::kValue; };
+
+template <>
+struct Pow10U32<0> { static const uint32_t kValue = 1; };
+
+//! Writes the N + 2 digits of value, for 10^(N+1) <= value < 10^(N+2) (or with leading zeros below).
+/*! value / 10^N is formed as a 32.32 fixed-point number whose integer part is the first two
+    digits; multiplying the fraction by 100 brings the next two into the integer part, so no
+    further division is needed. The scale and rounding terms (after James Anhalt's itoa) keep
+    the error too small to change a digit, which was checked for every 32-bit value.
+*/
+template <int N>
+inline char* WriteDigits(uint32_t value, char* buffer) {
+    const int kShift = N / 5 * N * 53 / 16;
+    uint64_t t = ((uint64_t(1) << (32 + kShift)) / Pow10U32<N>::kValue + 1 + N / 6 - N / 8) * value;
+    t = (t >> kShift) + N / 6 * 4;
+    WriteDigitPair(static_cast<uint32_t>(t >> 32), buffer);
+    for (int i = 2; i < N + 1; i += 2) {
+        t = uint64_t(100) * static_cast<uint32_t>(t);
+        WriteDigitPair(static_cast<uint32_t>(t >> 32), buffer + i);
     }
-    else if (value < 100000000) {
-        // value = bbbbcccc
-        const uint32_t b = value / 10000;
-        const uint32_t c = value % 10000;
-
-        const uint32_t d1 = (b / 100) << 1;
-        const uint32_t d2 = (b % 100) << 1;
-
-        const uint32_t d3 = (c / 100) << 1;
-        const uint32_t d4 = (c % 100) << 1;
-
-        if (value >= 10000000)
-            *buffer++ = cDigitsLut[d1];
-        if (value >= 1000000)
-            *buffer++ = cDigitsLut[d1 + 1];
-        if (value >= 100000)
-            *buffer++ = cDigitsLut[d2];
-        *buffer++ = cDigitsLut[d2 + 1];
+    if (N % 2 != 0)
+        buffer[N + 1] = static_cast<char>('0' + ((uint64_t(10) * static_cast<uint32_t>(t)) >> 32));
+    return buffer + N + 2;
+}
 
-        *buffer++ = cDigitsLut[d3];
-        *buffer++ = cDigitsLut[d3 + 1];
-        *buffer++ = cDigitsLut[d4];
-        *buffer++ = cDigitsLut[d4 + 1];
-    }
-    else {
-        // value = aabbbbcccc in decimal
+//! Writes exactly 8 digits of value < 10^8, leading zeros included.
+/*! The digits are split in SWAR fashion inside one 64-bit word (two 4-digit halves, then four
+    pairs, then eight digits, each step a multiply-shift division per lane) and stored at once.
+*/
+inline char* Write8Digits(uint32_t value, char* buffer) {
+    RAPIDJSON_ASSERT(value < 100000000);
+    uint64_t x = value;
+    uint64_t q = (x * 0x68DB8BB) >> 40;                                 // value / 10000
+    x = q | ((x - q * 10000) << 32);                                    // abcd | efgh << 32
+    q = ((x * 0x147B) >> 19) & RAPIDJSON_UINT64_C2(0x7F, 0x0000007F);   // / 100 in each 32-bit lane
+    x = q | ((x - q * 100) << 16);                                      // ab | cd << 16 | ...
+    q = ((x * 0x67) >> 10) & RAPIDJSON_UINT64_C2(0x000F000F, 0x000F000F); // / 10 in each 16-bit lane
+    x = q | ((x - q * 10) << 8);                                        // a | b << 8 | ...
+    x |= RAPIDJSON_UINT64_C2(0x30303030, 0x30303030);
+#if RAPIDJSON_ENDIAN == RAPIDJSON_LITTLEENDIAN
+    std::memcpy(buffer, &x, 8);
+#else
+    for (int i = 0; i < 8; i++)
+        buffer[i] = static_cast<char>(x >> (8 * i));
+#endif
+    return buffer + 8;
+}
 
-        const uint32_t a = value / 100000000; // 1 to 42
-        value %= 100000000;
+inline char* u32toa(uint32_t value, char* buffer) {
+    RAPIDJSON_ASSERT(buffer != 0);
 
-        if (a >= 10) {
-            const unsigned i = a << 1;
-            *buffer++ = cDigitsLut[i];
-            *buffer++ = cDigitsLut[i + 1];
+    // Length by binary search, then the digits without divisions.
+    if (value < 100) {
+        if (value < 10) {
+            *buffer = static_cast<char>('0' + static_cast<char>(value));
+            return buffer + 1;
         }
-        else
-            *buffer++ = static_cast<char>('0' + static_cast<char>(a));
-
-        const uint32_t b = value / 10000; // 0 to 9999
-        const uint32_t c = value % 10000; // 0 to 9999
-
-        const uint32_t d1 = (b / 100) << 1;
-        const uint32_t d2 = (b % 100) << 1;
-
-        const uint32_t d3 = (c / 100) << 1;
-        const uint32_t d4 = (c % 100) << 1;
-
-        *buffer++ = cDigitsLut[d1];
-        *buffer++ = cDigitsLut[d1 + 1];
-        *buffer++ = cDigitsLut[d2];
-        *buffer++ = cDigitsLut[d2 + 1];
-        *buffer++ = cDigitsLut[d3];
-        *buffer++ = cDigitsLut[d3 + 1];
-        *buffer++ = cDigitsLut[d4];
-        *buffer++ = cDigitsLut[d4 + 1];
+        WriteDigitPair(value, buffer);
+        return buffer + 2;
+    }
+    if (value < 1000000) {
+        if (value < 10000)
+            return value < 1000 ? WriteDigits<1>(value, buffer) : WriteDigits<2>(value, buffer);
+        return value < 100000 ? WriteDigits<3>(value, buffer) : WriteDigits<4>(value, buffer);
+    }
+    if (value < 100000000)
+        return value < 10000000 ? WriteDigits<5>(value, buffer) : WriteDigits<6>(value, buffer);
+
+    // value = aabbbbcccc in decimal
+    const uint32_t a = value / 100000000; // 1 to 42
+    if (a >= 10) {
+        WriteDigitPair(a, buffer);
+        buffer += 2;
     }
-    return buffer;
+    else
+        *buffer++ = static_cast<char>('0' + static_cast<char>(a));
+    return Write8Digits(value % 100000000, buffer);
 }
 
 inline char* i32toa(int32_t value, char* buffer) {
@@ -125,170 +137,19 @@ inline char* i32toa(int32_t value, char* buffer) {
 
 inline char* u64toa(uint64_t value, char* buffer) {
     RAPIDJSON_ASSERT(buffer != 0);
-    const char* cDigitsLut = GetDigitsLut();
     const uint64_t  kTen8 = 100000000;
-    const uint64_t  kTen9 = kTen8 * 10;
-    const uint64_t kTen10 = kTen8 * 100;
-    const uint64_t kTen11 = kTen8 * 1000;
-    const uint64_t kTen12 = kTen8 * 10000;
-    const uint64_t kTen13 = kTen8 * 100000;
-    const uint64_t kTen14 = kTen8 * 1000000;
-    const uint64_t kTen15 = kTen8 * 10000000;
     const uint64_t kTen16 = kTen8 * kTen8;
 
-    if (value < kTen8) {
-        uint32_t v = static_cast<uint32_t>(value);
-        if (v < 10000) {
-            const uint32_t d1 = (v / 100) << 1;
-            const uint32_t d2 = (v % 100) << 1;
-
-            if (v >= 1000)
-                *buffer++ = cDigitsLut[d1];
-            if (v >= 100)
-                *buffer++ = cDigitsLut[d1 + 1];
-            if (v >= 10)
-                *buffer++ = cDigitsLut[d2];
-            *buffer++ = cDigitsLut[d2 + 1];
-        }
-        else {
-            // value = bbbbcccc
-            const uint32_t b = v / 10000;
-            const uint32_t c = v % 10000;
-
-            const uint32_t d1 = (b / 100) << 1;
-            const uint32_t d2 = (b % 100) << 1;
-
-            const uint32_t d3 = (c / 100) << 1;
-            const uint32_t d4 = (c % 100) << 1;
-
-            if (value >= 10000000)
-                *buffer++ = cDigitsLut[d1];
-            if (value >= 1000000)
-                *buffer++ = cDigitsLut[d1 + 1];
-            if (value >= 100000)
-                *buffer++ = cDigitsLut[d2];
-            *buffer++ = cDigitsLut[d2 + 1];
-
-            *buffer++ = cDigitsLut[d3];
-            *buffer++ = cDigitsLut[d3 + 1];
-            *buffer++ = cDigitsLut[d4];
-            *buffer++ = cDigitsLut[d4 + 1];
-        }
+    if (value <= 0xFFFFFFFF)
+        return u32toa(static_cast<uint32_t>(value), buffer);
+    if (value < kTen16) {
+        buffer = u32toa(static_cast<uint32_t>(value / kTen8), buffer);
+        return Write8Digits(static_cast<uint32_t>(value % kTen8), buffer);
     }
-    else if (value < kTen16) {
-        const uint32_t v0 = static_cast<uint32_t>(value / kTen8);
-        const uint32_t v1 = static_cast<uint32_t>(value % kTen8);
-
-        const uint32_t b0 = v0 / 10000;
-        const uint32_t c0 = v0 % 10000;
-
-        const uint32_t d1 = (b0 / 100) << 1;
-        const uint32_t d2 = (b0 % 100) << 1;
-
-        const uint32_t d3 = (c0 / 100) << 1;
-        const uint32_t d4 = (c0 % 100) << 1;
-
-        const uint32_t b1 = v1 / 10000;
-        const uint32_t c1 = v1 % 10000;
-
-        const uint32_t d5 = (b1 / 100) << 1;
-        const uint32_t d6 = (b1 % 100) << 1;
-
-        const uint32_t d7 = (c1 / 100) << 1;
-        const uint32_t d8 = (c1 % 100) << 1;
-
-        if (value >= kTen15)
-            *buffer++ = cDigitsLut[d1];
-        if (value >= kTen14)
-            *buffer++ = cDigitsLut[d1 + 1];
-        if (value >= kTen13)
-            *buffer++ = cDigitsLut[d2];
-        if (value >= kTen12)
-            *buffer++ = cDigitsLut[d2 + 1];
-        if (value >= kTen11)
-            *buffer++ = cDigitsLut[d3];
-        if (value >= kTen10)
-            *buffer++ = cDigitsLut[d3 + 1];
-        if (value >= kTen9)
-            *buffer++ = cDigitsLut[d4];
-
-        *buffer++ = cDigitsLut[d4 + 1];
-        *buffer++ = cDigitsLut[d5];
-        *buffer++ = cDigitsLut[d5 + 1];
-        *buffer++ = cDigitsLut[d6];
-        *buffer++ = cDigitsLut[d6 + 1];
-        *buffer++ = cDigitsLut[d7];
-        *buffer++ = cDigitsLut[d7 + 1];
-        *buffer++ = cDigitsLut[d8];
-        *buffer++ = cDigitsLut[d8 + 1];
-    }
-    else {
-        const uint32_t a = static_cast<uint32_t>(value / kTen16); // 1 to 1844
-        value %= kTen16;
-
-        if (a < 10)
-            *buffer++ = static_cast<char>('0' + static_cast<char>(a));
-        else if (a < 100) {
-            const uint32_t i = a << 1;
-            *buffer++ = cDigitsLut[i];
-            *buffer++ = cDigitsLut[i + 1];
-        }
-        else if (a < 1000) {
-            *buffer++ = static_cast<char>('0' + static_cast<char>(a / 100));
-
-            const uint32_t i = (a % 100) << 1;
-            *buffer++ = cDigitsLut[i];
-            *buffer++ = cDigitsLut[i + 1];
-        }
-        else {
-            const uint32_t i = (a / 100) << 1;
-            const uint32_t j = (a % 100) << 1;
-            *buffer++ = cDigitsLut[i];
-            *buffer++ = cDigitsLut[i + 1];
-            *buffer++ = cDigitsLut[j];
-            *buffer++ = cDigitsLut[j + 1];
-        }
-
-        const uint32_t v0 = static_cast<uint32_t>(value / kTen8);
-        const uint32_t v1 = static_cast<uint32_t>(value % kTen8);
-
-        const uint32_t b0 = v0 / 10000;
-        const uint32_t c0 = v0 % 10000;
-
-        const uint32_t d1 = (b0 / 100) << 1;
-        const uint32_t d2 = (b0 % 100) << 1;
-
-        const uint32_t d3 = (c0 / 100) << 1;
-        const uint32_t d4 = (c0 % 100) << 1;
-
-        const uint32_t b1 = v1 / 10000;
-        const uint32_t c1 = v1 % 10000;
-
-        const uint32_t d5 = (b1 / 100) << 1;
-        const uint32_t d6 = (b1 % 100) << 1;
-
-        const uint32_t d7 = (c1 / 100) << 1;
-        const uint32_t d8 = (c1 % 100) << 1;
-
-        *buffer++ = cDigitsLut[d1];
-        *buffer++ = cDigitsLut[d1 + 1];
-        *buffer++ = cDigitsLut[d2];
-        *buffer++ = cDigitsLut[d2 + 1];
-        *buffer++ = cDigitsLut[d3];
-        *buffer++ = cDigitsLut[d3 + 1];
-        *buffer++ = cDigitsLut[d4];
-        *buffer++ = cDigitsLut[d4 + 1];
-        *buffer++ = cDigitsLut[d5];
-        *buffer++ = cDigitsLut[d5 + 1];
-        *buffer++ = cDigitsLut[d6];
-        *buffer++ = cDigitsLut[d6 + 1];
-        *buffer++ = cDigitsLut[d7];
-        *buffer++ = cDigitsLut[d7 + 1];
-        *buffer++ = cDigitsLut[d8];
-        *buffer++ = cDigitsLut[d8 + 1];
-    }
-
-    return buffer;
+    buffer = u32toa(static_cast<uint32_t>(value / kTen16), buffer); // 1 to 1844
+    value %= kTen16;
+    buffer = Write8Digits(static_cast<uint32_t>(value / kTen8), buffer);
+    return Write8Digits(static_cast<uint32_t>(value % kTen8), buffer);
 }
 
 inline char* i64toa(int64_t value, char* buffer) {
@@ -0,0 +1,344 @@
+// Tencent is pleased to support the open source community by making RapidJSON available.
+//
+// Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef RAPIDJSON_INTERNAL_SIMD_H_
+#define RAPIDJSON_INTERNAL_SIMD_H_
+
+#include "../rapidjson.h"
+
+#if RAPIDJSON_SIMD_DISPATCH
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+//! Compile one function for an instruction set the rest of the build does not assume.
+/*! MSVC allows any intrinsic anywhere, GCC and Clang need the target attribute. */
+#ifdef _MSC_VER
+#define RAPIDJSON_TARGET_AVX2
+#define RAPIDJSON_TARGET_AVX512
+#else
+#define RAPIDJSON_TARGET_AVX2 __attribute__((target("avx2,bmi")))
+#define RAPIDJSON_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,bmi")))
+#endif
+
+//! The null-terminated scans read whole blocks past the terminator, never past its page.
+/*! That is safe but looks like an overflow to AddressSanitizer, so the kernels opt out. */
+#if defined(__SANITIZE_ADDRESS__)
+#define RAPIDJSON_SIMD_NO_SANITIZE __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define RAPIDJSON_SIMD_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef RAPIDJSON_SIMD_NO_SANITIZE
+#define RAPIDJSON_SIMD_NO_SANITIZE
+#endif
+
+RAPIDJSON_NAMESPACE_BEGIN
+
+//! Instruction set used by the runtime-dispatched SIMD kernels of GenericReader.
+/*! The best level the CPU and OS support is picked on first use. SSE2 is part of x86-64,
+    so kSimdScalar is only there to compare against. \see GetSimdLevel(), SetSimdLevel()
+*/
+enum SimdLevel {
+    kSimdScalar = 0,    //!< One char per step.
+    kSimdSSE2 = 1,      //!< 16 bytes per step.
+    kSimdAVX2 = 2,      //!< 32 bytes per step.
+    kSimdAVX512 = 3     //!< 64 bytes per step, needs AVX-512BW.
+};
+
+namespace internal {
+
+inline uint32_t ctzll(uint64_t x) {
+    RAPIDJSON_ASSERT(x != 0);
+#ifdef _MSC_VER
+    unsigned long r = 0;
+    _BitScanForward64(&r, x);
+    return r;
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(x));
+#endif
+}
+
+//! Highest SimdLevel that both the CPU and the OS (saved register state) support.
+inline SimdLevel DetectSimdLevel() {
+    unsigned regs[4] = { 0, 0, 0, 0 };  // eax, ebx, ecx, edx
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    unsigned maxLeaf = static_cast<unsigned>(info[0]);
+    if (maxLeaf < 7)
+        return kSimdSSE2;
+    __cpuidex(info, 1, 0);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    __cpuidex(info, 7, 0);
+    for (int i = 0; i < 4; i++)
+        regs[i] = static_cast<unsigned>(info[i]);
+    uint64_t xcr0 = osxsave ? _xgetbv(0) : 0;
+#else
+    if (__get_cpuid_max(0, 0) < 7)
+        return kSimdSSE2;
+    unsigned eax, ebx, ecx, edx;
+    __cpuid_count(1, 0, eax, ebx, ecx, edx);
+    bool osxsave = (ecx & (1u << 27)) != 0;
+    __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+    uint64_t xcr0 = 0;
+    if (osxsave) {
+        unsigned lo, hi;
+        __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        xcr0 = (static_cast<uint64_t>(hi) << 32) | lo;
+    }
+#endif
+    const bool avx2 = (regs[1] & (1u << 5)) != 0 && (regs[1] & (1u << 3)) != 0;   // AVX2, BMI1
+    const bool avx512 = (regs[1] & (1u << 16)) != 0 && (regs[1] & (1u << 30)) != 0; // AVX512F, AVX512BW
+    if (avx512 && avx2 && (xcr0 & 0xE6) == 0xE6)    // XMM, YMM, opmask and ZMM state
+        return kSimdAVX512;
+    if (avx2 && (xcr0 & 0x6) == 0x6)                // XMM and YMM state
+        return kSimdAVX2;
+    return kSimdSSE2;
+}
+
+//! True if an N-byte unaligned load at p cannot touch the next page.
+template <size_t N>
+inline bool SimdLoadIsPageSafe(const char* p) {
+    return (reinterpret_cast<uintptr_t>(p) & 4095) <= 4096 - N;
+}
+
+inline bool IsJsonWhitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool IsJsonStringSpecial(char c) {
+    return c == '\"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+// Each instruction set provides a Block class with
+//   static const size_t kSize;
+//   static uint64_t NonWhitespace(const char* p, bool aligned);  // bit i set: p[i] is not JSON whitespace
+//   static uint64_t Special(const char* p, bool aligned);        // bit i set: p[i] is '"', '\\' or < 0x20
+// and the shared loops below turn those masks into pointers.
+
+//! Null-terminated scan: first char of p for which the mask is set.
+/*! Loads stay within the page of the terminator: a first unaligned block only when it cannot
+    cross a page, scalar steps up to the next aligned block otherwise, aligned blocks after that.
+*/
+#define RAPIDJSON_SIMD_SCAN(Block, Mask, IsHit) \
+    if (SimdLoadIsPageSafe<Block::kSize>(p)) { \
+        uint64_t m = Block::Mask(p, false); \
+        if (m != 0) \
+            return p + ctzll(m); \
+        p = reinterpret_cast<const char*>((reinterpret_cast<uintptr_t>(p) + Block::kSize) & ~static_cast<uintptr_t>(Block::kSize - 1)); \
+    } \
+    else { \
+        const char* nextAligned = reinterpret_cast<const char*>((reinterpret_cast<uintptr_t>(p) + Block::kSize - 1) & ~static_cast<uintptr_t>(Block::kSize - 1)); \
+        for (; p != nextAligned; ++p) \
+            if (IsHit(*p)) \
+                return p; \
+    } \
+    for (;; p += Block::kSize) { \
+        uint64_t m = Block::Mask(p, true); \
+        if (m != 0) \
+            return p + ctzll(m); \
+    }
+
+//! Bounded scan over [p, end): unaligned blocks, then a scalar tail.
+#define RAPIDJSON_SIMD_SCAN_BOUNDED(Block, Mask, IsHit) \
+    for (; end - p >= static_cast<ptrdiff_t>(Block::kSize); p += Block::kSize) { \
+        uint64_t m = Block::Mask(p, false); \
+        if (m != 0) \
+            return p + ctzll(m); \
+    } \
+    for (; p != end; ++p) \
+        if (IsHit(*p)) \
+            return p; \
+    return end;
+
+struct SimdBlockSSE2 {
+    static const size_t kSize = 16;
+
+    static RAPIDJSON_SIMD_NO_SANITIZE RAPIDJSON_FORCEINLINE __m128i Load(const char* p, bool aligned) {
+        return aligned ? _mm_load_si128(reinterpret_cast<const __m128i*>(p)) : _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static RAPIDJSON_SIMD_NO_SANITIZE RAPIDJSON_FORCEINLINE uint64_t NonWhitespace(const char* p, bool aligned) {
+        const __m128i s = Load(p, aligned);
+        __m128i x = _mm_cmpeq_epi8(s, _mm_set1_epi8(' '));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8('\n')));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8('\r')));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8('\t')));
+        return static_cast<uint16_t>(~_mm_movemask_epi8(x));
+    }
+    static RAPIDJSON_SIMD_NO_SANITIZE RAPIDJSON_FORCEINLINE uint64_t Special(const char* p, bool aligned) {
+        const __m128i s = Load(p, aligned);
+        const __m128i sp = _mm_set1_epi8(0x1F);
+        const __m128i t1 = _mm_cmpeq_epi8(s, _mm_set1_epi8('\"'));
+        const __m128i t2 = _mm_cmpeq_epi8(s, _mm_set1_epi8('\\'));
+        const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
+        return static_cast<uint16_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(t1, t2), t3)));
+    }
+};
+
+// Whitespace via one shuffle: the table holds each whitespace char at the index of its low
+// nibble, so shuffle(table, s) == s exactly for ' ', '\t', '\n' and '\r' (bytes >= 0x80
+// shuffle to 0 and never match).
+#define RAPIDJSON_SIMD_WHITESPACE_TABLE \
+    0x20, 0, 0, 0, 0, 0, 0, 0, 0, 0x09, 0x0A, 0, 0, 0x0D, 0, 0
+
+struct SimdBlockAVX2 {
+    static const size_t kSize = 32;
+
+    static RAPIDJSON_TARGET_AVX2 RAPIDJSON_SIMD_NO_SANITIZE RAPIDJSON_FORCEINLINE __m256i Load(const char* p, bool aligned) {
+        return aligned ? _mm256_load_si256(reinterpret_cast<const __m256i*>(p)) : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static RAPIDJSON_TARGET_AVX2 RAPIDJSON_SIMD_NO_SANITIZE RAPIDJSON_FORCEINLINE uint64_t NonWhitespace(const char* p, bool aligned) {
+        const __m256i table = _mm256_setr_epi8(RAPIDJSON_SIMD_WHITESPACE_TABLE, RAPIDJSON_SIMD_WHITESPACE_TABLE);
+        const __m256i s = Load(p, aligned);
+        const __m256i ws = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(table, s), s);
+        return static_cast<uint32_t>(~_mm256_movemask_epi8(ws));
+    }
+    static RAPIDJSON_TARGET_AVX2 RAPIDJSON_SIMD_NO_SANITIZE RAPIDJSON_FORCEINLINE uint64_t Special(const char* p, bool aligned) {
+        const __m256i s = Load(p, aligned);
+        const __m256i sp = _mm256_set1_epi8(0x1F);
+        const __m256i t1 = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\"'));
+        const __m256i t2 = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\\'));
+        const __m256i t3 = _mm256_cmpeq_epi8(_mm256_max_epu8(s, sp), sp);
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(t1, t2), t3)));
+    }
+};
+
+struct SimdBlockAVX512 {
+    static const size_t kSize = 64;
+
+    static RAPIDJSON_TARGET_AVX512 RAPIDJSON_SIMD_NO_SANITIZE RAPIDJSON_FORCEINLINE __m512i Load(const char* p, bool aligned) {
+        return aligned ? _mm512_load_si512(p) : _mm512_loadu_si512(p);
+    }
+    static RAPIDJSON_TARGET_AVX512 RAPIDJSON_SIMD_NO_SANITIZE RAPIDJSON_FORCEINLINE uint64_t NonWhitespace(const char* p, bool aligned) {
+        // RAPIDJSON_SIMD_WHITESPACE_TABLE as two little-endian qwords, repeated per 128-bit lane
+        const __m512i table = _mm512_set4_epi64(RAPIDJSON_UINT64_C2(0x00000D00, 0x000A0900), 0x20, RAPIDJSON_UINT64_C2(0x00000D00, 0x000A0900), 0x20);
+        const __m512i s = Load(p, aligned);
+        return _mm512_cmpneq_epi8_mask(_mm512_shuffle_epi8(table, s), s);
+    }
+    static RAPIDJSON_TARGET_AVX512 RAPIDJSON_SIMD_NO_SANITIZE RAPIDJSON_FORCEINLINE uint64_t Special(const char* p, bool aligned) {
+        const __m512i s = Load(p, aligned);
+        return _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\"')) |
+            _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\\')) |
+            _mm512_cmplt_epu8_mask(s, _mm512_set1_epi8(0x20));
+    }
+};
+
+#undef RAPIDJSON_SIMD_WHITESPACE_TABLE
+
+RAPIDJSON_SIMD_NO_SANITIZE inline const char* SkipWhitespaceSSE2(const char* p) { RAPIDJSON_SIMD_SCAN(SimdBlockSSE2, NonWhitespace, !IsJsonWhitespace) }
+RAPIDJSON_SIMD_NO_SANITIZE inline const char* SkipWhitespaceSSE2(const char* p, const char* end) { RAPIDJSON_SIMD_SCAN_BOUNDED(SimdBlockSSE2, NonWhitespace, !IsJsonWhitespace) }
+RAPIDJSON_SIMD_NO_SANITIZE inline const char* ScanUnescapedSSE2(const char* p) { RAPIDJSON_SIMD_SCAN(SimdBlockSSE2, Special, IsJsonStringSpecial) }
+inline const char* ScanUnescapedSSE2(const char* p, const char* end) { RAPIDJSON_SIMD_SCAN_BOUNDED(SimdBlockSSE2, Special, IsJsonStringSpecial) }
+
+RAPIDJSON_TARGET_AVX2 RAPIDJSON_SIMD_NO_SANITIZE inline const char* SkipWhitespaceAVX2(const char* p) { RAPIDJSON_SIMD_SCAN(SimdBlockAVX2, NonWhitespace, !IsJsonWhitespace) }
+RAPIDJSON_TARGET_AVX2 RAPIDJSON_SIMD_NO_SANITIZE inline const char* SkipWhitespaceAVX2(const char* p, const char* end) { RAPIDJSON_SIMD_SCAN_BOUNDED(SimdBlockAVX2, NonWhitespace, !IsJsonWhitespace) }
+RAPIDJSON_TARGET_AVX2 RAPIDJSON_SIMD_NO_SANITIZE inline const char* ScanUnescapedAVX2(const char* p) { RAPIDJSON_SIMD_SCAN(SimdBlockAVX2, Special, IsJsonStringSpecial) }
+RAPIDJSON_TARGET_AVX2 inline const char* ScanUnescapedAVX2(const char* p, const char* end) { RAPIDJSON_SIMD_SCAN_BOUNDED(SimdBlockAVX2, Special, IsJsonStringSpecial) }
+
+RAPIDJSON_TARGET_AVX512 RAPIDJSON_SIMD_NO_SANITIZE inline const char* SkipWhitespaceAVX512(const char* p) { RAPIDJSON_SIMD_SCAN(SimdBlockAVX512, NonWhitespace, !IsJsonWhitespace) }
+RAPIDJSON_TARGET_AVX512 RAPIDJSON_SIMD_NO_SANITIZE inline const char* SkipWhitespaceAVX512(const char* p, const char* end) { RAPIDJSON_SIMD_SCAN_BOUNDED(SimdBlockAVX512, NonWhitespace, !IsJsonWhitespace) }
+RAPIDJSON_TARGET_AVX512 RAPIDJSON_SIMD_NO_SANITIZE inline const char* ScanUnescapedAVX512(const char* p) { RAPIDJSON_SIMD_SCAN(SimdBlockAVX512, Special, IsJsonStringSpecial) }
+RAPIDJSON_TARGET_AVX512 inline const char* ScanUnescapedAVX512(const char* p, const char* end) { RAPIDJSON_SIMD_SCAN_BOUNDED(SimdBlockAVX512, Special, IsJsonStringSpecial) }
+
+#undef RAPIDJSON_SIMD_SCAN
+#undef RAPIDJSON_SIMD_SCAN_BOUNDED
+
+inline const char* SkipWhitespaceScalar(const char* p) {
+    while (IsJsonWhitespace(*p))
+        ++p;
+    return p;
+}
+inline const char* SkipWhitespaceScalar(const char* p, const char* end) {
+    while (p != end && IsJsonWhitespace(*p))
+        ++p;
+    return p;
+}
+inline const char* ScanUnescapedScalar(const char* p) {
+    while (!IsJsonStringSpecial(*p))
+        ++p;
+    return p;
+}
+inline const char* ScanUnescapedScalar(const char* p, const char* end) {
+    while (p != end && !IsJsonStringSpecial(*p))
+        ++p;
+    return p;
+}
+
+//! One set of kernels per SimdLevel.
+struct SimdKernels {
+    SimdLevel level;
+    const char* (*skipWhitespace)(const char* p);                   //!< First non-whitespace of a null-terminated string.
+    const char* (*skipWhitespaceBounded)(const char* p, const char* end);
+    const char* (*scanUnescaped)(const char* p);                    //!< First '"', '\\' or control char of a null-terminated string.
+    const char* (*scanUnescapedBounded)(const char* p, const char* end);
+};
+
+inline const SimdKernels& GetSimdKernels(SimdLevel level) {
+    static const SimdKernels kernels[] = {
+        { kSimdScalar, &SkipWhitespaceScalar, &SkipWhitespaceScalar, &ScanUnescapedScalar, &ScanUnescapedScalar },
+        { kSimdSSE2, &SkipWhitespaceSSE2, &SkipWhitespaceSSE2, &ScanUnescapedSSE2, &ScanUnescapedSSE2 },
+        { kSimdAVX2, &SkipWhitespaceAVX2, &SkipWhitespaceAVX2, &ScanUnescapedAVX2, &ScanUnescapedAVX2 },
+        { kSimdAVX512, &SkipWhitespaceAVX512, &SkipWhitespaceAVX512, &ScanUnescapedAVX512, &ScanUnescapedAVX512 }
+    };
+    return kernels[level];
+}
+
+inline SimdLevel SupportedSimdLevel() {
+    static const SimdLevel supported = DetectSimdLevel();
+    return supported;
+}
+
+inline const SimdKernels*& ActiveSimdKernelsSlot() {
+    static const SimdKernels* active = &GetSimdKernels(SupportedSimdLevel());
+    return active;
+}
+
+inline const SimdKernels& ActiveSimdKernels() {
+    return *ActiveSimdKernelsSlot();
+}
+
+} // namespace internal
+
+//! Instruction set the reader currently uses.
+inline SimdLevel GetSimdLevel() {
+    return internal::ActiveSimdKernels().level;
+}
+
+//! Best instruction set this CPU supports.
+inline SimdLevel GetSupportedSimdLevel() {
+    return internal::SupportedSimdLevel();
+}
+
+//! Select the reader's kernels, e.g. to compare them; levels above the supported one are clamped.
+/*! Not synchronized: call it while no other thread is parsing.
+    \return The level now in effect.
+*/
+inline SimdLevel SetSimdLevel(SimdLevel level) {
+    if (level > internal::SupportedSimdLevel())
+        level = internal::SupportedSimdLevel();
+    internal::ActiveSimdKernelsSlot() = &internal::GetSimdKernels(level);
+    return level;
+}
+
+RAPIDJSON_NAMESPACE_END
+
+#endif // RAPIDJSON_SIMD_DISPATCH
+
+#endif // RAPIDJSON_INTERNAL_SIMD_H_
@@ -0,0 +1,761 @@
+// Tencent is pleased to support the open source community by making RapidJSON available.
+//
+// Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef RAPIDJSON_ONDEMAND_H_
+#define RAPIDJSON_ONDEMAND_H_
+
+/*! \file ondemand.h
+    On-demand (lazy) navigation over a JSON text, without building a DOM.
+
+    A GenericOnDemandDocument only remembers where the text is. Its values are small views
+    into the text with the read-only part of the GenericValue API: navigating to a member or
+    an element scans forward from the container's start, skipping the values in between with
+    a bracket-matching scan, and numbers and strings are converted only when read. A container
+    that was just iterated to its end is not scanned again when stepping past it.
+
+    \code
+    OnDemandDocument d;
+    OnDemandValue heroes = d.Parse(json, length);
+    for (OnDemandValue::ValueIterator h = heroes.Begin(); h != heroes.End(); ++h)
+        if ((*h)["id"].IsInt())
+            ids.push_back((*h)["id"].GetInt());
+    if (d.HasParseError())
+        ...
+    \endcode
+
+    Only what is read is checked: malformed JSON inside a skipped value is not reported, and
+    an error found while navigating makes the navigation end (an end iterator, or a value for
+    which IsValid() is false) and is kept by the document as its parse error.
+*/
+
+#include "document.h"
+#include "memorystream.h"
+#include <iterator>
+
+RAPIDJSON_NAMESPACE_BEGIN
+
+template <typename Encoding, typename Allocator>
+class GenericOnDemandDocument;
+
+template <typename Encoding, typename Allocator>
+class GenericOnDemandValue;
+
+namespace internal {
+
+//! Scanning primitives of the on-demand API: bounded, and never reading past end.
+struct OnDemandScanner {
+    static bool IsWhitespace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    static const char* SkipWhitespace(const char* p, const char* end) {
+        while (p != end && IsWhitespace(*p))
+            ++p;
+        return p;
+    }
+
+    //! First '"', '\\' or control char in [p, end).
+    static const char* ScanUnescaped(const char* p, const char* end) {
+#if RAPIDJSON_SIMD_DISPATCH
+        return ActiveSimdKernels().scanUnescapedBounded(p, end);
+#else
+        while (p != end && *p != '\"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20)
+            ++p;
+        return p;
+#endif
+    }
+
+    //! Past the closing quote of the string whose interior starts at p, or 0 if unterminated.
+    static const char* SkipString(const char* p, const char* end) {
+        for (;;) {
+            p = ScanUnescaped(p, end);
+            if (p == end)
+                return 0;
+            if (*p == '\"')
+                return p + 1;
+            if (*p == '\\' && ++p == end)
+                return 0;
+            ++p;
+        }
+    }
+
+    //! Past the value starting at p, or 0 if it is cut off.
+    /*! Containers are skipped by counting brackets outside of strings; neither their contents
+        nor whether '[' is closed by ']' rather than '}' are checked.
+    */
+    static const char* SkipValue(const char* p, const char* end) {
+        // 1 quote, 2 opening bracket, 3 closing bracket, 4 scalar delimiter (whitespace or ',')
+        static const unsigned char kClass[256] = {
+            0,0,0,0,0,0,0,0,0,4,4,0,0,4,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 00-1F
+            4,0,1,0,0,0,0,0,0,0,0,0,4,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 20-3F
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,2,0,3,0,0, // 40-5F
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,2,0,3,0,0, // 60-7F
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 80-9F
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // A0-BF
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // C0-DF
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0  // E0-FF
+        };
+        RAPIDJSON_ASSERT(p != end);
+        switch (kClass[static_cast<unsigned char>(*p)]) {
+        case 1:
+            return SkipString(p + 1, end);
+        case 2: {
+            size_t depth = 1;
+            for (++p;;) {
+                unsigned char c = 0;
+                while (p != end && ((c = kClass[static_cast<unsigned char>(*p)]) == 0 || c == 4))
+                    ++p;
+                if (p == end)
+                    return 0;
+                if (c == 1) {
+                    if (!(p = SkipString(p + 1, end)))
+                        return 0;
+                }
+                else if (c == 2) {
+                    ++depth;
+                    ++p;
+                }
+                else {
+                    ++p;
+                    if (--depth == 0)
+                        return p;
+                }
+            }
+        }
+        case 3:
+        case 4:
+            return 0;
+        default: {
+            // Numbers and literals run up to the next delimiter
+            const char* start = p;
+            while (p != end && kClass[static_cast<unsigned char>(*p)] == 0)
+                ++p;
+            return p != start ? p : 0;
+        }
+        }
+    }
+};
+
+//! Receives the single scalar the on-demand document asks its reader to convert.
+template <typename Encoding, typename Allocator>
+struct OnDemandScalarHandler : BaseReaderHandler<Encoding, OnDemandScalarHandler<Encoding, Allocator> > {
+    typedef typename Encoding::Ch Ch;
+
+    OnDemandScalarHandler(GenericValue<Encoding>& number, Allocator& allocator) : number_(number), allocator_(allocator), str_(0), length_(0) {}
+
+    bool Int(int i) { number_.SetInt(i); return true; }
+    bool Uint(unsigned u) { number_.SetUint(u); return true; }
+    bool Int64(int64_t i) { number_.SetInt64(i); return true; }
+    bool Uint64(uint64_t u) { number_.SetUint64(u); return true; }
+    bool Double(double d) { number_.SetDouble(d); return true; }
+    bool String(const Ch* str, SizeType length, bool) {
+        Ch* copy = static_cast<Ch*>(allocator_.Malloc((length + 1) * sizeof(Ch)));
+        std::memcpy(copy, str, length * sizeof(Ch));
+        copy[length] = '\0';
+        str_ = copy;
+        length_ = length;
+        return true;
+    }
+
+    GenericValue<Encoding>& number_;
+    Allocator& allocator_;
+    const Ch* str_;
+    SizeType length_;
+
+private:
+    OnDemandScalarHandler(const OnDemandScalarHandler&);
+    OnDemandScalarHandler& operator=(const OnDemandScalarHandler&);
+};
+
+} // namespace internal
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericOnDemandMember
+
+//! Name-value pair of an object read on demand.
+template <typename Encoding, typename Allocator>
+struct GenericOnDemandMember {
+    GenericOnDemandValue<Encoding, Allocator> name;     //!< name of member (must be a string)
+    GenericOnDemandValue<Encoding, Allocator> value;    //!< value of member.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericOnDemandMemberIterator, GenericOnDemandValueIterator
+
+//! Forward iterator over the members of an object read on demand.
+/*! Advancing skips the current member's value, whether or not it was read. */
+template <typename Encoding, typename Allocator>
+class GenericOnDemandMemberIterator {
+    friend class GenericOnDemandValue<Encoding, Allocator>;
+public:
+    typedef GenericOnDemandMember<Encoding, Allocator> value_type;
+    typedef const value_type& reference;
+    typedef const value_type* pointer;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::forward_iterator_tag iterator_category;
+
+    GenericOnDemandMemberIterator() : member_(), object_(0) {}
+
+    reference operator*() const { return member_; }
+    pointer operator->() const { return &member_; }
+
+    GenericOnDemandMemberIterator& operator++() { member_.value.NextMember(member_, object_); return *this; }
+    GenericOnDemandMemberIterator operator++(int) { GenericOnDemandMemberIterator old(*this); ++*this; return old; }
+
+    bool operator==(const GenericOnDemandMemberIterator& rhs) const { return member_.name.p_ == rhs.member_.name.p_; }
+    bool operator!=(const GenericOnDemandMemberIterator& rhs) const { return member_.name.p_ != rhs.member_.name.p_; }
+
+private:
+    value_type member_;
+    const typename Encoding::Ch* object_;      //!< '{' of the object
+};
+
+//! Forward iterator over the elements of an array read on demand.
+/*! Advancing skips the current element, whether or not it was read. */
+template <typename Encoding, typename Allocator>
+class GenericOnDemandValueIterator {
+    friend class GenericOnDemandValue<Encoding, Allocator>;
+public:
+    typedef GenericOnDemandValue<Encoding, Allocator> value_type;
+    typedef const value_type& reference;
+    typedef const value_type* pointer;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::forward_iterator_tag iterator_category;
+
+    GenericOnDemandValueIterator() : value_(), array_(0) {}
+
+    reference operator*() const { return value_; }
+    pointer operator->() const { return &value_; }
+
+    GenericOnDemandValueIterator& operator++() { value_.NextElement(array_); return *this; }
+    GenericOnDemandValueIterator operator++(int) { GenericOnDemandValueIterator old(*this); ++*this; return old; }
+
+    bool operator==(const GenericOnDemandValueIterator& rhs) const { return value_.p_ == rhs.value_.p_; }
+    bool operator!=(const GenericOnDemandValueIterator& rhs) const { return value_.p_ != rhs.value_.p_; }
+
+private:
+    value_type value_;
+    const typename Encoding::Ch* array_;       //!< '[' of the array
+};
+
+//! Iterator pair returned by GetArray() and GetObject(), for range-based for loops.
+template <typename Iterator>
+class GenericOnDemandRange {
+public:
+    GenericOnDemandRange(Iterator b, Iterator e) : begin_(b), end_(e) {}
+    Iterator begin() const { return begin_; }
+    Iterator end() const { return end_; }
+
+private:
+    Iterator begin_;
+    Iterator end_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericOnDemandValue
+
+//! A JSON value read on demand from the text of a GenericOnDemandDocument.
+/*! A value is a position in the text; copying it is cheap and it stays usable for as long as
+    the document and the text do. The queries mirror GenericValue, with these differences:
+    \li Navigation is sequential: FindMember(), operator[] and Size() scan the container from
+        its start on every call, so read the members of interest in one pass over MemberBegin()
+        when there are several.
+    \li operator[] returns an invalid value (IsValid() false, every IsXxx() false) for a missing
+        member or element instead of asserting.
+    \li GetString() of a string without escapes points into the text and is not null-terminated;
+        use GetStringLength(). Strings with escapes are decoded into the document's allocator.
+    \tparam Encoding    Encoding of the text; only 8-bit code units (UTF-8) are supported.
+    \tparam Allocator   Allocator for decoded strings.
+*/
+template <typename Encoding, typename Allocator = RAPIDJSON_DEFAULT_ALLOCATOR>
+class GenericOnDemandValue {
+    friend class GenericOnDemandDocument<Encoding, Allocator>;
+    friend class GenericOnDemandMemberIterator<Encoding, Allocator>;
+    friend class GenericOnDemandValueIterator<Encoding, Allocator>;
+public:
+    typedef typename Encoding::Ch Ch;
+    typedef GenericOnDemandDocument<Encoding, Allocator> DocumentType;
+    typedef GenericOnDemandMember<Encoding, Allocator> Member;
+    typedef GenericOnDemandMemberIterator<Encoding, Allocator> MemberIterator;
+    typedef GenericOnDemandValueIterator<Encoding, Allocator> ValueIterator;
+    typedef GenericOnDemandRange<ValueIterator> Array;
+    typedef GenericOnDemandRange<MemberIterator> Object;
+
+    RAPIDJSON_STATIC_ASSERT(sizeof(Ch) == 1);
+
+    //! Invalid value.
+    GenericOnDemandValue() : doc_(0), p_(0) {}
+
+    //! False for a missing member or element, or after an error.
+    bool IsValid() const { return p_ != 0; }
+
+    //!@name Type
+    //@{
+
+    Type GetType() const {
+        RAPIDJSON_ASSERT(IsValid());
+        switch (*p_) {
+        case '{': return kObjectType;
+        case '[': return kArrayType;
+        case '\"': return kStringType;
+        case 't': return kTrueType;
+        case 'f': return kFalseType;
+        case 'n': return kNullType;
+        default:
+            if (IsNumber())
+                return kNumberType;
+            doc_->SetError(kParseErrorValueInvalid, p_);
+            return kNullType;   // not a value; IsNull() is still false
+        }
+    }
+
+    bool IsNull()   const { return IsLiteral("null", 4); }
+    bool IsFalse()  const { return IsLiteral("false", 5); }
+    bool IsTrue()   const { return IsLiteral("true", 4); }
+    bool IsBool()   const { return IsTrue() || IsFalse(); }
+    bool IsObject() const { return p_ && *p_ == '{'; }
+    bool IsArray()  const { return p_ && *p_ == '['; }
+    bool IsString() const { return p_ && *p_ == '\"'; }
+    bool IsNumber() const { return p_ && (*p_ == '-' || (*p_ >= '0' && *p_ <= '9')); }
+
+    // Checking the kind of number converts it; the conversion is cached for the next Get.
+    bool IsInt()    const { return IsNumber() && GetNumber().IsInt(); }
+    bool IsUint()   const { return IsNumber() && GetNumber().IsUint(); }
+    bool IsInt64()  const { return IsNumber() && GetNumber().IsInt64(); }
+    bool IsUint64() const { return IsNumber() && GetNumber().IsUint64(); }
+    bool IsDouble() const { return IsNumber() && GetNumber().IsDouble(); }
+
+    //@}
+
+    //!@name Scalars
+    //@{
+
+    bool GetBool() const { RAPIDJSON_ASSERT(IsBool()); return *p_ == 't'; }
+
+    int GetInt() const          { return GetNumber().GetInt(); }
+    unsigned GetUint() const    { return GetNumber().GetUint(); }
+    int64_t GetInt64() const    { return GetNumber().GetInt64(); }
+    uint64_t GetUint64() const  { return GetNumber().GetUint64(); }
+    double GetDouble() const    { return GetNumber().GetDouble(); }
+    float GetFloat() const      { return GetNumber().GetFloat(); }
+
+    //! The number converted as the reader would, or 0 after an error.
+    const GenericValue<Encoding>& GetNumber() const {
+        RAPIDJSON_ASSERT(IsNumber());
+        return doc_->ConvertNumber(p_);
+    }
+
+    //! Characters of the string; not null-terminated unless it had escapes.
+    const Ch* GetString() const {
+        RAPIDJSON_ASSERT(IsString());
+        return doc_->ConvertString(p_).s;
+    }
+
+    SizeType GetStringLength() const {
+        RAPIDJSON_ASSERT(IsString());
+        return doc_->ConvertString(p_).length;
+    }
+
+    GenericStringRef<Ch> GetStringRef() const {
+        RAPIDJSON_ASSERT(IsString());
+        return doc_->ConvertString(p_);
+    }
+
+    //! The JSON text of this value, e.g. to parse it into a GenericDocument. Length 0 on error.
+    GenericStringRef<Ch> GetRawJson() const {
+        RAPIDJSON_ASSERT(IsValid());
+        const Ch* end = doc_->Skip(p_);
+        return end ? GenericStringRef<Ch>(p_, static_cast<SizeType>(end - p_)) : GenericStringRef<Ch>(p_, 0);
+    }
+
+    //@}
+
+    //!@name Object
+    //@{
+
+    MemberIterator MemberBegin() const {
+        RAPIDJSON_ASSERT(IsObject());
+        MemberIterator it;
+        it.object_ = p_;
+        const Ch* p = doc_->SkipWhitespace(p_ + 1);
+        if (p != doc_->end_ && *p == '}')
+            doc_->EndContainer(p_, p + 1);
+        else
+            SeekMember(p, it.member_);
+        return it;
+    }
+
+    MemberIterator MemberEnd() const { RAPIDJSON_ASSERT(IsObject()); return MemberIterator(); }
+    Object GetObject() const { return Object(MemberBegin(), MemberEnd()); }
+
+    bool ObjectEmpty() const { return MemberBegin() == MemberEnd(); }
+
+    SizeType MemberCount() const {
+        SizeType count = 0;
+        for (MemberIterator it = MemberBegin(); it != MemberEnd(); ++it)
+            ++count;
+        return count;
+    }
+
+    //! First member with the given name, scanning from the start of the object.
+    MemberIterator FindMember(const Ch* name, SizeType length) const {
+        MemberIterator it = MemberBegin();
+        for (; it != MemberEnd(); ++it) {
+            const GenericStringRef<Ch> s = it->name.GetStringRef();
+            if (s.length == length && (length == 0 || std::memcmp(s.s, name, length * sizeof(Ch)) == 0))
+                break;
+        }
+        return it;
+    }
+
+    MemberIterator FindMember(const Ch* name) const { return FindMember(name, internal::StrLen(name)); }
+
+    template <typename SourceAllocator>
+    MemberIterator FindMember(const GenericValue<Encoding, SourceAllocator>& name) const { return FindMember(name.GetString(), name.GetStringLength()); }
+
+#if RAPIDJSON_HAS_STDSTRING
+    MemberIterator FindMember(const std::basic_string<Ch>& name) const { return FindMember(name.data(), static_cast<SizeType>(name.size())); }
+#endif
+
+    bool HasMember(const Ch* name) const { return FindMember(name) != MemberEnd(); }
+
+    //! Value of the first member with the given name, invalid if there is none.
+    template <typename T>
+    RAPIDJSON_DISABLEIF_RETURN((internal::NotExpr<internal::IsSame<typename internal::RemoveConst<T>::Type, Ch> >),(GenericOnDemandValue)) operator[](T* name) const {
+        MemberIterator it = FindMember(name);
+        return it != MemberEnd() ? it->value : GenericOnDemandValue();
+    }
+
+    template <typename SourceAllocator>
+    GenericOnDemandValue operator[](const GenericValue<Encoding, SourceAllocator>& name) const {
+        MemberIterator it = FindMember(name);
+        return it != MemberEnd() ? it->value : GenericOnDemandValue();
+    }
+
+#if RAPIDJSON_HAS_STDSTRING
+    GenericOnDemandValue operator[](const std::basic_string<Ch>& name) const {
+        MemberIterator it = FindMember(name);
+        return it != MemberEnd() ? it->value : GenericOnDemandValue();
+    }
+#endif
+
+    //@}
+
+    //!@name Array
+    //@{
+
+    ValueIterator Begin() const {
+        RAPIDJSON_ASSERT(IsArray());
+        ValueIterator it;
+        it.array_ = p_;
+        const Ch* p = doc_->SkipWhitespace(p_ + 1);
+        if (p == doc_->end_)
+            doc_->SetError(kParseErrorArrayMissCommaOrSquareBracket, p);
+        else if (*p == ']')
+            doc_->EndContainer(p_, p + 1);
+        else {
+            it.value_.doc_ = doc_;
+            it.value_.p_ = p;
+        }
+        return it;
+    }
+
+    ValueIterator End() const { RAPIDJSON_ASSERT(IsArray()); return ValueIterator(); }
+    Array GetArray() const { return Array(Begin(), End()); }
+
+    bool Empty() const { return Begin() == End(); }
+
+    SizeType Size() const {
+        SizeType count = 0;
+        for (ValueIterator it = Begin(); it != End(); ++it)
+            ++count;
+        return count;
+    }
+
+    //! Element at index, scanning from the start of the array; invalid if out of range.
+    GenericOnDemandValue operator[](SizeType index) const {
+        ValueIterator it = Begin();
+        for (; index > 0 && it != End(); --index)
+            ++it;
+        return *it;
+    }
+
+    //@}
+
+private:
+    GenericOnDemandValue(const DocumentType* doc, const Ch* p) : doc_(doc), p_(p) {}
+
+    bool IsLiteral(const char* literal, size_t length) const {
+        return p_ && *p_ == literal[0] && static_cast<size_t>(doc_->end_ - p_) >= length && std::memcmp(p_, literal, length) == 0;
+    }
+
+    //! Sets member from the name starting at p; leaves it at the end on error.
+    void SeekMember(const Ch* p, Member& member) const {
+        const DocumentType* doc = doc_;
+        member = Member();
+        if (p == doc->end_ || *p != '\"') {
+            doc->SetError(kParseErrorObjectMissName, p);
+            return;
+        }
+        const Ch* colon = internal::OnDemandScanner::SkipString(p + 1, doc->end_);
+        if (!colon) {
+            doc->SetError(kParseErrorStringMissQuotationMark, doc->end_);
+            return;
+        }
+        colon = doc->SkipWhitespace(colon);
+        if (colon == doc->end_ || *colon != ':') {
+            doc->SetError(kParseErrorObjectMissColon, colon);
+            return;
+        }
+        const Ch* value = doc->SkipWhitespace(colon + 1);
+        if (value == doc->end_) {
+            doc->SetError(kParseErrorValueInvalid, value);
+            return;
+        }
+        member.name = GenericOnDemandValue(doc, p);
+        member.value = GenericOnDemandValue(doc, value);
+    }
+
+    //! Moves member (whose value is this) to the next member of object.
+    void NextMember(Member& member, const Ch* object) const {
+        const DocumentType* doc = doc_;
+        const Ch* p = doc->Skip(p_);
+        if (!p) {
+            member = Member();
+            return;
+        }
+        p = doc->SkipWhitespace(p);
+        if (p != doc->end_ && *p == ',')
+            SeekMember(doc->SkipWhitespace(p + 1), member);
+        else {
+            if (p == doc->end_ || *p != '}')
+                doc->SetError(kParseErrorObjectMissCommaOrCurlyBracket, p);
+            else
+                doc->EndContainer(object, p + 1);
+            member = Member();
+        }
+    }
+
+    //! Moves this element to the next one of array.
+    void NextElement(const Ch* array) {
+        const DocumentType* doc = doc_;
+        const Ch* p = doc->Skip(p_);
+        p_ = 0;
+        if (!p)
+            return;
+        p = doc->SkipWhitespace(p);
+        if (p != doc->end_ && *p == ',') {
+            p = doc->SkipWhitespace(p + 1);
+            if (p == doc->end_ || *p == ']')
+                doc->SetError(kParseErrorValueInvalid, p);
+            else
+                p_ = p;
+        }
+        else if (p == doc->end_ || *p != ']')
+            doc->SetError(kParseErrorArrayMissCommaOrSquareBracket, p);
+        else
+            doc->EndContainer(array, p + 1);
+    }
+
+    const DocumentType* doc_;
+    const Ch* p_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericOnDemandDocument
+
+//! Owner of the state shared by the values read on demand from one JSON text.
+/*! The text is not copied and must outlive the document's values. Conversions go through a
+    GenericReader with the default parse flags, so numbers and strings read here equal those of
+    a GenericDocument parsed from the same text. Values are not thread-safe: they share the
+    document's conversion caches and error.
+    \tparam Encoding    Encoding of the text; only 8-bit code units (UTF-8) are supported.
+    \tparam Allocator   Allocator for decoded strings.
+*/
+template <typename Encoding, typename Allocator = RAPIDJSON_DEFAULT_ALLOCATOR>
+class GenericOnDemandDocument {
+    friend class GenericOnDemandValue<Encoding, Allocator>;
+public:
+    typedef typename Encoding::Ch Ch;
+    typedef GenericOnDemandValue<Encoding, Allocator> ValueType;
+    typedef Allocator AllocatorType;
+
+    //! Constructor
+    /*! \param allocator Optional allocator for decoded strings; the document creates its own if 0.
+    */
+    explicit GenericOnDemandDocument(Allocator* allocator = 0) :
+        allocator_(allocator), ownAllocator_(0), begin_(0), end_(0), parseResult_(),
+        numberSource_(0), number_(), stringSource_(0), string_(0), stringLength_(0),
+        containerSource_(0), containerEnd_(0), reader_()
+    {
+        if (!allocator_)
+            ownAllocator_ = allocator_ = RAPIDJSON_NEW(Allocator)();
+    }
+
+    ~GenericOnDemandDocument() {
+        RAPIDJSON_DELETE(ownAllocator_);
+    }
+
+    //! Start reading json; only the first character of its root value is looked at.
+    /*! \return The root value, invalid if the text is empty.
+    */
+    ValueType Parse(const Ch* json, size_t length) {
+        begin_ = json;
+        end_ = json + length;
+        parseResult_.Clear();
+        numberSource_ = stringSource_ = containerSource_ = 0;
+        const Ch* p = SkipWhitespace(json);
+        if (p == end_) {
+            SetError(kParseErrorDocumentEmpty, p);
+            return ValueType();
+        }
+        return ValueType(this, p);
+    }
+
+    //! Start reading a null-terminated json.
+    ValueType Parse(const Ch* json) { return Parse(json, internal::StrLen(json)); }
+
+    //! Root value of the last Parse(), invalid if there is none.
+    ValueType GetRoot() const {
+        const Ch* p = begin_ ? SkipWhitespace(begin_) : 0;
+        return p && p != end_ ? ValueType(this, p) : ValueType();
+    }
+
+    //! Whether reading the values so far met an error.
+    bool HasParseError() const { return parseResult_.IsError(); }
+
+    //! Get the \ref ParseErrorCode of the first error.
+    ParseErrorCode GetParseError() const { return parseResult_.Code(); }
+
+    //! Get the position of the first error in the text.
+    size_t GetErrorOffset() const { return parseResult_.Offset(); }
+
+    //! Allocator of the decoded strings.
+    Allocator& GetAllocator() { RAPIDJSON_ASSERT(allocator_); return *allocator_; }
+
+private:
+    GenericOnDemandDocument(const GenericOnDemandDocument&);
+    GenericOnDemandDocument& operator=(const GenericOnDemandDocument&);
+
+    typedef GenericReader<Encoding, Encoding, CrtAllocator> ReaderType;
+    typedef internal::OnDemandScalarHandler<Encoding, Allocator> HandlerType;
+
+    void SetError(ParseErrorCode code, const Ch* at) const {
+        if (!parseResult_.IsError())
+            parseResult_.Set(code, static_cast<size_t>(at - begin_));
+    }
+
+    const Ch* SkipWhitespace(const Ch* p) const {
+        return internal::OnDemandScanner::SkipWhitespace(p, end_);
+    }
+
+    //! Remember where a container that was iterated to its end stops.
+    void EndContainer(const Ch* container, const Ch* end) const {
+        containerSource_ = container;
+        containerEnd_ = end;
+    }
+
+    //! Past the value at p, or 0 after recording an error.
+    const Ch* Skip(const Ch* p) const {
+        if (p == containerSource_)
+            return containerEnd_;
+        const Ch* end = internal::OnDemandScanner::SkipValue(p, end_);
+        if (!end)
+            SetError(*p == '\"' ? kParseErrorStringMissQuotationMark : kParseErrorValueInvalid, p);
+        return end;
+    }
+
+    //! Run the reader over the single value at p.
+    bool Convert(const Ch* p, HandlerType& handler) const {
+        MemoryStream is(p, static_cast<size_t>(end_ - p));
+        if (reader_.template Parse<kParseStopWhenDoneFlag>(is, handler).IsError()) {
+            SetError(reader_.GetParseErrorCode(), p + reader_.GetErrorOffset());
+            return false;
+        }
+        return true;
+    }
+
+    const GenericValue<Encoding>& ConvertNumber(const Ch* p) const {
+        if (p == numberSource_)
+            return number_;
+        numberSource_ = p;
+
+        // Fast path for the common short integer; anything else goes through the reader
+        const Ch* q = p + (*p == '-');
+        unsigned u = 0;
+        const Ch* digitsEnd = q + 9 < end_ ? q + 9 : end_;
+        const Ch* d = q;
+        for (; d != digitsEnd && *d >= '0' && *d <= '9'; ++d)
+            u = u * 10 + static_cast<unsigned>(*d - '0');
+        if (d != q && (d == end_ || (*d != '.' && *d != 'e' && *d != 'E' && (*d < '0' || *d > '9'))) && !(*q == '0' && d - q > 1)) {
+            if (q != p)
+                number_.SetInt(-static_cast<int>(u));
+            else
+                number_.SetUint(u);
+            return number_;
+        }
+
+        HandlerType handler(number_, *allocator_);
+        if (!Convert(p, handler))
+            number_.SetInt(0);
+        return number_;
+    }
+
+    GenericStringRef<Ch> ConvertString(const Ch* p) const {
+        if (p != stringSource_) {
+            stringSource_ = p;
+            const Ch* q = internal::OnDemandScanner::ScanUnescaped(p + 1, end_);
+            if (q != end_ && *q == '\"') {
+                string_ = p + 1;
+                stringLength_ = static_cast<SizeType>(q - (p + 1));
+            }
+            else {
+                GenericValue<Encoding> unused;
+                HandlerType handler(unused, *allocator_);
+                bool ok = Convert(p, handler);
+                string_ = ok ? handler.str_ : p;
+                stringLength_ = ok ? handler.length_ : 0;
+            }
+        }
+        return GenericStringRef<Ch>(string_, stringLength_);
+    }
+
+    Allocator* allocator_;
+    Allocator* ownAllocator_;
+    const Ch* begin_;
+    const Ch* end_;
+    mutable ParseResult parseResult_;
+
+    // Last conversions, so that IsInt() followed by GetInt() or GetString() followed by
+    // GetStringLength() read the text once, and the last container iterated to its end, so
+    // that stepping past it after reading it does not scan it again.
+    mutable const Ch* numberSource_;
+    mutable GenericValue<Encoding> number_;
+    mutable const Ch* stringSource_;
+    mutable const Ch* string_;
+    mutable SizeType stringLength_;
+    mutable const Ch* containerSource_;
+    mutable const Ch* containerEnd_;
+    mutable ReaderType reader_;
+};
+
+//! GenericOnDemandDocument with UTF8 encoding
+typedef GenericOnDemandDocument<UTF8<> > OnDemandDocument;
+
+//! GenericOnDemandValue with UTF8 encoding
+typedef GenericOnDemandValue<UTF8<> > OnDemandValue;
+
+RAPIDJSON_NAMESPACE_END
+
+#endif // RAPIDJSON_ONDEMAND_H_
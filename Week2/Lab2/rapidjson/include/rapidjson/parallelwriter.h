@@ -0,0 +1,251 @@
+// Tencent is pleased to support the open source community by making RapidJSON available.
+//
+// Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef RAPIDJSON_PARALLELWRITER_H_
+#define RAPIDJSON_PARALLELWRITER_H_
+
+/*! \file parallelwriter.h
+    Serialization of large arrays and objects on several threads.
+
+    The elements (or members) of the container are split into contiguous ranges. Each range
+    is rendered by its own writer of the same kind and settings as the target (Writer or
+    PrettyWriter) into a GenericStringBuffer, nested as deep as the target so that separators
+    and indentation come out the same, and the buffers are then appended to the target in
+    order with Writer::RawValues(). The output is byte for byte what the target would have
+    written by itself.
+
+    \code
+    Writer<StringBuffer> writer(buffer);
+    WriteArrayParallel(writer, heroes.size(), [&](Writer<StringBuffer>& w, size_t i) { return heroes[i].Serialize(w); });
+    \endcode
+
+    The rendered ranges are kept in memory until they are appended, so the output is briefly
+    held twice. Requires C++11.
+*/
+
+#include "document.h"
+#include "prettywriter.h"
+
+#if RAPIDJSON_HAS_CXX11
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+//! Smallest number of elements (or members) rendered by one thread.
+/*! Containers with fewer than two such ranges are written on the calling thread.
+*/
+#ifndef RAPIDJSON_PARALLEL_WRITER_MIN_RANGE
+#define RAPIDJSON_PARALLEL_WRITER_MIN_RANGE 1024
+#endif
+
+RAPIDJSON_NAMESPACE_BEGIN
+
+namespace internal {
+
+//! Writer of the same kind as \c WriterType, writing into a string buffer.
+template <typename WriterType>
+struct RangeWriter;
+
+template <typename OutputStream, typename SourceEncoding, typename TargetEncoding, typename StackAllocator, unsigned writeFlags>
+struct RangeWriter<Writer<OutputStream, SourceEncoding, TargetEncoding, StackAllocator, writeFlags> > {
+    typedef GenericStringBuffer<TargetEncoding> Buffer;
+    typedef Writer<Buffer, SourceEncoding, TargetEncoding, StackAllocator, writeFlags> Type;
+
+    static void CopySettings(Type& to, const Writer<OutputStream, SourceEncoding, TargetEncoding, StackAllocator, writeFlags>& from) {
+        to.SetMaxDecimalPlaces(from.GetMaxDecimalPlaces());
+    }
+};
+
+template <typename OutputStream, typename SourceEncoding, typename TargetEncoding, typename StackAllocator, unsigned writeFlags>
+struct RangeWriter<PrettyWriter<OutputStream, SourceEncoding, TargetEncoding, StackAllocator, writeFlags> > {
+    typedef GenericStringBuffer<TargetEncoding> Buffer;
+    typedef PrettyWriter<Buffer, SourceEncoding, TargetEncoding, StackAllocator, writeFlags> Type;
+
+    static void CopySettings(Type& to, const PrettyWriter<OutputStream, SourceEncoding, TargetEncoding, StackAllocator, writeFlags>& from) {
+        to.SetMaxDecimalPlaces(from.GetMaxDecimalPlaces());
+        to.SetIndent(from.GetIndentChar(), from.GetIndentCharCount());
+        to.SetFormatOptions(from.GetFormatOptions());
+    }
+};
+
+template <typename WriterType, typename Produce>
+bool WriteContainerParallel(WriterType& writer, bool isArray, size_t count, Produce& produce, unsigned threadCount) {
+    typedef RangeWriter<WriterType> Range;
+    typedef typename Range::Buffer Buffer;
+    typedef typename Range::Type RangeWriterType;
+
+    if (!(isArray ? writer.StartArray() : writer.StartObject()))
+        return false;
+
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    const size_t minRange = RAPIDJSON_PARALLEL_WRITER_MIN_RANGE;
+    if (threadCount > count / minRange)
+        threadCount = static_cast<unsigned>(count / minRange);
+
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < count; i++)
+            if (!produce(writer, i))
+                return false;
+    }
+    else {
+        // A few ranges per thread, handed out in order, so that uneven elements balance out.
+        size_t rangeCount = threadCount * 4u;
+        if (rangeCount > count / minRange)
+            rangeCount = count / minRange;
+        const size_t depth = writer.GetNestingLevel();
+
+        std::vector<Buffer> buffers(rangeCount);
+        std::vector<size_t> starts(rangeCount);
+        std::atomic<size_t> next(0);
+        std::atomic<bool> failed(false);
+
+        auto work = [&]() {
+            for (size_t r; !failed.load(std::memory_order_relaxed) && (r = next.fetch_add(1)) < rangeCount; ) {
+                RangeWriterType w(buffers[r]);
+                Range::CopySettings(w, writer);
+                for (size_t i = 1; i < depth; i++)
+                    w.StartArray();
+                if (isArray)
+                    w.StartArray();
+                else
+                    w.StartObject();
+                if (r != 0) { // so that the range starts with the separator between values
+                    if (!isArray)
+                        w.Key("", 0);
+                    w.Null();
+                }
+                starts[r] = buffers[r].GetLength();
+
+                for (size_t i = count * r / rangeCount, end = count * (r + 1) / rangeCount; i < end; i++) {
+                    if (!produce(w, i)) {
+                        failed = true;
+                        break;
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (unsigned t = 1; t < threadCount; t++)
+            threads.emplace_back(work);
+        work();
+        for (size_t t = 0; t < threads.size(); t++)
+            threads[t].join();
+
+        if (failed)
+            return false;
+        for (size_t r = 0; r < rangeCount; r++) {
+            const size_t values = count * (r + 1) / rangeCount - count * r / rangeCount;
+            writer.RawValues(buffers[r].GetString() + starts[r], buffers[r].GetLength() - starts[r], isArray ? values : values * 2);
+            buffers[r].Clear();
+            buffers[r].ShrinkToFit();
+        }
+    }
+
+    return isArray ? writer.EndArray(static_cast<SizeType>(count)) : writer.EndObject(static_cast<SizeType>(count));
+}
+
+template <typename ValueType>
+struct ParallelElementWriter {
+    explicit ParallelElementWriter(const ValueType& a) : array(a) {}
+    template <typename Handler>
+    bool operator()(Handler& handler, size_t i) const { return array[static_cast<SizeType>(i)].Accept(handler); }
+    const ValueType& array;
+};
+
+template <typename ValueType>
+struct ParallelMemberWriter {
+    explicit ParallelMemberWriter(const ValueType& o) : object(o) {}
+    template <typename Handler>
+    bool operator()(Handler& handler, size_t i) const {
+        typename ValueType::ConstMemberIterator m = object.MemberBegin() + static_cast<SizeType>(i);
+        return handler.Key(m->name.GetString(), m->name.GetStringLength()) && m->value.Accept(handler);
+    }
+    const ValueType& object;
+};
+
+} // namespace internal
+
+//! Write an array of \c count elements, rendering ranges of them on several threads.
+/*!
+    \param writer Target Writer or PrettyWriter. The array is written as its next value.
+    \param count Number of elements.
+    \param produce Called as <tt>produce(w, i)</tt> to write element \c i with \c w, returning
+        false to stop. It runs concurrently on several threads, in no particular order, and is
+        given either \c writer itself (when the array is written on the calling thread) or a
+        writer of the same kind over a GenericStringBuffer, so a generic callable fits best.
+    \param threadCount Number of threads, including the calling one. 0 for one per hardware thread.
+    \return false if \c writer or \c produce failed.
+*/
+template <typename WriterType, typename Produce>
+bool WriteArrayParallel(WriterType& writer, size_t count, Produce produce, unsigned threadCount = 0) {
+    return internal::WriteContainerParallel(writer, true, count, produce, threadCount);
+}
+
+//! Write an object of \c memberCount members, rendering ranges of them on several threads.
+/*!
+    Same as WriteArrayParallel(), except that <tt>produce(w, i)</tt> writes member \c i:
+    its name with \c Key() and then its value.
+*/
+template <typename WriterType, typename Produce>
+bool WriteObjectParallel(WriterType& writer, size_t memberCount, Produce produce, unsigned threadCount = 0) {
+    return internal::WriteContainerParallel(writer, false, memberCount, produce, threadCount);
+}
+
+//! Write a DOM value like GenericValue::Accept(), rendering its large arrays and objects on several threads.
+/*!
+    Containers with enough elements or members for two threads (see
+    RAPIDJSON_PARALLEL_WRITER_MIN_RANGE) are split across threads; smaller ones are walked
+    into, so that a large array nested in a small object is still split. Values inside a
+    split container are written with Accept().
+*/
+template <typename WriterType, typename Encoding, typename Allocator>
+bool AcceptParallel(const GenericValue<Encoding, Allocator>& value, WriterType& writer, unsigned threadCount = 0) {
+    typedef GenericValue<Encoding, Allocator> ValueType;
+    const size_t minParallel = 2 * static_cast<size_t>(RAPIDJSON_PARALLEL_WRITER_MIN_RANGE);
+
+    if (value.IsArray()) {
+        if (value.Size() >= minParallel)
+            return WriteArrayParallel(writer, value.Size(), internal::ParallelElementWriter<ValueType>(value), threadCount);
+        if (RAPIDJSON_UNLIKELY(!writer.StartArray()))
+            return false;
+        for (typename ValueType::ConstValueIterator v = value.Begin(); v != value.End(); ++v)
+            if (RAPIDJSON_UNLIKELY(!AcceptParallel(*v, writer, threadCount)))
+                return false;
+        return writer.EndArray(value.Size());
+    }
+    if (value.IsObject()) {
+        if (value.MemberCount() >= minParallel)
+            return WriteObjectParallel(writer, value.MemberCount(), internal::ParallelMemberWriter<ValueType>(value), threadCount);
+        if (RAPIDJSON_UNLIKELY(!writer.StartObject()))
+            return false;
+        for (typename ValueType::ConstMemberIterator m = value.MemberBegin(); m != value.MemberEnd(); ++m) {
+            if (RAPIDJSON_UNLIKELY(!writer.Key(m->name.GetString(), m->name.GetStringLength())))
+                return false;
+            if (RAPIDJSON_UNLIKELY(!AcceptParallel(m->value, writer, threadCount)))
+                return false;
+        }
+        return writer.EndObject(value.MemberCount());
+    }
+    return value.Accept(writer);
+}
+
+RAPIDJSON_NAMESPACE_END
+
+#endif // RAPIDJSON_HAS_CXX11
+
+#endif // RAPIDJSON_PARALLELWRITER_H_
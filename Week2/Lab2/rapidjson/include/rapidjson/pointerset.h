@@ -0,0 +1,495 @@
+// Tencent is pleased to support the open source community by making RapidJSON available.
+//
+// Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef RAPIDJSON_POINTERSET_H_
+#define RAPIDJSON_POINTERSET_H_
+
+/*! \file pointerset.h
+    Resolution of many JSON pointers at once.
+
+    GenericPointer::Get() walks the document from the root for every pointer, so pointers
+    that share a prefix walk it again and again. GenericPointerSet compiles its pointers into
+    a trie of tokens and resolves all of them in one traversal, either of a DOM or of a JSON
+    text through SAX events, without building a DOM.
+
+    \code
+    PointerSet set;
+    size_t name = set.Add(Pointer("/name"));
+    size_t strength = set.Add(Pointer("/powerstats/strength"));
+    const Value* values[2];
+    set.Get(hero, values);
+    \endcode
+*/
+
+#include "pointer.h"
+#include "reader.h"
+#include "memorystream.h"
+#include "encodedstream.h"
+#include "internal/stack.h"
+
+RAPIDJSON_NAMESPACE_BEGIN
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericPointerSet
+
+//! A set of JSON pointers resolved together. Use PointerSet for UTF8 encoding and default allocator.
+/*!
+    Pointers are added once with Add(), which shares their common prefixes in a trie, and the
+    set then resolves all of them against any number of documents.
+
+    Get() resolves against a DOM, visiting each trie node once. For every token naming an
+    object member it remembers the position the member was found at, and tries that position
+    first the next time, so documents of the same shape resolve without member searches. This
+    differs from GenericPointer::Get() only for objects with duplicate member names: if the
+    remembered position holds a later duplicate, Get() resolves to it instead of to the first.
+
+    ParseStream() and Parse() resolve against a JSON text, following the trie along the SAX
+    events and building only the values the pointers resolve to. Like GenericPointer::Get(),
+    they resolve to the first of duplicate members. They stop reading as soon as every pointer
+    is resolved.
+
+    Because of the remembered positions and the buffers Parse() reuses, a set must not be used
+    by several threads at once.
+
+    \tparam ValueType The value type of the DOM tree. E.g. GenericValue<UTF8<> >
+    \tparam Allocator The allocator type for allocating memory for the trie.
+*/
+template <typename ValueType, typename Allocator = CrtAllocator>
+class GenericPointerSet {
+public:
+    typedef typename ValueType::EncodingType EncodingType;  //!< Encoding type from Value
+    typedef typename ValueType::Ch Ch;                      //!< Character type from Value
+    typedef GenericPointer<ValueType, Allocator> PointerType;
+
+    //! Constructor.
+    /*! \param allocator The allocator for the trie, or 0 for one of its own.
+    */
+    explicit GenericPointerSet(Allocator* allocator = 0) :
+        nodes_(allocator, kDefaultNodeCapacity * sizeof(Node)), names_(allocator, kDefaultNameCapacity * sizeof(Ch)),
+        frames_(allocator, kDefaultFrameCapacity * sizeof(Frame)), building_(allocator, kDefaultFrameCapacity * sizeof(ValueType*)),
+        entered_(allocator, kDefaultNodeCapacity * sizeof(bool)), reader_(allocator), pointerCount_()
+    {
+        Node* root = nodes_.template Push<Node>();
+        root->nameOffset = 0;
+        root->nameLength = 0;
+        root->index = kPointerInvalidIndex;
+        root->firstChild = root->nextSibling = kNoNode;
+        root->target = kNoNode;
+        root->memberHint = 0;
+    }
+
+    //! Adds a pointer.
+    /*! \param pointer A valid pointer.
+        \return The index of the pointer in the results of Get() and ParseStream(). A pointer equal to
+            one already in the set gets the index of that one.
+    */
+    size_t Add(const PointerType& pointer) {
+        RAPIDJSON_ASSERT(pointer.IsValid());
+        SizeType n = 0;
+        for (const typename PointerType::Token* t = pointer.GetTokens(); t != pointer.GetTokens() + pointer.GetTokenCount(); ++t) {
+            SizeType child = FindChild(n, t->name, t->length);
+            if (child == kNoNode)
+                child = AddChild(n, *t);
+            n = child;
+        }
+        Node& node = nodes_.template Bottom<Node>()[n];
+        if (node.target == kNoNode)
+            node.target = static_cast<SizeType>(pointerCount_++);
+        return node.target;
+    }
+
+    //! Number of distinct pointers in the set.
+    size_t Size() const { return pointerCount_; }
+
+    //! Resolves every pointer against a DOM.
+    /*! \param root Root value of a DOM sub-tree to be resolved. It can be any value other than document root.
+        \param values Array of Size() results: values[i] is set to what pointer i resolves to, or to 0.
+        \return Number of pointers resolved.
+        \note A member name repeated in an object may resolve to a later duplicate than the first,
+            which GenericPointer::Get() resolves to, when an earlier call found the member there.
+    */
+    size_t Get(ValueType& root, ValueType** values) const {
+        for (size_t i = 0; i < pointerCount_; i++)
+            values[i] = 0;
+        return Resolve(0, root, values);
+    }
+
+    //! Resolves every pointer against a DOM.
+    /*! \see Get(ValueType&, ValueType**) const
+    */
+    size_t Get(const ValueType& root, const ValueType** values) const {
+        return Get(const_cast<ValueType&>(root), const_cast<ValueType**>(values));
+    }
+
+    //! Resolves every pointer against a JSON text, without building a DOM.
+    /*! \tparam parseFlags Combination of \ref ParseFlag.
+        \param is Input stream.
+        \param values Array of Size() values: values[i] is set to a copy of what pointer i resolves to, or to null.
+        \param resolved Array of Size() flags: resolved[i] is set to whether pointer i resolved.
+        \param allocator Allocator for the values.
+        \return The parse result. Once every pointer is resolved the rest of the text is not read,
+            and errors in it are not reported.
+    */
+    template <unsigned parseFlags, typename InputStream>
+    ParseResult ParseStream(InputStream& is, ValueType* values, bool* resolved, typename ValueType::AllocatorType& allocator) const {
+        Resolver resolver(*this, values, resolved, allocator);
+        ParseResult result = reader_.template Parse<parseFlags>(is, resolver);
+        if (result.Code() == kParseErrorTermination && resolver.Done())
+            return ParseResult();
+        return result;
+    }
+
+    //! Resolves every pointer against a JSON text, with default parse flags.
+    template <typename InputStream>
+    ParseResult ParseStream(InputStream& is, ValueType* values, bool* resolved, typename ValueType::AllocatorType& allocator) const {
+        return ParseStream<kParseDefaultFlags>(is, values, resolved, allocator);
+    }
+
+    //! Resolves every pointer against a null-terminated JSON string, without building a DOM.
+    template <unsigned parseFlags>
+    ParseResult Parse(const Ch* str, ValueType* values, bool* resolved, typename ValueType::AllocatorType& allocator) const {
+        GenericStringStream<EncodingType> s(str);
+        return ParseStream<parseFlags>(s, values, resolved, allocator);
+    }
+
+    //! Resolves every pointer against a null-terminated JSON string, with default parse flags.
+    ParseResult Parse(const Ch* str, ValueType* values, bool* resolved, typename ValueType::AllocatorType& allocator) const {
+        return Parse<kParseDefaultFlags>(str, values, resolved, allocator);
+    }
+
+    //! Resolves every pointer against a JSON string of known length, without building a DOM.
+    template <unsigned parseFlags>
+    ParseResult Parse(const Ch* str, size_t length, ValueType* values, bool* resolved, typename ValueType::AllocatorType& allocator) const {
+        MemoryStream ms(reinterpret_cast<const char*>(str), length * sizeof(Ch));
+        EncodedInputStream<EncodingType, MemoryStream> is(ms);
+        return ParseStream<parseFlags>(is, values, resolved, allocator);
+    }
+
+    //! Resolves every pointer against a JSON string of known length, with default parse flags.
+    ParseResult Parse(const Ch* str, size_t length, ValueType* values, bool* resolved, typename ValueType::AllocatorType& allocator) const {
+        return Parse<kParseDefaultFlags>(str, length, values, resolved, allocator);
+    }
+
+private:
+    static const SizeType kNoNode = ~SizeType(0);
+    static const size_t kDefaultNodeCapacity = 16;
+    static const size_t kDefaultNameCapacity = 256;
+    static const size_t kDefaultFrameCapacity = 16;
+
+    //! A token of one or more pointers. Node 0 is the root, the empty pointer.
+    struct Node {
+        size_t nameOffset;      //!< Token name in names_.
+        SizeType nameLength;
+        SizeType index;         //!< A valid array index, if it is not equal to kPointerInvalidIndex.
+        SizeType firstChild;
+        SizeType nextSibling;
+        SizeType target;        //!< Index of the pointer ending here, or kNoNode.
+        mutable SizeType memberHint;    //!< Position of the member found last time, tried first by Get().
+    };
+
+    //! A container on the path from the root that Parse() follows down the trie.
+    struct Frame {
+        SizeType node;      //!< Trie node of the container.
+        SizeType keyNode;   //!< Trie node of the member whose key came last, or kNoNode.
+        SizeType element;   //!< Index of the next array element.
+        bool isArray;
+    };
+
+    GenericPointerSet(const GenericPointerSet&);
+    GenericPointerSet& operator=(const GenericPointerSet&);
+
+    const Node& GetNode(SizeType n) const { return nodes_.template Bottom<Node>()[n]; }
+    const Ch* GetName(const Node& node) const { return names_.template Bottom<Ch>() + node.nameOffset; }
+
+    bool NameEqual(const Node& node, const Ch* name, SizeType length) const {
+        return node.nameLength == length && (length == 0 || std::memcmp(GetName(node), name, sizeof(Ch) * length) == 0);
+    }
+
+    SizeType FindChild(SizeType parent, const Ch* name, SizeType length) const {
+        for (SizeType c = GetNode(parent).firstChild; c != kNoNode; c = GetNode(c).nextSibling)
+            if (NameEqual(GetNode(c), name, length))
+                return c;
+        return kNoNode;
+    }
+
+    SizeType FindChild(SizeType parent, SizeType index) const {
+        for (SizeType c = GetNode(parent).firstChild; c != kNoNode; c = GetNode(c).nextSibling)
+            if (GetNode(c).index == index)
+                return c;
+        return kNoNode;
+    }
+
+    //! Appends a child, keeping the children in the order they were added.
+    SizeType AddChild(SizeType parent, const typename PointerType::Token& token) {
+        const SizeType n = static_cast<SizeType>(nodes_.GetSize() / sizeof(Node));
+        Node* node = nodes_.template Push<Node>();
+        node->nameOffset = names_.GetSize() / sizeof(Ch);
+        node->nameLength = token.length;
+        node->index = token.index;
+        node->firstChild = node->nextSibling = kNoNode;
+        node->target = kNoNode;
+        node->memberHint = 0;
+        if (token.length)
+            std::memcpy(names_.template Push<Ch>(token.length), token.name, sizeof(Ch) * token.length);
+
+        Node* nodes = nodes_.template Bottom<Node>();
+        SizeType* link = &nodes[parent].firstChild;
+        while (*link != kNoNode)
+            link = &nodes[*link].nextSibling;
+        *link = n;
+        return n;
+    }
+
+    //! The member of an object that node names.
+    /*! \param tryHint Whether to try the position the member was found at last time first. The
+            member there may be a later duplicate than the first one.
+    */
+    ValueType* FindMember(const Node& node, ValueType& object, bool tryHint) const {
+        typename ValueType::MemberIterator members = object.MemberBegin();
+        if (tryHint && node.memberHint < object.MemberCount()) {
+            const ValueType& name = members[node.memberHint].name;
+            if (NameEqual(node, name.GetString(), name.GetStringLength()))
+                return &members[node.memberHint].value;
+        }
+        typename ValueType::MemberIterator m = object.FindMember(GenericValue<EncodingType>(GenericStringRef<Ch>(GetName(node), node.nameLength)));
+        if (m == object.MemberEnd())
+            return 0;
+        node.memberHint = static_cast<SizeType>(m - members);
+        return &m->value;
+    }
+
+    //! Resolves the pointers at and under node n, which resolved to v.
+    size_t Resolve(SizeType n, ValueType& v, ValueType** values) const {
+        const Node& node = GetNode(n);
+        size_t resolved = 0;
+        if (node.target != kNoNode) {
+            values[node.target] = &v;
+            resolved++;
+        }
+        for (SizeType c = node.firstChild; c != kNoNode; c = GetNode(c).nextSibling) {
+            const Node& child = GetNode(c);
+            ValueType* found = 0;
+            if (v.IsObject())
+                found = FindMember(child, v, true);
+            else if (v.IsArray() && child.index != kPointerInvalidIndex && child.index < v.Size())
+                found = &v[child.index];
+            if (found)
+                resolved += Resolve(c, *found, values);
+        }
+        return resolved;
+    }
+
+    //! SAX handler for Parse(): follows the trie down the text and builds the values pointers resolve to.
+    class Resolver : public BaseReaderHandler<EncodingType, Resolver> {
+    public:
+        Resolver(const GenericPointerSet& set, ValueType* values, bool* resolved, typename ValueType::AllocatorType& allocator) :
+            set_(set), values_(values), resolved_(resolved), allocator_(allocator), frames_(set.frames_), building_(set.building_),
+            key_(), skipDepth_(), resolvedCount_(), next_(kNoNode), targetNode_(kNoNode), done_()
+        {
+            frames_.Clear();
+            building_.Clear();
+            const size_t nodeCount = set.nodes_.GetSize() / sizeof(Node);
+            set.entered_.Clear();
+            std::memset(set.entered_.template Push<bool>(nodeCount), 0, nodeCount * sizeof(bool));
+            for (size_t i = 0; i < set.pointerCount_; i++) {
+                values_[i].SetNull();
+                resolved_[i] = false;
+            }
+        }
+
+        bool Done() const { return done_; }
+
+        bool Null() { if (!Wanted()) return true; ValueType v; return Scalar(v); }
+        bool Bool(bool b) { if (!Wanted()) return true; ValueType v(b); return Scalar(v); }
+        bool Int(int i) { if (!Wanted()) return true; ValueType v(i); return Scalar(v); }
+        bool Uint(unsigned u) { if (!Wanted()) return true; ValueType v(u); return Scalar(v); }
+        bool Int64(int64_t i) { if (!Wanted()) return true; ValueType v(i); return Scalar(v); }
+        bool Uint64(uint64_t u) { if (!Wanted()) return true; ValueType v(u); return Scalar(v); }
+        bool Double(double d) { if (!Wanted()) return true; ValueType v(d); return Scalar(v); }
+        bool RawNumber(const Ch* str, SizeType length, bool copy) { return String(str, length, copy); }
+        bool String(const Ch* str, SizeType length, bool) { if (!Wanted()) return true; ValueType v(str, length, allocator_); return Scalar(v); }
+
+        bool StartObject() { return StartContainer(false); }
+        bool Key(const Ch* str, SizeType length, bool) {
+            if (!building_.Empty())
+                key_.SetString(str, length, allocator_);
+            else if (!skipDepth_)
+                frames_.template Top<Frame>()->keyNode = set_.FindChild(frames_.template Top<Frame>()->node, str, length);
+            return true;
+        }
+        bool EndObject(SizeType) { return EndContainer(); }
+        bool StartArray() { return StartContainer(true); }
+        bool EndArray(SizeType) { return EndContainer(); }
+
+    private:
+        Resolver(const Resolver&);
+        Resolver& operator=(const Resolver&);
+
+        //! Trie node of the value starting now, outside of a value being built, in next_.
+        /*! A node is entered once: the value of a member name repeated in an object is followed
+            only for the first duplicate, as GenericPointer::Get() does.
+        */
+        SizeType NextNode() {
+            SizeType n = 0;
+            if (!frames_.Empty()) {
+                Frame* frame = frames_.template Top<Frame>();
+                n = frame->isArray ? set_.FindChild(frame->node, frame->element++) : frame->keyNode;
+            }
+            if (n != kNoNode) {
+                bool* entered = set_.entered_.template Bottom<bool>() + n;
+                if (*entered)
+                    n = kNoNode;
+                *entered = true;
+            }
+            return next_ = n;
+        }
+
+        //! Whether the scalar starting now is part of a value being built or what a pointer resolves to.
+        bool Wanted() {
+            return !building_.Empty() || (!skipDepth_ && NextNode() != kNoNode && set_.GetNode(next_).target != kNoNode);
+        }
+
+        bool Scalar(ValueType& v) {
+            if (!building_.Empty()) {
+                Add(v);
+                return true;
+            }
+            values_[set_.GetNode(next_).target] = v;
+            return Resolved(next_);
+        }
+
+        bool StartContainer(bool isArray) {
+            if (!building_.Empty()) {
+                ValueType v(isArray ? kArrayType : kObjectType);
+                ValueType* added = Add(v);
+                *building_.template Push<ValueType*>() = added;
+                return true;
+            }
+            if (skipDepth_ || NextNode() == kNoNode) {
+                skipDepth_++;
+                return true;
+            }
+            const Node& node = set_.GetNode(next_);
+            if (node.target != kNoNode) {
+                // Build the whole value; pointers under it are resolved in it when it ends
+                ValueType& v = values_[node.target];
+                if (isArray)
+                    v.SetArray();
+                else
+                    v.SetObject();
+                *building_.template Push<ValueType*>() = &v;
+                targetNode_ = next_;
+                return true;
+            }
+            Frame* frame = frames_.template Push<Frame>();
+            frame->node = next_;
+            frame->keyNode = kNoNode;
+            frame->element = 0;
+            frame->isArray = isArray;
+            return true;
+        }
+
+        bool EndContainer() {
+            if (!building_.Empty()) {
+                building_.template Pop<ValueType*>(1);
+                if (building_.Empty())
+                    return Resolved(targetNode_);
+                return true;
+            }
+            if (skipDepth_)
+                skipDepth_--;
+            else
+                frames_.template Pop<Frame>(1);
+            return true;
+        }
+
+        //! Adds a value to the container being built.
+        ValueType* Add(ValueType& v) {
+            ValueType& parent = **building_.template Top<ValueType*>();
+            if (parent.IsArray()) {
+                parent.PushBack(v, allocator_);
+                return &parent[parent.Size() - 1];
+            }
+            parent.AddMember(key_, v, allocator_);
+            return &(parent.MemberEnd() - 1)->value;
+        }
+
+        //! Marks pointer target resolved, unless it already is.
+        /*! \return Whether it was not resolved before.
+        */
+        bool MarkResolved(SizeType target) {
+            if (resolved_[target])
+                return false;
+            resolved_[target] = true;
+            resolvedCount_++;
+            return true;
+        }
+
+        //! Marks the pointer at node n resolved, and the pointers under it, from the value it resolved to.
+        /*! \return false to stop parsing once every pointer is resolved.
+        */
+        bool Resolved(SizeType n) {
+            const Node& node = set_.GetNode(n);
+            MarkResolved(node.target);
+            for (SizeType c = node.firstChild; c != kNoNode; c = set_.GetNode(c).nextSibling)
+                CopyResolved(c, values_[node.target]);
+            done_ = resolvedCount_ == set_.pointerCount_;
+            return !done_;
+        }
+
+        void CopyResolved(SizeType n, ValueType& parent) {
+            const Node& node = set_.GetNode(n);
+            ValueType* found = 0;
+            if (parent.IsObject())
+                found = set_.FindMember(node, parent, false);
+            else if (parent.IsArray() && node.index != kPointerInvalidIndex && node.index < parent.Size())
+                found = &parent[node.index];
+            if (!found)
+                return;
+            if (node.target != kNoNode && MarkResolved(node.target))
+                values_[node.target].CopyFrom(*found, allocator_);
+            for (SizeType c = node.firstChild; c != kNoNode; c = set_.GetNode(c).nextSibling)
+                CopyResolved(c, *found);
+        }
+
+        const GenericPointerSet& set_;
+        ValueType* values_;
+        bool* resolved_;
+        typename ValueType::AllocatorType& allocator_;
+        internal::Stack<Allocator>& frames_;    //!< Followed containers, a Frame each.
+        internal::Stack<Allocator>& building_;  //!< Open containers of the value being built, a ValueType* each.
+        ValueType key_;                         //!< Name of the next member of the value being built.
+        size_t skipDepth_;                      //!< Depth inside a container no pointer goes into.
+        size_t resolvedCount_;
+        SizeType next_;                         //!< Trie node of the value starting now, see NextNode().
+        SizeType targetNode_;                   //!< Trie node of the value being built.
+        bool done_;
+    };
+
+    internal::Stack<Allocator> nodes_;          //!< The trie, a Node each.
+    internal::Stack<Allocator> names_;          //!< Token names of the nodes.
+    //! Kept between calls to Parse(), so that their buffers are reused.
+    mutable internal::Stack<Allocator> frames_;
+    mutable internal::Stack<Allocator> building_;
+    mutable internal::Stack<Allocator> entered_;    //!< Whether Parse() entered each node, a bool each.
+    mutable GenericReader<EncodingType, EncodingType, Allocator> reader_;
+    size_t pointerCount_;
+};
+
+//! GenericPointerSet for Value (UTF-8, default allocator).
+typedef GenericPointerSet<Value> PointerSet;
+
+RAPIDJSON_NAMESPACE_END
+
+#endif // RAPIDJSON_POINTERSET_H_
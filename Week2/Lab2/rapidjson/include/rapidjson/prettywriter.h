@@ -87,6 +87,10 @@ public:
         return *this;
     }
 
+    Ch GetIndentChar() const { return indentChar_; }
+    unsigned GetIndentCharCount() const { return indentCharCount_; }
+    PrettyFormatOptions GetFormatOptions() const { return formatOptions_; }
+
     /*! @name Implementation of Handler
         \see Handler
     */
@@ -180,6 +180,60 @@
 #define RAPIDJSON_USE_MEMBERSMAP 0 // not by default
 #endif
 
+///////////////////////////////////////////////////////////////////////////////
+// RAPIDJSON_USE_MEMBERINDEX
+
+/*! \def RAPIDJSON_USE_MEMBERINDEX
+    \ingroup RAPIDJSON_CONFIG
+    \brief Enable a hash index for looking up members of large objects
+
+    By defining this preprocessor symbol to \c 1, objects with a capacity of at least
+    \ref RAPIDJSON_MEMBERINDEX_THRESHOLD members get an open-addressing hash table at the
+    end of their members' array, allocated with it. FindMember(), HasMember() and
+    operator[] fill it on first use and then find members in constant time instead of
+    comparing every name. AddMember() keeps a filled table current; removing members or
+    growing the array leaves it to be refilled by the next lookup.
+
+    Small objects are laid out as before. Since a lookup may fill the table, concurrent
+    lookups on the same object need external synchronization. Like with
+    \ref RAPIDJSON_USE_MEMBERSMAP, member names must not be changed in place.
+    RAPIDJSON_USE_MEMBERSMAP takes precedence if both are defined.
+
+    \hideinitializer
+*/
+#ifndef RAPIDJSON_USE_MEMBERINDEX
+#define RAPIDJSON_USE_MEMBERINDEX 0 // not by default
+#endif
+
+/*! \def RAPIDJSON_MEMBERINDEX_THRESHOLD
+    \ingroup RAPIDJSON_CONFIG
+    \brief Member count from which objects are looked up through the hash index
+
+    Below it a linear scan over the names is as fast. \see RAPIDJSON_USE_MEMBERINDEX
+*/
+#ifndef RAPIDJSON_MEMBERINDEX_THRESHOLD
+#define RAPIDJSON_MEMBERINDEX_THRESHOLD 16
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// RAPIDJSON_DTOA_RYU
+
+/*! \def RAPIDJSON_DTOA_RYU
+    \ingroup RAPIDJSON_CONFIG
+    \brief Select the algorithm that Writer uses to format doubles
+
+    By default (\c 1) the digits come from Ryu (internal/ryu.h), which always finds the
+    shortest digits that read back as the same double, and the closest of those.
+    Define it to \c 0 for the original Grisu2 (internal/dtoa.h), which is slower and in
+    rare cases writes a digit more than needed. Both are laid out the same way, with the
+    same \c maxDecimalPlaces handling.
+
+    \hideinitializer
+*/
+#ifndef RAPIDJSON_DTOA_RYU
+#define RAPIDJSON_DTOA_RYU 1
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // RAPIDJSON_NO_INT64DEFINE
 
@@ -384,6 +438,27 @@
 #define RAPIDJSON_SIMD
 #endif
 
+/*! \def RAPIDJSON_SIMD_DISPATCH
+    \ingroup RAPIDJSON_CONFIG
+    \brief Pick SSE2/AVX2/AVX-512 kernels at runtime.
+
+    The RAPIDJSON_SSE2/RAPIDJSON_SSE42 kernels are selected at compile time, so a
+    generic x86-64 build gets none of them. With this option (the default on x86-64
+    GCC, Clang and MSVC when none of those symbols is defined) whitespace skipping
+    and the unescaped-string scan/copy of GenericReader use the widest instruction set
+    the CPU reports through CPUID. Define it to 0 to keep the scalar code.
+
+    \see SetSimdLevel()
+*/
+#ifndef RAPIDJSON_SIMD_DISPATCH
+#if !defined(RAPIDJSON_SIMD) && (defined(__x86_64__) || defined(_M_X64)) \
+    && (defined(__GNUC__) || defined(_MSC_VER))
+#define RAPIDJSON_SIMD_DISPATCH 1
+#else
+#define RAPIDJSON_SIMD_DISPATCH 0
+#endif
+#endif // RAPIDJSON_SIMD_DISPATCH
+
 ///////////////////////////////////////////////////////////////////////////////
 // RAPIDJSON_NO_SIZETYPEDEFINE
 
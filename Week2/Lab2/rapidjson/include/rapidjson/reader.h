@@ -24,6 +24,7 @@
 #include "internal/meta.h"
 #include "internal/stack.h"
 #include "internal/strtod.h"
+#include "internal/simd.h"
 #include <limits>
 
 #if defined(RAPIDJSON_SIMD) && defined(_MSC_VER)
@@ -260,7 +261,8 @@ private:
 
 //! Skip the JSON white spaces in a stream.
 /*! \param is A input stream for skipping white spaces.
-    \note This function has SSE2/SSE4.2 specialization.
+    \note This function has SSE2/SSE4.2 specialization, or runtime-dispatched
+    SSE2/AVX2/AVX-512 ones with RAPIDJSON_SIMD_DISPATCH.
 */
 template<typename InputStream>
 void SkipWhitespace(InputStream& is) {
@@ -514,6 +516,24 @@ template<> inline void SkipWhitespace(StringStream& is) {
 template<> inline void SkipWhitespace(EncodedInputStream<UTF8<>, MemoryStream>& is) {
     is.is_.src_ = SkipWhitespace_SIMD(is.is_.src_, is.is_.end_);
 }
+#elif RAPIDJSON_SIMD_DISPATCH
+//! Template function specialization for InsituStringStream
+template<> inline void SkipWhitespace(InsituStringStream& is) {
+    // Most calls land on a token already, so test one char before paying for the indirect call
+    if (internal::IsJsonWhitespace(*is.src_))
+        is.src_ = const_cast<char*>(internal::ActiveSimdKernels().skipWhitespace(is.src_ + 1));
+}
+
+//! Template function specialization for StringStream
+template<> inline void SkipWhitespace(StringStream& is) {
+    if (internal::IsJsonWhitespace(*is.src_))
+        is.src_ = internal::ActiveSimdKernels().skipWhitespace(is.src_ + 1);
+}
+
+template<> inline void SkipWhitespace(EncodedInputStream<UTF8<>, MemoryStream>& is) {
+    if (is.is_.src_ != is.is_.end_ && internal::IsJsonWhitespace(*is.is_.src_))
+        is.is_.src_ = internal::ActiveSimdKernels().skipWhitespaceBounded(is.is_.src_ + 1, is.is_.end_);
+}
 #endif // RAPIDJSON_SIMD
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1402,8 +1422,105 @@ private:
 
         is.src_ = is.dst_ = p;
     }
+#elif RAPIDJSON_SIMD_DISPATCH
+    // Scan for the first '"', '\\' or control char with the runtime-selected kernel, then copy in one go
+    // StringStream -> StackStream<char>
+    static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(StringStream& is, StackStream<char>& os) {
+        const char* p = is.src_;
+        const char* q = internal::ActiveSimdKernels().scanUnescaped(p);
+        SizeType length = static_cast<SizeType>(q - p);
+        if (length != 0)
+            std::memcpy(os.Push(length), p, length);
+        is.src_ = q;
+    }
+
+    // MemoryStream (Parse with a length) -> StackStream<char>
+    static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(EncodedInputStream<UTF8<>, MemoryStream>& is, StackStream<char>& os) {
+        const char* p = is.is_.src_;
+        const char* q = internal::ActiveSimdKernels().scanUnescapedBounded(p, is.is_.end_);
+        SizeType length = static_cast<SizeType>(q - p);
+        if (length != 0)
+            std::memcpy(os.Push(length), p, length);
+        is.is_.src_ = q;
+    }
+
+    // InsituStringStream -> InsituStringStream
+    static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(InsituStringStream& is, InsituStringStream& os) {
+        RAPIDJSON_ASSERT(&is == &os);
+        (void)os;
+
+        char* p = is.src_;
+        size_t length = static_cast<size_t>(internal::ActiveSimdKernels().scanUnescaped(p) - p);
+        if (is.dst_ != p)   // an earlier escape shrank the string, so the tail moves down
+            std::memmove(is.dst_, p, length);
+        is.src_ = p + length;
+        is.dst_ += length;
+    }
 #endif // RAPIDJSON_NEON
 
+    // Eight digits at a time (SWAR) for ParseNumber, from streams that keep their characters in
+    // memory. Returns the taken characters, or 0 (taking nothing) unless the next eight are digits.
+    template<typename InputStream>
+    static RAPIDJSON_FORCEINLINE const char* TakeEightDigits(InputStream&, uint32_t*) { return 0; }
+
+#if RAPIDJSON_ENDIAN == RAPIDJSON_LITTLEENDIAN
+    static RAPIDJSON_FORCEINLINE bool IsEightDigits(uint64_t chars) {
+        // '0'..'9' are 0x30..0x39: every high nibble is 3, and adding 6 leaves it 3
+        return ((chars & RAPIDJSON_UINT64_C2(0xF0F0F0F0, 0xF0F0F0F0)) |
+            (((chars + RAPIDJSON_UINT64_C2(0x06060606, 0x06060606)) & RAPIDJSON_UINT64_C2(0xF0F0F0F0, 0xF0F0F0F0)) >> 4)) ==
+            RAPIDJSON_UINT64_C2(0x33333333, 0x33333333);
+    }
+
+    static RAPIDJSON_FORCEINLINE uint32_t EightDigitsValue(uint64_t chars) {
+        // Combine neighbouring digits, then pairs of those, with the first character the most significant
+        chars -= RAPIDJSON_UINT64_C2(0x30303030, 0x30303030);
+        chars = chars * 10 + (chars >> 8);
+        const uint64_t mask = RAPIDJSON_UINT64_C2(0x000000FF, 0x000000FF);
+        return static_cast<uint32_t>(((chars & mask) * RAPIDJSON_UINT64_C2(0x000F4240, 0x00000064) +  // 1000000, 100
+            ((chars >> 16) & mask) * RAPIDJSON_UINT64_C2(0x00002710, 0x00000001)) >> 32);             // 10000, 1
+    }
+
+    // A string stream ends at its '\0', which may come before the eighth character: check the
+    // characters one by one so as not to read past it, then combine them at once.
+    template<typename Ch>
+    static RAPIDJSON_FORCEINLINE const char* TakeEightDigitsTerminated(Ch*& src, uint32_t* value) {
+        const char* p = src;
+        for (int k = 0; k < 8; k++)
+            if (p[k] < '0' || p[k] > '9')
+                return 0;
+        uint64_t chars;
+        std::memcpy(&chars, p, sizeof(chars));
+        *value = EightDigitsValue(chars);
+        src += 8;
+        return p;
+    }
+
+    static RAPIDJSON_FORCEINLINE const char* TakeEightDigits(StringStream& is, uint32_t* value) {
+        return TakeEightDigitsTerminated(is.src_, value);
+    }
+
+    static RAPIDJSON_FORCEINLINE const char* TakeEightDigits(InsituStringStream& is, uint32_t* value) {
+        return TakeEightDigitsTerminated(is.src_, value);
+    }
+
+    static RAPIDJSON_FORCEINLINE const char* TakeEightDigits(MemoryStream& is, uint32_t* value) {
+        const char* p = is.src_;
+        if (is.end_ - p < 8)
+            return 0;
+        uint64_t chars;
+        std::memcpy(&chars, p, sizeof(chars));
+        if (!IsEightDigits(chars))
+            return 0;
+        *value = EightDigitsValue(chars);
+        is.src_ += 8;
+        return p;
+    }
+
+    static RAPIDJSON_FORCEINLINE const char* TakeEightDigits(EncodedInputStream<UTF8<>, MemoryStream>& is, uint32_t* value) {
+        return TakeEightDigits(is.is_, value);
+    }
+#endif // RAPIDJSON_ENDIAN == RAPIDJSON_LITTLEENDIAN
+
     template<typename InputStream, typename StackCharacter, bool backup, bool pushOnTake>
     class NumberStream;
 
@@ -1418,6 +1535,7 @@ private:
         RAPIDJSON_FORCEINLINE Ch TakePush() { return is.Take(); }
         RAPIDJSON_FORCEINLINE Ch Take() { return is.Take(); }
         RAPIDJSON_FORCEINLINE void Push(char) {}
+        RAPIDJSON_FORCEINLINE bool TakeEightDigits(uint32_t* value) { return GenericReader::TakeEightDigits(is, value) != 0; }
 
         size_t Tell() { return is.Tell(); }
         size_t Length() { return 0; }
@@ -1444,6 +1562,15 @@ private:
             stackStream.Put(c);
         }
 
+        RAPIDJSON_FORCEINLINE bool TakeEightDigits(uint32_t* value) {
+            const char* digits = GenericReader::TakeEightDigits(Base::is, value);
+            if (!digits)
+                return false;
+            for (int k = 0; k < 8; k++)
+                stackStream.Put(static_cast<StackCharacter>(digits[k]));
+            return true;
+        }
+
         size_t Length() { return stackStream.Length(); }
 
         const StackCharacter* Pop() {
@@ -1549,34 +1676,38 @@ private:
 
         // Parse 64bit int
         bool useDouble = false;
+        uint32_t eightDigits;
         if (use64bit) {
-            if (minus)
-                while (RAPIDJSON_LIKELY(s.Peek() >= '0' && s.Peek() <= '9')) {
-                     if (RAPIDJSON_UNLIKELY(i64 >= RAPIDJSON_UINT64_C2(0x0CCCCCCC, 0xCCCCCCCC))) // 2^63 = 9223372036854775808
-                        if (RAPIDJSON_LIKELY(i64 != RAPIDJSON_UINT64_C2(0x0CCCCCCC, 0xCCCCCCCC) || s.Peek() > '8')) {
-                            d = static_cast<double>(i64);
-                            useDouble = true;
-                            break;
-                        }
-                    i64 = i64 * 10 + static_cast<unsigned>(s.TakePush() - '0');
-                    significandDigit++;
-                }
-            else
-                while (RAPIDJSON_LIKELY(s.Peek() >= '0' && s.Peek() <= '9')) {
-                    if (RAPIDJSON_UNLIKELY(i64 >= RAPIDJSON_UINT64_C2(0x19999999, 0x99999999))) // 2^64 - 1 = 18446744073709551615
-                        if (RAPIDJSON_LIKELY(i64 != RAPIDJSON_UINT64_C2(0x19999999, 0x99999999) || s.Peek() > '5')) {
-                            d = static_cast<double>(i64);
-                            useDouble = true;
-                            break;
-                        }
-                    i64 = i64 * 10 + static_cast<unsigned>(s.TakePush() - '0');
-                    significandDigit++;
-                }
+            while (i64 < RAPIDJSON_UINT64_C2(0x00000002, 0x540BE400) && s.TakeEightDigits(&eightDigits)) { // 10^10 * 10^8 < 2^63
+                i64 = i64 * 100000000 + eightDigits;
+                significandDigit += 8;
+            }
+            // Negative numbers too fill all 64 bits, so that the significand of a double stays exact
+            while (RAPIDJSON_LIKELY(s.Peek() >= '0' && s.Peek() <= '9')) {
+                if (RAPIDJSON_UNLIKELY(i64 >= RAPIDJSON_UINT64_C2(0x19999999, 0x99999999))) // 2^64 - 1 = 18446744073709551615
+                    if (RAPIDJSON_LIKELY(i64 != RAPIDJSON_UINT64_C2(0x19999999, 0x99999999) || s.Peek() > '5')) {
+                        d = static_cast<double>(i64);
+                        useDouble = true;
+                        break;
+                    }
+                i64 = i64 * 10 + static_cast<unsigned>(s.TakePush() - '0');
+                significandDigit++;
+            }
+            if (minus && !useDouble && i64 > RAPIDJSON_UINT64_C2(0x80000000, 0x00000000)) { // below -2^63 = -9223372036854775808
+                d = static_cast<double>(i64);
+                useDouble = true;
+            }
         }
 
         // Force double for big integer
+        // i64 * 10^droppedDigits keeps the number for StrtodEiselLemire as long as what is dropped is zeros
+        bool exactSignificand = true;
+        int droppedDigits = 0;
         if (useDouble) {
             while (RAPIDJSON_LIKELY(s.Peek() >= '0' && s.Peek() <= '9')) {
+                if (s.Peek() != '0')
+                    exactSignificand = false;
+                droppedDigits++;
                 d = d * 10 + (s.TakePush() - '0');
             }
         }
@@ -1596,21 +1727,29 @@ private:
                 if (!use64bit)
                     i64 = i;
 
+                while (i64 < RAPIDJSON_UINT64_C2(0x00000017, 0x4876E800) && s.TakeEightDigits(&eightDigits)) { // 10^11 * 10^8 < 2^64
+                    i64 = i64 * 100000000 + eightDigits;
+                    expFrac -= 8;
+                }
                 while (RAPIDJSON_LIKELY(s.Peek() >= '0' && s.Peek() <= '9')) {
-                    if (i64 > RAPIDJSON_UINT64_C2(0x1FFFFF, 0xFFFFFFFF)) // 2^53 - 1 for fast path
+                    if (i64 > RAPIDJSON_UINT64_C2(0x19999999, 0x99999998)) // i64 * 10 + 9 would not fit
                         break;
                     else {
                         i64 = i64 * 10 + static_cast<unsigned>(s.TakePush() - '0');
                         --expFrac;
-                        if (i64 != 0)
-                            significandDigit++;
                     }
                 }
 
+                // Digits past a 64-bit significand only decide rounding; StrtodFullPrecision() reads them from the stack
+                while (RAPIDJSON_LIKELY(s.Peek() >= '0' && s.Peek() <= '9'))
+                    if (s.TakePush() != '0')
+                        exactSignificand = false;
+
                 d = static_cast<double>(i64);
 #else
                 // Use double to store significand in 32-bit architecture
                 d = static_cast<double>(use64bit ? i64 : i);
+                exactSignificand = false;
 #endif
                 useDouble = true;
             }
@@ -1622,8 +1761,8 @@ private:
                     if (RAPIDJSON_LIKELY(d > 0.0))
                         significandDigit++;
                 }
-                else
-                    s.TakePush();
+                else if (s.TakePush() != '0')
+                    exactSignificand = false;
             }
         }
         else
@@ -1633,7 +1772,9 @@ private:
         int exp = 0;
         if (Consume(s, 'e') || Consume(s, 'E')) {
             if (!useDouble) {
-                d = static_cast<double>(use64bit ? i64 : i);
+                if (!use64bit)
+                    i64 = i;
+                d = static_cast<double>(i64);
                 useDouble = true;
             }
 
@@ -1711,7 +1852,10 @@ private:
 
            if (useDouble) {
                int p = exp + expFrac;
-               if (parseFlags & kParseFullPrecisionFlag)
+               double exact;
+               if (exactSignificand && internal::StrtodEiselLemire(i64, p + droppedDigits, &exact))
+                   d = exact;
+               else if (parseFlags & kParseFullPrecisionFlag)
                    d = internal::StrtodFullPrecision(d, p, decimal, length, decimalPosition, exp);
                else
                    d = internal::StrtodNormalPrecision(d, p);
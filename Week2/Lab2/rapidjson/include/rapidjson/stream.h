@@ -100,6 +100,14 @@ inline void PutN(Stream& stream, Ch c, size_t n) {
         PutUnsafe(stream, c);
 }
 
+//! Put n characters from a buffer to a stream.
+template<typename Stream>
+inline void PutCopy(Stream& stream, const typename Stream::Ch* s, size_t n) {
+    PutReserve(stream, n);
+    for (size_t i = 0; i < n; i++)
+        PutUnsafe(stream, s[i]);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // GenericStreamWrapper
 
@@ -112,6 +112,13 @@ inline void PutN(GenericStringBuffer<UTF8<> >& stream, char c, size_t n) {
     std::memset(stream.stack_.Push<char>(n), c, n * sizeof(c));
 }
 
+//! Implement specialized version of PutCopy() with memcpy() for better performance.
+template<typename Encoding, typename Allocator>
+inline void PutCopy(GenericStringBuffer<Encoding, Allocator>& stream, const typename Encoding::Ch* s, size_t n) {
+    if (n != 0)
+        std::memcpy(stream.Push(n), s, n * sizeof(*s));
+}
+
 RAPIDJSON_NAMESPACE_END
 
 #if defined(__clang__)
@@ -145,6 +145,11 @@ public:
         return hasRoot_ && level_stack_.Empty();
     }
 
+    //! Number of arrays and objects currently open.
+    size_t GetNestingLevel() const {
+        return level_stack_.GetSize() / sizeof(Level);
+    }
+
     int GetMaxDecimalPlaces() const {
         return maxDecimalPlaces_;
     }
@@ -275,6 +280,27 @@ public:
         return EndValue(WriteRawValue(json, length));
     }
 
+    //! Append values already rendered for the innermost open array or object.
+    /*!
+        Used to splice output produced elsewhere (e.g. by another writer on another thread,
+        see WriteArrayParallel()) into this writer. Unlike RawValue(), nothing is written in
+        front of \c json: it must hold \c count values exactly as this writer would have
+        written them at this point, including the separator and indentation before each one.
+
+        \param json Text in the target encoding. It is copied as-is, without validation.
+        \param length Length of the json.
+        \param count Number of values in the json. An object member counts as two (name and value).
+    */
+    bool RawValues(const typename OutputStream::Ch* json, size_t length, size_t count) {
+        RAPIDJSON_ASSERT(json != 0 || length == 0);
+        RAPIDJSON_ASSERT(level_stack_.GetSize() != 0);
+        Level* level = level_stack_.template Top<Level>();
+        RAPIDJSON_ASSERT(level->inArray || count % 2 == 0);
+        level->valueCount += count;
+        PutCopy(*os_, json, length);
+        return true;
+    }
+
     //! Flush the output stream.
     /*!
         Allows the user to flush the output stream immediately.